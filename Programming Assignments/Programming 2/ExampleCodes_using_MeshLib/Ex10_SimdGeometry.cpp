@@ -0,0 +1,131 @@
+#include "Mesh.h"
+#include "SimdGeometry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+//Compare the SimdGeometry kernels, in double and in float, with the same computation written with Point:
+//face normals, areas, corner angles and edge lengths of every triangle, in ns per face, and the largest
+//difference of the SIMD results from the Point ones. Build with -O2 -mavx2 (or -march=native) for the
+//AVX2 kernels; the first line tells which ones run.
+//Usage: Ex10_SimdGeometry mesh1.obj [mesh2.obj ...], e.g. a large mesh written by Ex5_ParseBenchmark -synthetic
+
+template <class T>
+struct Outputs
+{
+	std::vector<T>					buffer;
+	SimdGeometry::Triangles<T>		triangles;
+
+	explicit Outputs(size_t numFaces) : buffer(10 * numFaces)
+	{
+		triangles.area = &buffer[0];
+		for (int k = 0; k < 3; ++k) {
+			triangles.normal[k] = &buffer[(1 + k) * numFaces];
+			triangles.angle[k] = &buffer[(4 + k) * numFaces];
+			triangles.length[k] = &buffer[(7 + k) * numFaces];
+		}
+	}
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the scalar reference, one face at a time with Point
+static void pointKernel(const std::vector<Point> & points, const std::vector<int> & faceInds, Outputs<double> & out)
+{
+	const SimdGeometry::Triangles<double> & t = out.triangles;
+	for (size_t f = 0; f < faceInds.size() / 3; ++f) {
+		Point p[3] = { points[faceInds[3 * f]], points[faceInds[3 * f + 1]], points[faceInds[3 * f + 2]] };
+		Point e[3] = { p[1] - p[0], p[2] - p[1], p[0] - p[2] };
+		Point n = e[0] ^ e[1];
+		double length = n.norm();
+		t.area[f] = length / 2;
+		if (length > 0) n /= length;
+		for (int j = 0; j < 3; ++j) {
+			Point a = e[j], b = e[(j + 2) % 3] * -1;
+			t.normal[j][f] = n[j];
+			t.angle[j][f] = acos(std::max(-1.0, std::min(1.0, (a * b) / (a.norm() * b.norm()))));
+			t.length[j][f] = e[j].norm();
+		}
+	}
+}
+
+//the largest difference in each group of outputs: normal, area (relative), angle, length (relative)
+template <class T>
+static void differences(const Outputs<double> & reference, const Outputs<T> & out, size_t numFaces, double d[4])
+{
+	const int groups[10] = { 1, 0, 0, 0, 2, 2, 2, 3, 3, 3 };
+	for (int g = 0; g < 4; ++g) d[g] = 0;
+	for (int a = 0; a < 10; ++a)
+		for (size_t f = 0; f < numFaces; ++f) {
+			double r = reference.buffer[a * numFaces + f], v = out.buffer[a * numFaces + f];
+			double diff = fabs(v - r);
+			if (groups[a] == 1 || groups[a] == 3) diff /= std::max(fabs(r), 1e-300);
+			d[groups[a]] = std::max(d[groups[a]], diff);
+		}
+}
+
+int main(int argc, char ** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: Ex10_SimdGeometry mesh1.obj [mesh2.obj ...]\n";
+		return 1;
+	}
+	printf("SimdGeometry: %s, %d doubles or %d floats per block\n", SimdGeometry::instructionSet(),
+		SimdGeometry::blockSize<double>(), SimdGeometry::blockSize<float>());
+
+	for (int i = 1; i < argc; ++i) {
+		std::vector<double> coords;
+		std::vector<int> faceInds;
+		if (!Mesh::parseOBJFile(argv[i], coords, faceInds)) {
+			std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+			continue;
+		}
+		const size_t nv = coords.size() / 3, nf = faceInds.size() / 3;
+		std::vector<Point> points(nv);
+		std::vector<double> x(nv), y(nv), z(nv);
+		std::vector<float> xf(nv), yf(nv), zf(nv);
+		for (size_t v = 0; v < nv; ++v) {
+			points[v] = Point(coords[3 * v], coords[3 * v + 1], coords[3 * v + 2]);
+			x[v] = coords[3 * v];
+			y[v] = coords[3 * v + 1];
+			z[v] = coords[3 * v + 2];
+			xf[v] = (float)x[v];
+			yf[v] = (float)y[v];
+			zf[v] = (float)z[v];
+		}
+
+		const int repeats = 5;
+		Outputs<double> reference(nf), simdDouble(nf);
+		Outputs<float> simdFloat(nf);
+		double seconds[3] = { HUGE_VAL, HUGE_VAL, HUGE_VAL };
+		for (int r = 0; r < repeats; ++r) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			pointKernel(points, faceInds, reference);
+			seconds[0] = std::min(seconds[0], secondsSince(start));
+			start = std::chrono::steady_clock::now();
+			SimdGeometry::computeTriangles(&x[0], &y[0], &z[0], &faceInds[0], 0, nf, simdDouble.triangles);
+			seconds[1] = std::min(seconds[1], secondsSince(start));
+			start = std::chrono::steady_clock::now();
+			SimdGeometry::computeTriangles(&xf[0], &yf[0], &zf[0], &faceInds[0], 0, nf, simdFloat.triangles);
+			seconds[2] = std::min(seconds[2], secondsSince(start));
+		}
+
+		printf("%s: %d vertices, %d faces\n", argv[i], (int)nv, (int)nf);
+		printf("  %-14s %10s %8s %12s %12s %12s %12s\n", "kernel", "ns/face", "speedup", "normal", "area (rel)",
+			"angle", "length (rel)");
+		printf("  %-14s %10.2f %8.2f\n", "Point", seconds[0] * 1e9 / nf, 1.0);
+		double d[4];
+		differences(reference, simdDouble, nf, d);
+		printf("  %-14s %10.2f %8.2f %12.3g %12.3g %12.3g %12.3g\n", "SIMD double", seconds[1] * 1e9 / nf,
+			seconds[0] / seconds[1], d[0], d[1], d[2], d[3]);
+		differences(reference, simdFloat, nf, d);
+		printf("  %-14s %10.2f %8.2f %12.3g %12.3g %12.3g %12.3g\n", "SIMD float", seconds[2] * 1e9 / nf,
+			seconds[0] / seconds[2], d[0], d[1], d[2], d[3]);
+	}
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include "Mesh.h"
+#include "Iterators.h"
+#include "MeshGeometry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+//Report the memory and the MeshGeometry timings of a mesh in the precision MeshLib is built for. Build it
+//twice, once as is and once with -DMESHLIB_FLOAT_GEOMETRY for the library and the program, and compare
+//the two reports: the bytes per face of the mesh alone and with the attributes MeshGeometry fills, the
+//time to read the mesh and to compute its geometry, and the total Gaussian curvature with its largest
+//difference from a computation in double, to see what float costs in accuracy.
+//Usage: Ex11_FloatGeometry mesh1.obj [mesh2.obj ...], e.g. with the meshes in OBJMeshes/
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the largest difference of the Gaussian curvature from the one computed in double from the positions
+static double curvatureError(Mesh & mesh)
+{
+	const double pi = 3.14159265358979323846;
+	AttributeArray<MeshScalar> & curvature = mesh.vertexAttributes().add<MeshScalar>("gaussianCurvature");
+	AttributeArray<double> & reference = mesh.vertexAttributes().add<double>("doubleCurvature");
+	reference.fill(2 * pi);
+	for (MeshHalfedgeIterator heit(&mesh); !heit.end(); ++heit) {
+		Halfedge * he = *heit;
+		Point u = Point(he->target()->point()) - Point(he->source()->point());
+		Point v = Point(he->prev()->source()->point()) - Point(he->source()->point());
+		reference[he->source()] -= atan2((u ^ v).norm(), u * v);
+	}
+	double error = 0;
+	for (MeshVertexIterator vit(&mesh); !vit.end(); ++vit)
+		error = std::max(error, fabs(curvature[*vit] - reference[*vit]));
+	mesh.vertexAttributes().remove("doubleCurvature");
+	return error;
+}
+
+int main(int argc, char ** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: Ex11_FloatGeometry mesh1.obj [mesh2.obj ...]\n";
+		return 1;
+	}
+	printf("geometry in %s: sizeof(Vertex) %d, sizeof(MeshPoint) %d\n", sizeof(MeshScalar) == 4 ? "float" : "double",
+		(int)sizeof(Vertex), (int)sizeof(MeshPoint));
+	printf("%-24s %10s %12s %12s %10s %12s %16s %12s\n", "mesh", "#faces", "B/face", "+geometry", "read ms",
+		"geometry ms", "total curvature", "max error");
+
+	for (int i = 1; i < argc; ++i) {
+		Mesh mesh;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!mesh.readOBJFile(argv[i])) {
+			std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+			continue;
+		}
+		double readSeconds = secondsSince(start);
+		double nf = mesh.numFaces() > 0 ? mesh.numFaces() : 1;
+		double meshBytes = (double)mesh.memoryUsage();
+
+		const int repeats = 5;
+		MeshGeometry geometry;
+		double seconds = HUGE_VAL;
+		for (int r = 0; r < repeats; ++r) {
+			start = std::chrono::steady_clock::now();
+			geometry.compute(mesh);
+			seconds = std::min(seconds, secondsSince(start));
+		}
+		double geometryBytes = (double)mesh.memoryUsage();
+
+		AttributeArray<MeshScalar> & curvature = mesh.vertexAttributes().add<MeshScalar>("gaussianCurvature");
+		double total = 0;
+		for (MeshVertexIterator vit(&mesh); !vit.end(); ++vit)
+			total += curvature[*vit];
+		printf("%-24s %10d %12.1f %12.1f %10.2f %12.3f %16.9f %12.3g\n", argv[i], mesh.numFaces(), meshBytes / nf,
+			geometryBytes / nf, readSeconds * 1e3, seconds * 1e3, total, curvatureError(mesh));
+	}
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include "Mesh.h"
+#include "MeshGeometry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//Time MeshGeometry::update() after moving 1, 10, 100, ... random vertices of a mesh along their normal
+//against a full MeshGeometry::compute(), and check that the updated normals, angles and curvature are those
+//the full computation gives, also across a Mesh::reorder(). "-moves N" sets the largest number of moved
+//vertices (default 10000).
+//Usage: Ex12_IncrementalGeometry [-moves N] mesh1.obj [mesh2.obj ...]
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the largest difference between two attribute arrays of the same size
+static double difference(const AttributeArray<MeshScalar> & a, const std::vector<MeshScalar> & b)
+{
+	double d = 0;
+	for (size_t i = 0; i < b.size(); ++i)
+		d = std::max(d, (double)fabs(a[(int)i] - b[i]));
+	return d;
+}
+
+static double difference(const AttributeArray<MeshPoint> & a, const std::vector<MeshPoint> & b)
+{
+	double d = 0;
+	for (size_t i = 0; i < b.size(); ++i)
+		d = std::max(d, (double)(a[(int)i] - b[i]).norm());
+	return d;
+}
+
+//move the given number of random vertices along their normal, update the geometry, and print the time
+//against a full computation and the largest differences of the updated quantities from those it gives
+static void moveAndUpdate(Mesh & mesh, MeshGeometry & geometry, int moves, std::mt19937 & random, const char * note)
+{
+	AttributeArray<MeshScalar> & angles = mesh.halfedgeAttributes().add<MeshScalar>("angle");
+	AttributeArray<MeshPoint> & vertexNormals = mesh.vertexAttributes().add<MeshPoint>("normal");
+	AttributeArray<MeshScalar> & curvature = mesh.vertexAttributes().add<MeshScalar>("gaussianCurvature");
+	std::uniform_int_distribution<int> pick(0, mesh.numVertices() - 1);
+	for (int m = 0; m < moves; ++m) {
+		Vertex * v = mesh.indVertex(pick(random));
+		mesh.setPoint(v, v->point() + vertexNormals[v] * (MeshScalar)1e-3);
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool incremental = geometry.update(mesh);
+	double updateSeconds = secondsSince(start);
+	size_t faces = incremental ? geometry.updatedFaces().size() : (size_t)mesh.numFaces();
+
+	//the full computation over the same positions, to compare with
+	std::vector<MeshScalar> updatedAngles(angles.data(), angles.data() + angles.size());
+	std::vector<MeshPoint> updatedNormals(vertexNormals.data(), vertexNormals.data() + vertexNormals.size());
+	std::vector<MeshScalar> updatedCurvature(curvature.data(), curvature.data() + curvature.size());
+	start = std::chrono::steady_clock::now();
+	geometry.compute(mesh);
+	double computeSeconds = secondsSince(start);
+	printf("  %8d %10d %12.4f %12.3f %9.0fx %12.3g %12.3g %12.3g%s%s\n", moves, (int)faces, updateSeconds * 1e3,
+		computeSeconds * 1e3, computeSeconds / updateSeconds, difference(vertexNormals, updatedNormals),
+		difference(angles, updatedAngles), difference(curvature, updatedCurvature),
+		incremental ? "" : "  (full)", note);
+}
+
+int main(int argc, char ** argv) {
+	int maxMoves = 10000;
+	int first = 1;
+	for (; first < argc && argv[first][0] == '-'; ++first)
+		if (!strcmp(argv[first], "-moves") && first + 1 < argc)
+			maxMoves = atoi(argv[++first]);
+	if (first >= argc) {
+		std::cerr << "Usage: Ex12_IncrementalGeometry [-moves N] mesh1.obj [mesh2.obj ...]\n";
+		return 1;
+	}
+
+	for (int i = first; i < argc; ++i) {
+		Mesh mesh;
+		if (!mesh.readOBJFile(argv[i])) {
+			std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+			continue;
+		}
+		MeshGeometry geometry;
+		geometry.compute(mesh);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		geometry.update(mesh);		//nothing moved yet: lists the corners of the vertices, once
+		double listSeconds = secondsSince(start);
+
+		printf("%s: %d vertices, %d faces, corners listed in %.3f ms\n", argv[i], mesh.numVertices(), mesh.numFaces(),
+			listSeconds * 1e3);
+		printf("  %8s %10s %12s %12s %10s %12s %12s %12s\n", "moved", "faces", "update ms", "compute ms", "speedup",
+			"normal diff", "angle diff", "curv. diff");
+		std::mt19937 random(1);
+		for (int moves = 1; moves <= maxMoves && moves <= mesh.numVertices(); moves *= 10)
+			moveAndUpdate(mesh, geometry, moves, random, "");
+
+		//after Mesh::reorder() the corner lists and the coloring are those of the old indices
+		//and the update goes over all faces, then lists the corners again for the next one
+		mesh.reorder(MeshOrdering::Morton);
+		moveAndUpdate(mesh, geometry, std::min(100, mesh.numVertices()), random, "  after reorder");
+		moveAndUpdate(mesh, geometry, std::min(100, mesh.numVertices()), random, "  next update");
+	}
+	return 0;
+}
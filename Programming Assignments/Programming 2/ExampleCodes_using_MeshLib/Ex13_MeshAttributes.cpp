@@ -0,0 +1,91 @@
+#include "Mesh.h"
+#include "MeshAttributes.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+//Show when MeshAttributes computes: the time of a request for the vertex normals of a mesh the first
+//time, again with nothing changed, after moving 100 vertices with Mesh::setPoint() (twice), after moving
+//them in place (Mesh::geometryChanged()), and after Mesh::reorder(); then the bounding box, and the
+//curvature asked for by a second user of the same mesh: left out of the normals until then, it comes from the
+//angles stored with them, and after 100 more vertices moved, along with the normals around them.
+//Usage: Ex13_MeshAttributes mesh1.obj [mesh2.obj ...]
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the time of a request for the vertex normals, and the sum of their x coordinates
+static void request(const char * what, Mesh & mesh)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	AttributeArray<MeshPoint> & normals = mesh.derived().vertexNormals();
+	double seconds = secondsSince(start);
+	double sum = 0;
+	for (int i = 0; i < mesh.numVertices(); ++i)
+		sum += normals[i][0];
+	printf("  %-32s %10.4f ms   geometry revision %llu   sum %.6f\n", what, seconds * 1e3, mesh.geometryRevision(), sum);
+}
+
+int main(int argc, char ** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: Ex13_MeshAttributes mesh1.obj [mesh2.obj ...]\n";
+		return 1;
+	}
+	for (int i = 1; i < argc; ++i) {
+		Mesh mesh;
+		if (!mesh.readOBJFile(argv[i])) {
+			std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+			continue;
+		}
+		printf("%s: %d vertices, %d faces\n", argv[i], mesh.numVertices(), mesh.numFaces());
+		request("first request", mesh);
+		request("nothing changed", mesh);
+
+		//the first update lists the corners of the vertices for the next ones
+		const int moves = std::min(100, mesh.numVertices());
+		for (int round = 0; round < 2; ++round) {
+			AttributeArray<MeshPoint> & normals = mesh.derived().vertexNormals();
+			for (int m = 0; m < moves; ++m) {
+				Vertex * v = mesh.indVertex(((int)((long long)m * mesh.numVertices() / moves) + round) % mesh.numVertices());
+				mesh.setPoint(v, v->point() + normals[v] * (MeshScalar)1e-3);
+			}
+			request(round == 0 ? "100 vertices moved, marked" : "100 more moved, marked", mesh);
+		}
+		for (int m = 0; m < moves; ++m) {
+			Vertex * v = mesh.indVertex((int)((long long)m * mesh.numVertices() / moves));
+			v->point() = v->point() * (MeshScalar)1.5;
+		}
+		mesh.geometryChanged();
+		request("moved in place, not marked", mesh);
+		mesh.reorder(MeshOrdering::Hilbert);
+		request("reordered", mesh);
+
+		Point min, max;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		mesh.derived().boundingBox(min, max);
+		printf("  %-32s %10.4f ms   (%g %g %g) - (%g %g %g)\n", "bounding box", secondsSince(start) * 1e3,
+			min[0], min[1], min[2], max[0], max[1], max[2]);
+		for (int round = 0; round < 2; ++round) {
+			if (round == 1) {
+				AttributeArray<MeshPoint> & normals = mesh.derived().vertexNormals();
+				for (int m = 0; m < moves; ++m) {
+					Vertex * v = mesh.indVertex((int)((long long)m * mesh.numVertices() / moves));
+					mesh.setPoint(v, v->point() - normals[v] * (MeshScalar)1e-3);
+				}
+			}
+			start = std::chrono::steady_clock::now();
+			AttributeArray<MeshScalar> & curvature = mesh.derived().gaussianCurvature();
+			double seconds = secondsSince(start);
+			double total = 0;
+			for (int v = 0; v < mesh.numVertices(); ++v)
+				total += curvature[v];
+			printf("  %-32s %10.4f ms   total curvature %.9f\n",
+				round == 0 ? "curvature, by another user" : "curvature, 100 more moved", seconds * 1e3, total);
+		}
+	}
+	return 0;
+}
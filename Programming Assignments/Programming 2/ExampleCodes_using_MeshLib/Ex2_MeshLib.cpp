@@ -5,9 +5,9 @@
 double ComputeFaceArea(Face * f) {
 	Halfedge * he1 = f->he(); // one halfedge
 	Halfedge * he2 = he1->next(); // its next halfedge inside this face
-	Point & pt1 = he1->source()->point();
-	Point & pt2 = he1->target()->point();
-	Point & pt3 = he2->target()->point();
+	MeshPoint & pt1 = he1->source()->point();
+	MeshPoint & pt2 = he1->target()->point();
+	MeshPoint & pt3 = he2->target()->point();
 	Point p21 = pt2 - pt1;
 	Point p31 = pt3 - pt1;
 	Point cprod = p21 ^ p31;
@@ -9,9 +9,9 @@ void ComputeFaceCornerAngles(Face * f, double cAngles[3]) {
 	hes[0] = f->he();
 	hes[1] = hes[0]->next();
 	hes[2] = hes[0]->prev();
-	Point & p0 = hes[0]->target()->point();
-	Point & p1 = hes[1]->target()->point();
-	Point & p2 = hes[2]->target()->point();
+	MeshPoint & p0 = hes[0]->target()->point();
+	MeshPoint & p1 = hes[1]->target()->point();
+	MeshPoint & p2 = hes[2]->target()->point();
 	double l20 = (p0 - p2).norm();
 	double l01 = (p1 - p0).norm();
 	double l12 = (p2 - p1).norm();
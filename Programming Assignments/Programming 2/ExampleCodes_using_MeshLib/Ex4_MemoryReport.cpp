@@ -0,0 +1,50 @@
+#include "Mesh.h"
+#include "CompactMesh.h"
+#include "CompactIterators.h"
+#include <cstdio>
+#include <iostream>
+
+//Compare the memory held by the pointer-based Mesh and by the CompactMesh kernel.
+//Usage: Ex4_MemoryReport mesh1.obj [mesh2.obj ...], e.g. with the meshes in OBJMeshes/
+
+int main(int argc, char ** argv) {
+	if (argc < 2) {
+		std::cerr << "Provide one or more obj files to compare the memory usage.\n";
+		return 1;
+	}
+
+	printf("%-24s %10s %12s %14s %14s %8s\n", "mesh", "#faces", "#vertices", "Mesh B/face", "Compact B/face", "ratio");
+	for (int i = 1; i < argc; ++i) {
+		Mesh * cMesh = new Mesh();
+		if (!cMesh->readOBJFile(argv[i])) {
+			std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+			delete cMesh;
+			continue;
+		}
+		CompactMesh cCompact;
+		if (!cCompact.fromMesh(*cMesh)) {
+			delete cMesh;
+			continue;
+		}
+
+		//the compact kernel is traversed with the same iterators
+		int numBoundaryEdges = 0;
+		for (Compact::MeshEdgeIterator eit(&cCompact); !eit.end(); ++eit)
+			if ((*eit)->boundary()) ++numBoundaryEdges;
+		int maxValence = 0;
+		for (Compact::MeshVertexIterator vit(&cCompact); !vit.end(); ++vit) {
+			int valence = 0;
+			for (Compact::VertexOutHalfedgeIterator heit(*vit); !heit.end(); ++heit) ++valence;
+			if (valence > maxValence) maxValence = valence;
+		}
+
+		double nf = cMesh->numFaces() > 0 ? cMesh->numFaces() : 1;
+		double meshBytes = (double)cMesh->memoryUsage();
+		double compactBytes = (double)cCompact.memoryUsage();
+		printf("%-24s %10d %12d %14.1f %14.1f %7.2fx\n", argv[i], cMesh->numFaces(), cMesh->numVertices(),
+			meshBytes / nf, compactBytes / nf, meshBytes / compactBytes);
+		printf("%-24s %d boundary edges, max valence %d\n", "", numBoundaryEdges, maxValence);
+		delete cMesh;
+	}
+	return 0;
+}
@@ -0,0 +1,82 @@
+#include "Mesh.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+//Time Mesh::parseOBJFile on 1, 2, 4, ... threads up to the number of cores.
+//Usage: Ex5_ParseBenchmark mesh1.obj [mesh2.obj ...], e.g. with the meshes in OBJMeshes/
+//       Ex5_ParseBenchmark -synthetic <MB> out.obj	writes a grid OBJ of about MB megabytes first and times it
+
+//write an n x n grid of vertices with 2 triangles per cell
+static bool writeGrid(const char outFile[], double megabytes)
+{
+	FILE * fp = fopen(outFile, "wb");
+	if (!fp) {
+		std::cerr << "Can't open file " << outFile << "!" << std::endl;
+		return false;
+	}
+	//about 28 bytes per vertex line and 2 x 26 bytes of face lines per vertex
+	int n = (int)sqrt(megabytes * 1e6 / 80.0);
+	if (n < 2) n = 2;
+	for (int j = 0; j < n; ++j)
+		for (int i = 0; i < n; ++i)
+			fprintf(fp, "v %.6f %.6f %.6f\n", i / (double)n, j / (double)n, 0.01 * ((i * 7 + j * 13) % 17));
+	for (int j = 0; j + 1 < n; ++j)
+		for (int i = 0; i + 1 < n; ++i) {
+			int a = j * n + i + 1;
+			fprintf(fp, "f %d %d %d\n", a, a + 1, a + n + 1);
+			fprintf(fp, "f %d %d %d\n", a, a + n + 1, a + n);
+		}
+	fclose(fp);
+	return true;
+}
+
+static void benchmark(const char inFile[])
+{
+	int maxThreads = (int)std::thread::hardware_concurrency();
+	if (maxThreads < 1) maxThreads = 1;
+
+	double serialSeconds = 0;
+	for (int numThreads = 1; ; numThreads = numThreads * 2 > maxThreads && numThreads < maxThreads ? maxThreads : numThreads * 2) {
+		std::vector<double> coords;
+		std::vector<int> faceInds;
+		size_t fileSize = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!Mesh::parseOBJFile(inFile, coords, faceInds, &fileSize, numThreads))
+			return;
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (numThreads == 1) {
+			serialSeconds = seconds;
+			printf("%s: %.1f MB, %d vertices, %d faces\n", inFile, fileSize / 1e6, (int)(coords.size() / 3), (int)(faceInds.size() / 3));
+		}
+		printf("  %3d thread(s) %9.3f s %9.1f MB/s %7.2fx\n", numThreads, seconds, fileSize / 1e6 / seconds, serialSeconds / seconds);
+		if (numThreads >= maxThreads)
+			break;
+	}
+}
+
+int main(int argc, char ** argv) {
+	if (argc < 2) {
+		std::cerr << "Provide one or more obj files, or -synthetic <MB> out.obj.\n";
+		return 1;
+	}
+
+	if (strcmp(argv[1], "-synthetic") == 0) {
+		if (argc < 4) {
+			std::cerr << "Usage: -synthetic <MB> out.obj\n";
+			return 1;
+		}
+		if (!writeGrid(argv[3], atof(argv[2])))
+			return 1;
+		benchmark(argv[3]);
+		return 0;
+	}
+	for (int i = 1; i < argc; ++i)
+		benchmark(argv[i]);
+	return 0;
+}
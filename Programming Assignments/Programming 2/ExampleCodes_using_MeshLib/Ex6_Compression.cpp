@@ -0,0 +1,110 @@
+#include "Mesh.h"
+#include "CompressedFormat.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+//Compress OBJ meshes with CompressedFormat, check that the decoded mesh is the original one, and report
+//the compression ratio versus the OBJ file and the encode / decode throughput.
+//Usage: Ex6_Compression [-bits N] mesh1.obj [mesh2.obj ...], e.g. with the meshes in OBJMeshes/
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the decoded mesh must have the original faces (up to a rotation of their corners), the original number of
+//vertices, and every coordinate within the quantization error
+static bool verify(const std::vector<double> & coords, const std::vector<int> & faceInds,
+	const std::vector<double> & decodedCoords, const std::vector<int> & decodedFaces,
+	const std::vector<int> & vertexOrder, const std::vector<int> & faceOrder, const CompressedFormat::Header & header,
+	double & maxError)
+{
+	const size_t nv = coords.size() / 3, nf = faceInds.size() / 3;
+	if (decodedCoords.size() != coords.size() || decodedFaces.size() != faceInds.size()
+		|| vertexOrder.size() != nv || faceOrder.size() != nf)
+		return false;
+	std::vector<char> seenVertex(nv, 0), seenFace(nf, 0);
+	maxError = 0;
+	for (size_t v = 0; v < nv; ++v) {
+		int o = vertexOrder[v];
+		if (o < 0 || o >= (int)nv || seenVertex[o]++) return false;
+		for (int k = 0; k < 3; ++k) {
+			double error = fabs(decodedCoords[3 * v + k] - coords[3 * o + k]);
+			double bound = CompressedFormat::maxError(header, k);
+			if (error > bound * (1 + 1e-9) + 1e-300) return false;
+			maxError = std::max(maxError, error);
+		}
+	}
+	for (size_t f = 0; f < nf; ++f) {
+		int o = faceOrder[f];
+		if (o < 0 || o >= (int)nf || seenFace[o]++) return false;
+		int r = 0;
+		while (r < 3 && vertexOrder[decodedFaces[3 * f]] != faceInds[3 * o + r]) ++r;
+		if (r == 3) return false;
+		for (int i = 0; i < 3; ++i)
+			if (vertexOrder[decodedFaces[3 * f + i]] != faceInds[3 * o + (r + i) % 3]) return false;
+	}
+	return true;
+}
+
+int main(int argc, char ** argv) {
+	int bits = 16;
+	int first = 1;
+	if (argc > 2 && strcmp(argv[1], "-bits") == 0) {
+		bits = atoi(argv[2]);
+		first = 3;
+	}
+	if (first >= argc) {
+		std::cerr << "Provide one or more obj files to compress.\n";
+		return 1;
+	}
+
+	printf("%-24s %9s %10s %10s %7s %8s %8s %10s %10s %10s %s\n", "mesh", "#faces", "OBJ bytes", "MLZ bytes", "ratio",
+		"conn b/f", "geom b/v", "enc MB/s", "dec MB/s", "max error", "check");
+	for (int i = first; i < argc; ++i) {
+		std::vector<double> coords;
+		std::vector<int> faceInds;
+		size_t objBytes = 0;
+		if (!Mesh::parseOBJFile(argv[i], coords, faceInds, &objBytes))
+			continue;
+		const int nv = (int)(coords.size() / 3), nf = (int)(faceInds.size() / 3);
+
+		//throughput in MB of OBJ text per second, best of a few runs
+		std::vector<char> data;
+		std::vector<int> vertexOrder, faceOrder;
+		double encodeSeconds = 1e30, decodeSeconds = 1e30;
+		std::vector<double> decodedCoords;
+		std::vector<int> decodedFaces;
+		bool ok = true;
+		for (int run = 0; run < 3 && ok; ++run) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ok = CompressedFormat::encode(&coords[0], nv, &faceInds[0], nf, bits, data, &vertexOrder, &faceOrder);
+			encodeSeconds = std::min(encodeSeconds, secondsSince(start));
+		}
+		std::string error;
+		for (int run = 0; run < 3 && ok; ++run) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ok = CompressedFormat::decode(&data[0], data.size(), decodedCoords, decodedFaces, error);
+			decodeSeconds = std::min(decodeSeconds, secondsSince(start));
+		}
+		if (!ok) {
+			std::cerr << "Fail to compress mesh " << argv[i] << ". " << error << "\n";
+			continue;
+		}
+
+		CompressedFormat::Header header;
+		memcpy(&header, &data[0], sizeof(header));
+		double maxError = 0;
+		bool verified = verify(coords, faceInds, decodedCoords, decodedFaces, vertexOrder, faceOrder, header, maxError);
+		double megabytes = objBytes / 1e6;
+		printf("%-24s %9d %10d %10d %6.1fx %8.2f %8.2f %10.1f %10.1f %10.3g %s\n", argv[i], nf, (int)objBytes, (int)data.size(),
+			(double)objBytes / data.size(), 8.0 * header.connectivityBytes / std::max(nf, 1), 8.0 * header.geometryBytes / std::max(nv, 1),
+			megabytes / encodeSeconds, megabytes / decodeSeconds, maxError, verified ? "ok" : "FAILED");
+	}
+	return 0;
+}
@@ -0,0 +1,40 @@
+#include "StreamingMesh.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+//Process a mesh too large for memory cluster by cluster: compute the face normals and areas, the vertex
+//normals and areas and the Gaussian curvature, and write them as a partitioned mesh (one PLY file per
+//cluster plus partition.txt). Ex5_ParseBenchmark -synthetic writes large meshes to try it on.
+//Usage: Ex7_OutOfCore [-faces N] [-threads N] input.obj|input.ply outputDir
+
+int main(int argc, char ** argv) {
+	int clusterFaces = 1 << 20, numThreads = 1;
+	int first = 1;
+	while (first + 1 < argc && argv[first][0] == '-') {
+		if (strcmp(argv[first], "-faces") == 0) clusterFaces = atoi(argv[first + 1]);
+		else if (strcmp(argv[first], "-threads") == 0) numThreads = atoi(argv[first + 1]);
+		else break;
+		first += 2;
+	}
+	if (first + 2 != argc) {
+		std::cerr << "Usage: Ex7_OutOfCore [-faces N] [-threads N] input.obj|input.ply outputDir\n";
+		return 1;
+	}
+
+	StreamingMesh stream;
+	std::vector<StreamingMesh::Kernel> kernels;
+	kernels.push_back(StreamingMesh::faceNormals);
+	kernels.push_back(StreamingMesh::vertexNormals);
+	kernels.push_back(StreamingMesh::gaussianCurvature);
+	if (!stream.partition(argv[first], argv[first + 1], clusterFaces) || !stream.process(kernels, numThreads))
+		return 1;
+
+	//a cluster and its halo hold about 100 bytes per face while they are processed
+	printf("%d vertices, %d faces, %d clusters; at most %lld faces (about %.1f MB) in memory per thread\n",
+		stream.numVertices(), stream.numFaces(), stream.numClusters(), stream.largestCluster(),
+		stream.largestCluster() * 100 / 1e6);
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include "Mesh.h"
+#include "Iterators.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//Time a one-ring traversal and a normal computation on a mesh in its file order and after Mesh::reorder()
+//with each MeshOrdering method. "-shuffle" first puts the vertices and faces in a random order, as a
+//worst case for files whose order carries no locality.
+//Usage: Ex8_Reorder [-shuffle] mesh1.obj [mesh2.obj ...], e.g. with the meshes in OBJMeshes/ or a
+//large mesh written by Ex5_ParseBenchmark -synthetic
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the mean distance between the indices of the two vertices of an edge
+static double meanEdgeSpan(Mesh & mesh)
+{
+	double sum = 0;
+	for (MeshEdgeIterator eit(&mesh); !eit.end(); ++eit) {
+		Halfedge * he = (*eit)->he(0);
+		sum += abs(he->source()->index() - he->target()->index());
+	}
+	return mesh.numEdges() > 0 ? sum / mesh.numEdges() : 0;
+}
+
+//sum of the positions of the neighbors of every vertex
+static double oneRing(Mesh & mesh)
+{
+	Point sum(0, 0, 0);
+	for (MeshVertexIterator vit(&mesh); !vit.end(); ++vit)
+		for (VertexVertexIterator vvit(*vit); !vvit.end(); ++vvit)
+			sum += (*vvit)->point();
+	return sum[0] + sum[1] + sum[2];
+}
+
+//face normals, then vertex normals as the area-weighted average of the face normals around
+static double normals(Mesh & mesh)
+{
+	AttributeArray<Point> & faceNormals = mesh.faceAttributes().add<Point>("normal");
+	AttributeArray<Point> & vertexNormals = mesh.vertexAttributes().add<Point>("normal");
+	for (MeshFaceIterator fit(&mesh); !fit.end(); ++fit) {
+		Halfedge * he = (*fit)->he();
+		MeshPoint & p0 = he->source()->point(), & p1 = he->target()->point(), & p2 = he->next()->target()->point();
+		Point e1 = p1 - p0, e2 = p2 - p0;
+		faceNormals[*fit] = e1 ^ e2;
+	}
+	double check = 0;
+	for (MeshVertexIterator vit(&mesh); !vit.end(); ++vit) {
+		Point n(0, 0, 0);
+		for (VertexFaceIterator vfit(*vit); !vfit.end(); ++vfit)
+			n += faceNormals[*vfit];
+		double length = n.norm();
+		vertexNormals[*vit] = length > 0 ? n / length : n;
+		check += vertexNormals[*vit][0];
+	}
+	return check;
+}
+
+static void report(const char * name, Mesh & mesh, double reorderSeconds)
+{
+	const int repeats = 5;
+	double check = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; ++r) check += oneRing(mesh);
+	double ringSeconds = secondsSince(start) / repeats;
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; ++r) check += normals(mesh);
+	double normalSeconds = secondsSince(start) / repeats;
+	printf("  %-22s %12.1f %10.4f %10.4f %10.4f   (%g)\n", name, meanEdgeSpan(mesh), reorderSeconds, ringSeconds,
+		normalSeconds, check);
+}
+
+int main(int argc, char ** argv) {
+	bool shuffle = argc > 1 && strcmp(argv[1], "-shuffle") == 0;
+	int first = shuffle ? 2 : 1;
+	if (first >= argc) {
+		std::cerr << "Usage: Ex8_Reorder [-shuffle] mesh1.obj [mesh2.obj ...]\n";
+		return 1;
+	}
+
+	const struct { const char * name; MeshOrdering::Method method; } orders[] = {
+		{ "Morton", MeshOrdering::Morton },
+		{ "Hilbert", MeshOrdering::Hilbert },
+		{ "reverse Cuthill-McKee", MeshOrdering::ReverseCuthillMcKee }
+	};
+	for (int i = first; i < argc; ++i) {
+		Mesh original;
+		if (shuffle) {
+			std::vector<double> coords;
+			std::vector<int> faceInds;
+			if (!Mesh::parseOBJFile(argv[i], coords, faceInds)) {
+				std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+				continue;
+			}
+			int nv = (int)coords.size() / 3, nf = (int)faceInds.size() / 3;
+			std::vector<int> vertexOrder(nv), faceOrder(nf), vertexRank(nv);
+			for (int v = 0; v < nv; ++v) vertexOrder[v] = v;
+			for (int f = 0; f < nf; ++f) faceOrder[f] = f;
+			std::mt19937 random(1);
+			std::shuffle(vertexOrder.begin(), vertexOrder.end(), random);
+			std::shuffle(faceOrder.begin(), faceOrder.end(), random);
+			std::vector<double> shuffledCoords(coords.size());
+			std::vector<int> shuffledFaces(faceInds.size());
+			for (int v = 0; v < nv; ++v) {
+				vertexRank[vertexOrder[v]] = v;
+				for (int k = 0; k < 3; ++k) shuffledCoords[3 * v + k] = coords[3 * vertexOrder[v] + k];
+			}
+			for (int f = 0; f < nf; ++f)
+				for (int k = 0; k < 3; ++k) shuffledFaces[3 * f + k] = vertexRank[faceInds[3 * faceOrder[f] + k]];
+			if (!original.buildFromArrays(shuffledCoords.data(), nv, shuffledFaces.data(), nf)) continue;
+		}
+		else if (!original.readOBJFile(argv[i])) {
+			std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+			continue;
+		}
+
+		printf("%s: %d vertices, %d faces%s\n", argv[i], original.numVertices(), original.numFaces(),
+			shuffle ? ", shuffled" : "");
+		printf("  %-22s %12s %10s %10s %10s\n", "order", "edge span", "reorder s", "1-ring s", "normals s");
+		report(shuffle ? "shuffled" : "file", original, 0);
+		for (size_t m = 0; m < sizeof(orders) / sizeof(orders[0]); ++m) {
+			Mesh mesh;
+			original.copyTo(mesh);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			if (!mesh.reorder(orders[m].method)) {
+				std::cerr << "Fail to reorder " << argv[i] << ".\n";
+				break;
+			}
+			report(orders[m].name, mesh, secondsSince(start));
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,225 @@
+#include "Mesh.h"
+#include "MeshGeometry.h"
+#include "MeshParallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Time the per-element kernels of hw2.cpp (halfedge angles, face normals, angle-weighted vertex normals,
+//Gaussian curvature and its local extrema) on a ThreadPool of 1 to N threads and chart the speedups.
+//"fused" is MeshGeometry, which computes what the first four kernels do in one pass over the faces.
+//"-subdivide k" first splits every triangle into four, k times: camel.obj (44k faces) reaches 11M faces
+//at k = 4, a 1.25M-face grid from Ex5_ParseBenchmark -synthetic 20M faces at k = 2. "-threads N" sets
+//the largest thread count (default: all cores), "-grain N" the number of elements per block.
+//The curvature sum must come out the same, to the last bit, whatever the thread count.
+//Usage: Ex9_ParallelScaling [-threads N] [-grain N] [-subdivide k] mesh1.obj [mesh2.obj ...]
+
+struct Kernels
+{
+	AttributeArray<MeshScalar> &	angles;			//of the types of the attributes MeshGeometry shares
+	AttributeArray<MeshPoint> &		faceNormals;
+	AttributeArray<MeshPoint> &		vertexNormals;
+	AttributeArray<MeshScalar> &	curvature;
+	AttributeArray<short> &			extrema;
+	MeshGeometry					geometry;
+	std::vector<Halfedge *>			out;			//the halfedges out of every vertex, of all its fans:
+	std::vector<int>				outStart;		//	those of vertex v are out[outStart[v], outStart[v + 1])
+
+	explicit Kernels(Mesh & mesh)
+		: angles(mesh.halfedgeAttributes().add<MeshScalar>("angle")),
+		faceNormals(mesh.faceAttributes().add<MeshPoint>("normal")),
+		vertexNormals(mesh.vertexAttributes().add<MeshPoint>("normal")),
+		curvature(mesh.vertexAttributes().add<MeshScalar>("curvature")),
+		extrema(mesh.vertexAttributes().add<short>("extremum"))
+	{
+		//VertexOutHalfedgeIterator only goes around one fan of a non-manifold vertex
+		MeshHalfedgeRange halfedges = mesh.halfedges();
+		outStart.assign(mesh.numVertices() + 1, 0);
+		for (Halfedge * he : halfedges) ++outStart[he->source()->index() + 1];
+		for (int v = 0; v < mesh.numVertices(); ++v) outStart[v + 1] += outStart[v];
+		out.resize(halfedges.size());
+		std::vector<int> fill(outStart.begin(), outStart.end() - 1);
+		for (Halfedge * he : halfedges) out[fill[he->source()->index()]++] = he;
+	}
+};
+
+static const int numKernels = 6;
+static const char * kernelNames[numKernels] = { "angles", "face n", "vertex n", "curvature", "extrema", "fused" };
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void runKernel(int kernel, Mesh & mesh, Kernels & k, size_t grain, ThreadPool & pool)
+{
+	const float tau = 2 * 3.14159265359;
+	switch (kernel) {
+	case 0:
+		k.angles.fill(0);
+		parallelForHalfedges(mesh, [&](Halfedge * he) {
+			Point u = he->target()->point() - he->source()->point();
+			he = he->ccw_rotate_about_source();
+			if (!he) return;
+			Point v = he->target()->point() - he->source()->point();
+			k.angles[he] = acos((u * v) / (u.norm() * v.norm()));
+		}, grain, pool);
+		break;
+	case 1:
+		parallelForFaces(mesh, [&](Face * f) {
+			Halfedge * he = f->he();
+			Point u = he->target()->point() - he->source()->point();
+			he = he->clw_rotate_about_source();
+			if (!he) return;
+			Point v = he->target()->point() - he->source()->point();
+			Point normal = u ^ v;
+			k.faceNormals[f] = normal / normal.norm();
+		}, grain, pool);
+		break;
+	case 2:
+		parallelForVertices(mesh, [&](Vertex * v) {
+			Point normal(0, 0, 0);
+			for (int i = k.outStart[v->index()]; i < k.outStart[v->index() + 1]; ++i) {
+				Point weighted = k.faceNormals[k.out[i]->face()] * k.angles[k.out[i]];
+				normal += weighted;
+			}
+			k.vertexNormals[v] = normal / normal.norm();
+		}, grain, pool);
+		break;
+	case 3:
+		parallelForVertices(mesh, [&](Vertex * v) {
+			double curvature = tau;
+			for (int i = k.outStart[v->index()]; i < k.outStart[v->index() + 1]; ++i)
+				curvature -= k.angles[k.out[i]];
+			k.curvature[v] = curvature;
+		}, grain, pool);
+		break;
+	case 4:
+		parallelForVertices(mesh, [&](Vertex * v) {
+			double c = k.curvature[v];
+			bool discard = fabs(c) < 0.05;
+			for (int i = k.outStart[v->index()]; i < k.outStart[v->index() + 1] && !discard; ++i) {
+				double n = k.curvature[k.out[i]->target()];
+				discard = (c > 0 && c < n) || (c < 0 && c > n);
+			}
+			k.extrema[v] = discard ? 0 : c > 0 ? 1 : -1;
+		}, grain, pool);
+		break;
+	case 5:
+		k.geometry.compute(mesh, grain, pool);
+		break;
+	}
+}
+
+//split every triangle into four at the midpoints of its edges
+static void subdivide(std::vector<double> & coords, std::vector<int> & faceInds)
+{
+	std::unordered_map<unsigned long long, int> midpoints;
+	midpoints.reserve(faceInds.size() / 2 * 3);
+	std::vector<int> faces;
+	faces.reserve(4 * faceInds.size());
+	for (size_t f = 0; f < faceInds.size(); f += 3) {
+		int mid[3];
+		for (int j = 0; j < 3; ++j) {
+			int a = faceInds[f + j], b = faceInds[f + (j + 1) % 3];
+			unsigned long long key = (unsigned long long)std::min(a, b) << 32 | (unsigned)std::max(a, b);
+			std::unordered_map<unsigned long long, int>::iterator it = midpoints.find(key);
+			if (it == midpoints.end()) {
+				it = midpoints.insert(std::make_pair(key, (int)(coords.size() / 3))).first;
+				for (int k = 0; k < 3; ++k)
+					coords.push_back((coords[3 * a + k] + coords[3 * b + k]) / 2);
+			}
+			mid[j] = it->second;
+		}
+		const int corners[4][3] = {
+			{ faceInds[f], mid[0], mid[2] }, { mid[0], faceInds[f + 1], mid[1] },
+			{ mid[2], mid[1], faceInds[f + 2] }, { mid[0], mid[1], mid[2] }
+		};
+		for (int t = 0; t < 4; ++t)
+			faces.insert(faces.end(), corners[t], corners[t] + 3);
+	}
+	faceInds.swap(faces);
+}
+
+int main(int argc, char ** argv) {
+	int maxThreads = ThreadPool::global().numThreads(), levels = 0;
+	size_t grain = 1024;
+	int first = 1;
+	while (first + 1 < argc && argv[first][0] == '-') {
+		if (strcmp(argv[first], "-threads") == 0) maxThreads = std::max(1, atoi(argv[first + 1]));
+		else if (strcmp(argv[first], "-grain") == 0) grain = (size_t)std::max(1, atoi(argv[first + 1]));
+		else if (strcmp(argv[first], "-subdivide") == 0) levels = atoi(argv[first + 1]);
+		else break;
+		first += 2;
+	}
+	if (first >= argc) {
+		std::cerr << "Usage: Ex9_ParallelScaling [-threads N] [-grain N] [-subdivide k] mesh1.obj [mesh2.obj ...]\n";
+		return 1;
+	}
+
+	std::vector<int> threadCounts;
+	for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+	threadCounts.push_back(maxThreads);
+
+	for (int i = first; i < argc; ++i) {
+		std::vector<double> coords;
+		std::vector<int> faceInds;
+		if (!Mesh::parseOBJFile(argv[i], coords, faceInds)) {
+			std::cerr << "Fail to read mesh " << argv[i] << ".\n";
+			continue;
+		}
+		for (int l = 0; l < levels; ++l) subdivide(coords, faceInds);
+		Mesh mesh;
+		if (!mesh.buildFromArrays(coords.data(), (int)coords.size() / 3, faceInds.data(), (int)faceInds.size() / 3))
+			continue;
+		std::vector<double>().swap(coords);
+		std::vector<int>().swap(faceInds);
+		Kernels kernels(mesh);
+
+		printf("%s: %d vertices, %d faces, grain %d\n", argv[i], mesh.numVertices(), mesh.numFaces(), (int)grain);
+		printf("  %7s", "threads");
+		for (int k = 0; k < numKernels; ++k) printf(" %10s", kernelNames[k]);
+		printf(" %10s %8s  %s\n", "total s", "speedup", "curvature sum");
+
+		const int repeats = 5;
+		double baseSeconds = 0, baseSum = 0;
+		std::vector<double> speedups;
+		for (size_t c = 0; c < threadCounts.size(); ++c) {
+			ThreadPool pool(threadCounts[c]);
+			double total = 0;
+			printf("  %7d", threadCounts[c]);
+			for (int k = 0; k < numKernels; ++k) {
+				double best = HUGE_VAL;
+				for (int r = 0; r < repeats; ++r) {
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					runKernel(k, mesh, kernels, grain, pool);
+					best = std::min(best, secondsSince(start));
+				}
+				total += best;
+				printf(" %10.4f", best);
+			}
+			double sum = parallelReduceVertices(mesh, 0.0, [&](Vertex * v) { return kernels.curvature[v]; },
+				[](double a, double b) { return a + b; }, grain, pool);
+			if (c == 0) {
+				baseSeconds = total;
+				baseSum = sum;
+			}
+			speedups.push_back(baseSeconds / total);
+			printf(" %10.4f %8.2f  %.17g%s\n", total, speedups.back(), sum, sum == baseSum ? "" : " (differs)");
+		}
+
+		//speedup over one thread, one column per quarter
+		printf("  speedup\n");
+		for (size_t c = 0; c < threadCounts.size(); ++c)
+			printf("  %7d |%s %.2f\n", threadCounts[c], std::string((size_t)(speedups[c] * 4 + 0.5), '#').c_str(),
+				speedups[c]);
+	}
+	return 0;
+}
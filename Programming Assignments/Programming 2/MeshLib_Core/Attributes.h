@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <vector>
+
+// Per-element attributes: named, typed arrays holding one value per element, indexed by index().
+// The Mesh keeps one AttributeSet per element kind and resizes it as elements are created,
+// so an attribute always has exactly one entry per element.
+//
+//		AttributeArray<Point> & normals = mesh->faceAttributes().add<Point>("normal");
+//		for (MeshFaceIterator fit(mesh); !fit.end(); ++fit)
+//			normals[*fit] = ...;
+
+class AttributeArrayBase
+{
+public:
+	AttributeArrayBase(const std::string & name) : m_name(name) {;}
+	virtual ~AttributeArrayBase() {;}
+
+	const std::string & name() const { return m_name; }
+	virtual void	resize(size_t n) = 0;	//new entries get the initial value of the attribute
+	virtual AttributeArrayBase *	clone() const = 0;
+	virtual bool	assign(const AttributeArrayBase & other) = 0;	//copy other if it has the same type, else return false
+	virtual void	permute(const std::vector<int> & order) = 0;	//entry i becomes the former entry order[i]
+	virtual size_t	size() const = 0;
+	virtual size_t	memoryUsage() const = 0;
+
+private:
+	std::string	m_name;
+};
+
+template <class T>
+class AttributeArray : public AttributeArrayBase
+{
+public:
+	AttributeArray(const std::string & name, size_t n, const T & init) : AttributeArrayBase(name), m_data(n, init), m_init(init) {;}
+
+	//by element index
+	T &			operator[](int i)		{ return m_data[i]; }
+	const T &	operator[](int i) const	{ return m_data[i]; }
+	//by element: attr[v] is attr[v->index()]
+	template <class E> T &			operator[](E * e)		{ return m_data[e->index()]; }
+	template <class E> const T &	operator[](E * e) const	{ return m_data[e->index()]; }
+
+	T *			data()			{ return m_data.empty() ? 0 : &m_data[0]; }
+	const T *	data() const	{ return m_data.empty() ? 0 : &m_data[0]; }
+	void		fill(const T & value) { m_data.assign(m_data.size(), value); }
+
+	void	resize(size_t n)	{ m_data.resize(n, m_init); }
+	AttributeArrayBase *	clone() const { return new AttributeArray<T>(*this); }
+	bool	assign(const AttributeArrayBase & other)
+	{
+		const AttributeArray<T> * a = dynamic_cast<const AttributeArray<T> *>(&other);
+		if (!a) return false;
+		m_data = a->m_data;
+		m_init = a->m_init;
+		return true;
+	}
+	void	permute(const std::vector<int> & order)
+	{
+		std::vector<T> data(order.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			data[i] = m_data[order[i]];
+		m_data.swap(data);
+	}
+	size_t	size() const		{ return m_data.size(); }
+	size_t	memoryUsage() const	{ return sizeof(*this) + m_data.capacity() * sizeof(T); }
+
+private:
+	std::vector<T>	m_data;
+	T				m_init;
+};
+
+class AttributeSet
+{
+public:
+	AttributeSet() : m_size(0) {;}
+	~AttributeSet()
+	{
+		removeAll();
+		for (size_t i = 0; i < m_retired.size(); ++i)
+			delete m_retired[i];
+	}
+
+	//the attribute called name, created with every entry set to init if it does not exist yet.
+	//There must be no attribute of another type with the same name (asserted): its users may hold
+	//references to it. Without asserts it leaves the set for a new one but lives as long as the set.
+	template <class T>
+	AttributeArray<T> & add(const std::string & name, const T & init = T())
+	{
+		for (size_t i = 0; i < m_arrays.size(); ++i) {
+			if (m_arrays[i]->name() != name) continue;
+			AttributeArray<T> * a = dynamic_cast<AttributeArray<T> *>(m_arrays[i]);
+			assert(a && "an attribute of another type has this name");
+			if (a) return *a;
+			m_retired.push_back(m_arrays[i]);
+			m_arrays[i] = new AttributeArray<T>(name, m_size, init);
+			return *static_cast<AttributeArray<T> *>(m_arrays[i]);
+		}
+		AttributeArray<T> * a = new AttributeArray<T>(name, m_size, init);
+		m_arrays.push_back(a);
+		return *a;
+	}
+
+	//the attribute called name, NULL if there is none of type T
+	template <class T>
+	AttributeArray<T> * find(const std::string & name)
+	{
+		for (size_t i = 0; i < m_arrays.size(); ++i)
+			if (m_arrays[i]->name() == name)
+				return dynamic_cast<AttributeArray<T> *>(m_arrays[i]);
+		return 0;
+	}
+
+	void remove(const std::string & name)
+	{
+		for (size_t i = 0; i < m_arrays.size(); ++i) {
+			if (m_arrays[i]->name() != name) continue;
+			delete m_arrays[i];
+			m_arrays.erase(m_arrays.begin() + i);
+			return;
+		}
+	}
+
+	void removeAll()
+	{
+		for (size_t i = 0; i < m_arrays.size(); ++i)
+			delete m_arrays[i];
+		m_arrays.clear();
+	}
+
+	//make this set a copy of other, reusing the arrays that have the same name and type
+	void copyFrom(const AttributeSet & other)
+	{
+		std::vector<AttributeArrayBase *> arrays(other.m_arrays.size());
+		for (size_t i = 0; i < arrays.size(); ++i) {
+			const AttributeArrayBase & a = *other.m_arrays[i];
+			for (size_t j = 0; j < m_arrays.size() && !arrays[i]; ++j)
+				if (m_arrays[j] && m_arrays[j]->name() == a.name() && m_arrays[j]->assign(a)) {
+					arrays[i] = m_arrays[j];
+					m_arrays[j] = 0;
+				}
+			if (!arrays[i])
+				arrays[i] = a.clone();
+		}
+		removeAll();
+		m_arrays.swap(arrays);
+		m_size = other.m_size;
+	}
+
+	//exchange the attributes (and sizes) of two sets
+	void swap(AttributeSet & other)
+	{
+		m_arrays.swap(other.m_arrays);
+		std::swap(m_size, other.m_size);
+	}
+
+	//called by the Mesh when its elements are renumbered: element i takes the values of element order[i]
+	void permute(const std::vector<int> & order)
+	{
+		for (size_t i = 0; i < m_arrays.size(); ++i)
+			m_arrays[i]->permute(order);
+	}
+
+	//called by the Mesh when its number of elements changes
+	void resize(size_t n)
+	{
+		m_size = n;
+		for (size_t i = 0; i < m_arrays.size(); ++i)
+			m_arrays[i]->resize(n);
+	}
+
+	size_t	size() const			{ return m_size; }
+	int		numAttributes() const	{ return (int)m_arrays.size(); }
+	AttributeArrayBase &	attribute(int i)	{ return *m_arrays[i]; }	//the i-th attribute, in the order they were added
+	size_t	memoryUsage() const
+	{
+		size_t bytes = m_arrays.capacity() * sizeof(AttributeArrayBase *);
+		for (size_t i = 0; i < m_arrays.size(); ++i)
+			bytes += m_arrays[i]->memoryUsage();
+		return bytes;
+	}
+
+private:
+	AttributeSet(const AttributeSet &);
+	AttributeSet & operator=(const AttributeSet &);
+
+	std::vector<AttributeArrayBase *>	m_arrays;
+	std::vector<AttributeArrayBase *>	m_retired;	//replaced by add() under another type, still referenced
+	size_t								m_size;		//number of elements
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Parallel.h"
+
+// Layout of the binary mesh files written by Mesh::writeBinaryFile().
+// A fixed Header is followed by these arrays, in native byte order, each starting on an 8-byte boundary
+// so that a memory-mapped file can be used in place:
+//	double	coords[3 * numVertices]
+//	int32	faceInds[3 * numFaces]		target vertex of halfedge 3*f+i, as in Connectivity
+//	int32	heTwin[3 * numFaces]
+//	int32	heEdge[3 * numFaces]
+//	int32	heIndex[3 * numFaces]
+//	int32	edgeHe[2 * numEdges]
+//	int32	vertexHe[numVertices]
+//	char	vertexBoundary[numVertices]
+//	the property strings of the vertices, edges and faces: for each kind, a uint32 count followed by
+//	count entries (int32 id, uint32 length, length chars)
+namespace BinaryFormat
+{
+	const char		magic[8] = { 'M', 'e', 's', 'h', 'L', 'i', 'b', 'B' };
+	const uint32_t	version = 1;
+	const uint32_t	byteOrderMark = 0x01020304;	//reads differently on a machine of the other endianness
+
+	struct Header
+	{
+		char		magic[8];
+		uint32_t	version;
+		uint32_t	byteOrder;
+		uint32_t	headerSize;
+		int32_t		numVertices;
+		int32_t		numFaces;
+		int32_t		numEdges;
+		uint64_t	sourceSize;		//size and hash of the text file this cache was made from, 0 if none
+		uint64_t	sourceHash;
+	};
+
+	inline size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+	//name of the cache file kept next to a text mesh file
+	inline std::string cachePath(const char inFile[]) { return std::string(inFile) + ".mlb"; }
+
+	//64-bit hash of n bytes, mixing four 8-byte lanes at a time
+	inline uint64_t hashBytes(const char * p, size_t n)
+	{
+		const uint64_t k = 0x9E3779B97F4A7C15ull;
+		uint64_t h[4] = { k, k ^ 1, k ^ 2, k ^ 3 };
+		size_t i = 0;
+		for (; i + 32 <= n; i += 32)
+			for (int l = 0; l < 4; ++l) {
+				uint64_t w;
+				memcpy(&w, p + i + 8 * l, 8);
+				h[l] = (h[l] ^ w) * 0xFF51AFD7ED558CCDull;
+				h[l] ^= h[l] >> 29;
+			}
+		uint64_t r = n;
+		for (int l = 0; l < 4; ++l)
+			r = (r ^ h[l]) * 0xC4CEB9FE1A85EC53ull;
+		for (; i < n; ++i)
+			r = (r ^ (unsigned char)p[i]) * 0x100000001B3ull;
+		return r ^ (r >> 31);
+	}
+
+	//hash of a whole file: fixed-size chunks hashed in parallel, then combined in order
+	inline uint64_t hashFile(const char * p, size_t n, int numThreads = 0)
+	{
+		const size_t chunk = (size_t)1 << 22;
+		int numChunks = (int)((n + chunk - 1) / chunk);
+		std::vector<uint64_t> hashes(numChunks);
+		Parallel::forChunks(numChunks, numThreads, [&](int c) {
+			size_t b = c * chunk;
+			hashes[c] = hashBytes(p + b, std::min(chunk, n - b));
+		});
+		return hashBytes(hashes.empty() ? "" : (const char *)&hashes[0], hashes.size() * sizeof(uint64_t)) ^ n;
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CompactMesh.h"
+#include "Iterators.h"
+
+// The iterators of Iterators.h, on a CompactMesh.
+// Usage is the same as with Mesh, e.g.
+//		for (Compact::MeshVertexIterator vit(&cmesh); !vit.end(); ++vit)
+//			for (Compact::VertexOutHalfedgeIterator heit(*vit); !heit.end(); ++heit) ...
+
+struct CompactKernel
+{
+	typedef CompactVertex	VertexHandle;
+	typedef CompactHalfedge	HalfedgeHandle;
+	typedef CompactEdge		EdgeHandle;
+	typedef CompactFace		FaceHandle;
+};
+
+namespace Compact
+{
+	// Enumerating all the vertices
+	class MeshVertexIterator
+	{
+	public:
+		MeshVertexIterator(CompactMesh * cmesh) : m_Mesh(cmesh), m_id(0) {;}
+		CompactVertex value() { return m_Mesh->indVertex(m_id); }
+		void operator++() { ++m_id; }
+		bool end() { return m_id >= m_Mesh->numVertices(); }
+		CompactVertex operator*() { return value(); }
+		void reset() { m_id = 0; }
+	private:
+		CompactMesh *	m_Mesh;
+		int				m_id;
+	};
+
+	// Enumerating all the faces
+	class MeshFaceIterator
+	{
+	public:
+		MeshFaceIterator(CompactMesh * cmesh) : m_Mesh(cmesh), m_id(0) {;}
+		CompactFace value() { return m_Mesh->indFace(m_id); }
+		void operator++() { ++m_id; }
+		bool end() { return m_id >= m_Mesh->numFaces(); }
+		CompactFace operator*() { return value(); }
+		void reset() { m_id = 0; }
+	private:
+		CompactMesh *	m_Mesh;
+		int				m_id;
+	};
+
+	// Enumerating all the edges
+	class MeshEdgeIterator
+	{
+	public:
+		MeshEdgeIterator(CompactMesh * cmesh) : m_Mesh(cmesh), m_id(0) {;}
+		CompactEdge value() { return m_Mesh->indEdge(m_id); }
+		void operator++() { ++m_id; }
+		bool end() { return m_id >= m_Mesh->numEdges(); }
+		CompactEdge operator*() { return value(); }
+		void reset() { m_id = 0; }
+	private:
+		CompactMesh *	m_Mesh;
+		int				m_id;
+	};
+
+	// Enumerating all the halfedges, in the same order as ::MeshHalfedgeIterator
+	class MeshHalfedgeIterator
+	{
+	public:
+		MeshHalfedgeIterator(CompactMesh * cmesh) : m_Mesh(cmesh), m_edge(0), m_id(0) {;}
+		CompactHalfedge value() { return m_Mesh->indHalfedge(m_Mesh->edgeHe(m_edge, m_id)); }
+		void operator++()
+		{
+			if (m_id == 0 && m_Mesh->edgeHe(m_edge, 1) >= 0)
+				m_id = 1;
+			else {
+				m_id = 0;
+				++m_edge;
+			}
+		}
+		bool end() { return m_edge >= m_Mesh->numEdges(); }
+		CompactHalfedge operator*() { return value(); }
+		void reset() { m_edge = 0; m_id = 0; }
+	private:
+		CompactMesh *	m_Mesh;
+		int				m_edge;
+		int				m_id;
+	};
+
+	typedef FaceVertexIteratorT<CompactKernel>			FaceVertexIterator;
+	typedef FaceHalfedgeIteratorT<CompactKernel>		FaceHalfedgeIterator;
+	typedef FaceEdgeIteratorT<CompactKernel>			FaceEdgeIterator;
+	typedef VertexVertexIteratorT<CompactKernel>		VertexVertexIterator;
+	typedef VertexEdgeIteratorT<CompactKernel>			VertexEdgeIterator;
+	typedef VertexFaceIteratorT<CompactKernel>			VertexFaceIterator;
+	typedef VertexOutHalfedgeIteratorT<CompactKernel>	VertexOutHalfedgeIterator;
+	typedef VertexInHalfedgeIteratorT<CompactKernel>	VertexInHalfedgeIterator;
+}
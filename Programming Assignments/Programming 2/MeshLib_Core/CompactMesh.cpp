@@ -0,0 +1,134 @@
+#include "CompactMesh.h"
+#include "Iterators.h"
+#include "Mesh.h"
+#include "Parallel.h"
+#include <iostream>
+
+// Same walks as Vertex::most_*_halfedge(), on handles
+CompactHalfedge CompactVertex::most_ccw_in_halfedge() const
+{
+	if (!boundary())
+		return he();
+	CompactHalfedge h = he();
+	CompactHalfedge nhe = h->ccw_rotate_about_target();
+	CompactHalfedge startHe = h;
+	while (!!nhe) {
+		h = nhe;
+		nhe = nhe->ccw_rotate_about_target();
+		if (h == startHe) return startHe;	//only for non-manifold input
+	}
+	return h;
+}
+
+CompactHalfedge CompactVertex::most_clw_in_halfedge() const
+{
+	if (!boundary())
+		return he();
+	CompactHalfedge h = he();
+	CompactHalfedge nhe = h->clw_rotate_about_target();
+	CompactHalfedge startHe = h;
+	while (!!nhe) {
+		h = nhe;
+		nhe = nhe->clw_rotate_about_target();
+		if (h == startHe) return startHe;
+	}
+	return h;
+}
+
+CompactHalfedge CompactVertex::most_ccw_out_halfedge() const
+{
+	if (!boundary())
+		return he()->twin();
+	CompactHalfedge h = he()->twin();
+	if (!h)
+		h = he()->next();
+	CompactHalfedge startHe = h;
+	CompactHalfedge nhe = h->ccw_rotate_about_source();
+	while (!!nhe) {
+		h = nhe;
+		nhe = nhe->ccw_rotate_about_source();
+		if (h == startHe) return startHe;
+	}
+	return h;
+}
+
+CompactHalfedge CompactVertex::most_clw_out_halfedge() const
+{
+	if (!boundary())
+		return he()->twin();
+	CompactHalfedge h = he()->twin();
+	if (!h)
+		h = he()->next();
+	CompactHalfedge startHe = h;
+	CompactHalfedge nhe = h->clw_rotate_about_source();
+	while (!!nhe) {
+		h = nhe;
+		nhe = nhe->clw_rotate_about_source();
+		if (h == startHe) return startHe;
+	}
+	return h;
+}
+
+
+void CompactMesh::clear()
+{
+	std::vector<MeshPoint>().swap(m_points);
+	std::vector<int>().swap(m_faceInds);
+	m_conn.clear();
+}
+
+bool CompactMesh::build(const double coords[], int numVertices, const int faceInds[], int numFaces, int numThreads)
+{
+	clear();
+	if (!m_conn.build(faceInds, numVertices, numFaces, numThreads))
+		return false;
+	m_points.resize(numVertices);
+	m_faceInds.assign(faceInds, faceInds + 3 * (size_t)numFaces);
+	Parallel::forRange(numVertices, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i)
+			m_points[i] = MeshPoint(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+	});
+	return true;
+}
+
+bool CompactMesh::readOBJFile(const char inputFile[])
+{
+	std::cout << "Reading mesh " << inputFile << " ...\n";
+	std::vector<double> coords;
+	std::vector<int> faceInds;
+	if (!Mesh::parseOBJFile(inputFile, coords, faceInds))
+		return false;
+	if (!build(coords.empty() ? NULL : &coords[0], (int)(coords.size() / 3),
+		faceInds.empty() ? NULL : &faceInds[0], (int)(faceInds.size() / 3)))
+		return false;
+	std::cout << "Done!\n";
+	return true;
+}
+
+bool CompactMesh::fromMesh(Mesh & mesh)
+{
+	std::vector<double> coords;
+	std::vector<int> faceInds;
+	coords.reserve(3 * (size_t)mesh.numVertices());
+	faceInds.reserve(3 * (size_t)mesh.numFaces());
+	for (MeshVertexIterator vit(&mesh); !vit.end(); ++vit)
+		for (int i = 0; i < 3; ++i)
+			coords.push_back((*vit)->point()[i]);
+	for (MeshFaceIterator fit(&mesh); !fit.end(); ++fit) {
+		Halfedge * he = (*fit)->he()->next();	//Face::he() is the last corner of the face
+		for (int i = 0; i < 3; ++i, he = he->next())
+			faceInds.push_back(he->target()->index());
+	}
+	return build(coords.empty() ? NULL : &coords[0], mesh.numVertices(),
+		faceInds.empty() ? NULL : &faceInds[0], mesh.numFaces());
+}
+
+size_t CompactMesh::memoryUsage() const
+{
+	return sizeof(CompactMesh)
+		+ m_points.capacity() * sizeof(MeshPoint)
+		+ m_faceInds.capacity() * sizeof(int)
+		+ (m_conn.heTwin.capacity() + m_conn.heEdge.capacity() + m_conn.heIndex.capacity()
+			+ m_conn.edgeHe.capacity() + m_conn.vertexHe.capacity()) * sizeof(int)
+		+ m_conn.vertexBoundary.capacity();
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include "Connectivity.h"
+#include "Point.h"
+
+class Mesh;
+class CompactMesh;
+
+// Compact mesh kernel: the connectivity is stored in contiguous arrays (see Connectivity)
+// and every element is addressed by a 32-bit handle instead of a heap-allocated object.
+//
+// CompactVertex, CompactHalfedge, CompactEdge and CompactFace are small value handles with the
+// same accessors as Vertex, Halfedge, Edge and Face. They provide operator-> so that code written
+// against the pointer kernel ("v->point()", "he->twin()") reads the same, and the circulators
+// of Iterators.h work on them (see CompactIterators.h).
+
+class CompactVertex;
+class CompactEdge;
+class CompactFace;
+
+class CompactHalfedge
+{
+public:
+	CompactHalfedge() : m_mesh(0), m_id(-1) {;}
+	CompactHalfedge(CompactMesh * mesh, int id) : m_mesh(mesh), m_id(id) {;}
+
+	const CompactHalfedge * operator->() const { return this; }
+	bool operator!() const { return m_id < 0; }
+	bool operator==(const CompactHalfedge & he) const { return m_id == he.m_id; }
+	bool operator!=(const CompactHalfedge & he) const { return m_id != he.m_id; }
+
+	//Pointers for Halfedge Data Structure
+	inline CompactFace		face() const;
+	inline CompactEdge		edge() const;
+	inline CompactVertex	target() const;
+	inline CompactHalfedge	prev() const;
+	inline CompactHalfedge	next() const;
+
+	//Computed by Halfedge Data Structure
+	inline CompactHalfedge	twin() const;
+	inline CompactVertex	source() const;
+
+	//Rotation operations
+	CompactHalfedge clw_rotate_about_target() const { return next()->twin(); }
+	CompactHalfedge ccw_rotate_about_source() const { return prev()->twin(); }
+	CompactHalfedge clw_rotate_about_source() const {
+		CompactHalfedge he = twin();
+		return (!he) ? he : he->next();
+	}
+	CompactHalfedge ccw_rotate_about_target() const {
+		CompactHalfedge he_dual = twin();
+		return (!he_dual) ? he_dual : he_dual->prev();
+	}
+
+	inline int	index() const;				//same value as Halfedge::index()
+	int			id() const { return m_id; }	//handle: 3 * face id + corner
+
+private:
+	CompactMesh *	m_mesh;
+	int				m_id;
+};
+
+class CompactVertex
+{
+public:
+	CompactVertex() : m_mesh(0), m_id(-1) {;}
+	CompactVertex(CompactMesh * mesh, int id) : m_mesh(mesh), m_id(id) {;}
+
+	const CompactVertex * operator->() const { return this; }
+	bool operator!() const { return m_id < 0; }
+	bool operator==(const CompactVertex & v) const { return m_id == v.m_id; }
+	bool operator!=(const CompactVertex & v) const { return m_id != v.m_id; }
+
+	inline MeshPoint &		point() const;
+	inline CompactHalfedge	he() const;
+	inline bool				boundary() const;
+
+	//Rotation operations
+	CompactHalfedge most_ccw_in_halfedge() const;
+	CompactHalfedge most_ccw_out_halfedge() const;
+	CompactHalfedge most_clw_in_halfedge() const;
+	CompactHalfedge most_clw_out_halfedge() const;
+
+	int index() const { return m_id; }
+
+private:
+	CompactMesh *	m_mesh;
+	int				m_id;
+};
+
+class CompactEdge
+{
+public:
+	CompactEdge() : m_mesh(0), m_id(-1) {;}
+	CompactEdge(CompactMesh * mesh, int id) : m_mesh(mesh), m_id(id) {;}
+
+	const CompactEdge * operator->() const { return this; }
+	bool operator!() const { return m_id < 0; }
+	bool operator==(const CompactEdge & e) const { return m_id == e.m_id; }
+	bool operator!=(const CompactEdge & e) const { return m_id != e.m_id; }
+
+	inline CompactHalfedge	he(int i) const;
+	CompactHalfedge			twin(const CompactHalfedge & he) const { return (he == this->he(0)) ? this->he(1) : this->he(0); }
+	bool					boundary() const { return !he(0) || !he(1); }
+
+	int index() const { return m_id; }
+
+private:
+	CompactMesh *	m_mesh;
+	int				m_id;
+};
+
+class CompactFace
+{
+public:
+	CompactFace() : m_mesh(0), m_id(-1) {;}
+	CompactFace(CompactMesh * mesh, int id) : m_mesh(mesh), m_id(id) {;}
+
+	const CompactFace * operator->() const { return this; }
+	bool operator!() const { return m_id < 0; }
+	bool operator==(const CompactFace & f) const { return m_id == f.m_id; }
+	bool operator!=(const CompactFace & f) const { return m_id != f.m_id; }
+
+	CompactHalfedge he() const { return CompactHalfedge(m_mesh, 3 * m_id + 2); }	//same corner as Mesh picks
+
+	int index() const { return m_id; }
+
+private:
+	CompactMesh *	m_mesh;
+	int				m_id;
+};
+
+
+class CompactMesh
+{
+public:
+	CompactMesh() {;}
+
+	bool build(const double coords[], int numVertices,				//build from xyz coordinates and triangle indices,
+		const int faceInds[], int numFaces, int numThreads = 0);	//	numThreads = 0: all cores
+	bool readOBJFile(const char inFile[]);
+	bool fromMesh(Mesh & mesh);										//convert a pointer-based mesh
+	void clear();
+
+	int numVertices() const	{ return (int)m_points.size(); }
+	int numEdges() const	{ return m_conn.numEdges(); }
+	int numFaces() const	{ return (int)m_faceInds.size() / 3; }
+	int numHalfedges() const{ return (int)m_faceInds.size(); }
+	size_t memoryUsage() const;										//bytes held by the mesh
+
+	//element handles
+	CompactVertex	indVertex(int i)	{ return CompactVertex(this, i); }
+	CompactFace		indFace(int i)		{ return CompactFace(this, i); }
+	CompactEdge		indEdge(int i)		{ return CompactEdge(this, i); }
+	CompactHalfedge	indHalfedge(int i)	{ return CompactHalfedge(this, i); }
+
+	//raw connectivity, every query is O(1); -1 stands for "none"
+	int		heTarget(int h) const	{ return m_faceInds[h]; }
+	int		heSource(int h) const	{ return m_faceInds[hePrev(h)]; }
+	int		heNext(int h) const		{ return (h % 3 == 2) ? h - 2 : h + 1; }
+	int		hePrev(int h) const		{ return (h % 3 == 0) ? h + 2 : h - 1; }
+	int		heTwin(int h) const		{ return m_conn.heTwin[h]; }
+	int		heEdge(int h) const		{ return m_conn.heEdge[h]; }
+	int		heFace(int h) const		{ return h / 3; }
+	int		heIndex(int h) const	{ return m_conn.heIndex[h]; }
+	int		edgeHe(int e, int i) const { return m_conn.edgeHe[2 * e + i]; }
+	int		vertexHe(int v) const	{ return m_conn.vertexHe[v]; }
+	bool	vertexBoundary(int v) const { return m_conn.vertexBoundary[v] != 0; }
+	MeshPoint &	point(int v)		{ return m_points[v]; }
+
+protected:
+	std::vector<MeshPoint>	m_points;		//vertex positions
+	std::vector<int>	m_faceInds;		//target vertex of each halfedge
+	Connectivity		m_conn;			//twins, edges, halfedge indices, vertex halfedges and boundary flags
+};
+
+
+inline CompactFace		CompactHalfedge::face() const	{ return CompactFace(m_mesh, m_mesh->heFace(m_id)); }
+inline CompactEdge		CompactHalfedge::edge() const	{ return CompactEdge(m_mesh, m_mesh->heEdge(m_id)); }
+inline CompactVertex	CompactHalfedge::target() const	{ return CompactVertex(m_mesh, m_mesh->heTarget(m_id)); }
+inline CompactHalfedge	CompactHalfedge::prev() const	{ return CompactHalfedge(m_mesh, m_mesh->hePrev(m_id)); }
+inline CompactHalfedge	CompactHalfedge::next() const	{ return CompactHalfedge(m_mesh, m_mesh->heNext(m_id)); }
+inline CompactHalfedge	CompactHalfedge::twin() const	{ return CompactHalfedge(m_mesh, m_mesh->heTwin(m_id)); }
+inline CompactVertex	CompactHalfedge::source() const	{ return CompactVertex(m_mesh, m_mesh->heSource(m_id)); }
+inline int				CompactHalfedge::index() const	{ return m_mesh->heIndex(m_id); }
+
+inline MeshPoint &		CompactVertex::point() const	{ return m_mesh->point(m_id); }
+inline CompactHalfedge	CompactVertex::he() const		{ return CompactHalfedge(m_mesh, m_mesh->vertexHe(m_id)); }
+inline bool				CompactVertex::boundary() const	{ return m_mesh->vertexBoundary(m_id); }
+
+inline CompactHalfedge	CompactEdge::he(int i) const	{ return CompactHalfedge(m_mesh, m_mesh->edgeHe(m_id, i)); }
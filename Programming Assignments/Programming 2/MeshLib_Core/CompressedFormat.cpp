@@ -0,0 +1,559 @@
+#include "CompressedFormat.h"
+#include "BinaryFormat.h"
+#include "Connectivity.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	//adaptive binary range coder with 11-bit probabilities
+	const int		probBits = 11;
+	const uint16_t	probInit = 1 << (probBits - 1);
+	const int		moveBits = 5;
+	const uint32_t	topValue = 1u << 24;
+
+	class RangeEncoder
+	{
+	public:
+		RangeEncoder(std::vector<char> & out) : m_out(out), m_low(0), m_range(0xFFFFFFFFu), m_cache(0), m_cacheSize(1) {;}
+
+		int bit(uint16_t & prob, int bit)
+		{
+			uint32_t bound = (m_range >> probBits) * prob;
+			if (!bit) {
+				m_range = bound;
+				prob += ((1 << probBits) - prob) >> moveBits;
+			}
+			else {
+				m_low += bound;
+				m_range -= bound;
+				prob -= prob >> moveBits;
+			}
+			while (m_range < topValue) {
+				m_range <<= 8;
+				shiftLow();
+			}
+			return bit;
+		}
+
+		//n equiprobable bits of value, most significant first
+		uint64_t direct(uint64_t value, int n)
+		{
+			for (int i = n - 1; i >= 0; --i) {
+				m_range >>= 1;
+				if ((value >> i) & 1)
+					m_low += m_range;
+				while (m_range < topValue) {
+					m_range <<= 8;
+					shiftLow();
+				}
+			}
+			return value;
+		}
+
+		void flush() { for (int i = 0; i < 5; ++i) shiftLow(); }
+
+	private:
+		void shiftLow()
+		{
+			if ((uint32_t)m_low < 0xFF000000u || (m_low >> 32) != 0) {
+				unsigned char carry = (unsigned char)(m_low >> 32);
+				unsigned char byte = m_cache;
+				do {
+					m_out.push_back((char)(unsigned char)(byte + carry));
+					byte = 0xFF;
+				} while (--m_cacheSize);
+				m_cache = (unsigned char)(m_low >> 24);
+			}
+			++m_cacheSize;
+			m_low = (m_low & 0x00FFFFFFu) << 8;
+		}
+
+		std::vector<char> &	m_out;
+		uint64_t			m_low;
+		uint32_t			m_range;
+		unsigned char		m_cache;
+		uint64_t			m_cacheSize;
+	};
+
+	class RangeDecoder
+	{
+	public:
+		RangeDecoder(const char * p, const char * end) : m_p((const unsigned char *)p), m_end((const unsigned char *)end),
+			m_range(0xFFFFFFFFu), m_code(0), m_overrun(false)
+		{
+			for (int i = 0; i < 5; ++i)
+				m_code = (m_code << 8) | next();
+		}
+
+		//the value passed in is ignored: decoders return what they read
+		int bit(uint16_t & prob, int)
+		{
+			uint32_t bound = (m_range >> probBits) * prob;
+			int bit;
+			if (m_code < bound) {
+				m_range = bound;
+				prob += ((1 << probBits) - prob) >> moveBits;
+				bit = 0;
+			}
+			else {
+				m_code -= bound;
+				m_range -= bound;
+				prob -= prob >> moveBits;
+				bit = 1;
+			}
+			while (m_range < topValue) {
+				m_range <<= 8;
+				m_code = (m_code << 8) | next();
+			}
+			return bit;
+		}
+
+		uint64_t direct(uint64_t, int n)
+		{
+			uint64_t value = 0;
+			for (int i = 0; i < n; ++i) {
+				m_range >>= 1;
+				int bit = m_code >= m_range;
+				if (bit)
+					m_code -= m_range;
+				value = (value << 1) | bit;
+				while (m_range < topValue) {
+					m_range <<= 8;
+					m_code = (m_code << 8) | next();
+				}
+			}
+			return value;
+		}
+
+		bool overrun() const { return m_overrun; }
+
+	private:
+		uint32_t next()
+		{
+			if (m_p < m_end) return *m_p++;
+			m_overrun = true;
+			return 0;
+		}
+
+		const unsigned char *	m_p;
+		const unsigned char *	m_end;
+		uint32_t				m_range;
+		uint32_t				m_code;
+		bool					m_overrun;
+	};
+
+	//value of n bits with a binary tree of adaptive probabilities (probs has 2^n entries)
+	template <class Coder>
+	uint32_t codeTree(Coder & coder, uint16_t * probs, int n, uint32_t value)
+	{
+		uint32_t m = 1;
+		for (int i = n - 1; i >= 0; --i)
+			m = (m << 1) | coder.bit(probs[m], (value >> i) & 1);
+		return m - (1u << n);
+	}
+
+	//unsigned value of up to 63 bits: its bit length with a tree, the bit below the leading one
+	//with an adaptive probability per length, the rest as direct bits
+	struct UIntModel
+	{
+		uint16_t	length[64];
+		uint16_t	second[64];
+
+		UIntModel() { for (int i = 0; i < 64; ++i) length[i] = second[i] = probInit; }
+	};
+
+	template <class Coder>
+	uint64_t codeUInt(Coder & coder, UIntModel & model, uint64_t value)
+	{
+		int n = 0;
+		while (n < 63 && (value >> n) > 1) ++n;		//index of the leading bit, 0 for 0 and 1
+		int length = value ? n + 1 : 0;
+		length = (int)codeTree(coder, model.length, 6, length);
+		if (length <= 1)
+			return (uint64_t)length;
+		n = length - 1;
+		uint64_t result = 1;
+		result = (result << 1) | coder.bit(model.second[n], (int)((value >> (n - 1)) & 1));
+		if (n > 1)
+			result = (result << (n - 1)) | coder.direct(value & ((1ull << (n - 1)) - 1), n - 1);
+		return result;
+	}
+
+	inline uint64_t zigzag(int64_t v)	{ return v < 0 ? ((uint64_t)(-(v + 1)) << 1) | 1 : (uint64_t)v << 1; }
+	inline int64_t unzigzag(uint64_t u)	{ return (u & 1) ? -(int64_t)(u >> 1) - 1 : (int64_t)(u >> 1); }
+
+	const int maxCandidates = 15;	//candidate index 15 escapes to an explicit vertex id
+
+	//What the encoder knows of the original mesh; absent when decoding.
+	struct Source
+	{
+		const int *			faceInds;
+		const int *			heTwin;
+		const int64_t *		quantized;		//3 per original vertex
+		std::vector<int>	newOfVertex;	//decoded id of each original vertex, -1 before it is reached
+		std::vector<int>	vertexOrder;	//original vertex of each decoded one
+		std::vector<int>	faceOrder;		//original face of each decoded one
+		std::vector<int>	outHe;			//original halfedge of each edge of the decoded faces (slot k: corner k to k+1)
+		std::vector<char>	visited;		//per original face
+		int					nextSeed;		//first original face that may not be visited yet
+		int					nextVertex;		//first original vertex that may not be reached yet
+	};
+
+	//The traversal, run identically by the encoder (source given, symbols written) and the decoder
+	//(symbols read): both build the same faces, quantized positions and vertex neighbourhoods.
+	template <class Coder>
+	class Traversal
+	{
+	public:
+		Traversal(Coder & connectivity, Coder & geometry, Source * source, int numVertices, int numFaces)
+			: m_conn(connectivity), m_geom(geometry), m_src(source), m_numVertices(numVertices), m_numFaces(numFaces), m_ok(true)
+		{
+			for (int i = 0; i < 3 * 3; ++i) m_spawn[i] = probInit;
+			for (int i = 0; i < 2; ++i) m_isNew[i] = probInit;
+			for (int i = 0; i < 2 * (maxCandidates + 1); ++i) m_candidate[i] = probInit;
+		}
+
+		bool run()
+		{
+			faces.reserve(3 * (size_t)m_numFaces);
+			quantized.reserve(3 * (size_t)m_numVertices);
+			m_neighbours.resize(m_numVertices);
+			size_t head = 0;
+			while (m_ok && (int)(faces.size() / 3) < m_numFaces) {
+				if (head == faces.size()) {
+					seed();
+					if (!m_ok) break;
+				}
+				//the face at the head of the queue spawns the unreached faces across its edges; the edge
+				//from corner 0 to 1 of a spawned face is the one it was reached through
+				const int f = (int)(head / 3);
+				const int context = m_spawned[f] ? 1 + m_thirdNew[f] : 0;
+				for (int k = m_spawned[f] ? 1 : 0; k < 3 && m_ok; ++k) {
+					int open = 0;
+					int twin = -1;
+					if (m_src) {
+						twin = m_src->heTwin[m_src->outHe[3 * f + k]];
+						open = twin >= 0 && !m_src->visited[twin / 3];
+					}
+					if (m_conn.bit(m_spawn[3 * context + k], open))
+						spawn(f, k, twin);
+				}
+				head += 3;
+			}
+			//vertices of no face, coded by position only
+			while (m_ok && numDecoded() < m_numVertices) {
+				int v = -1;
+				if (m_src) {
+					while (m_src->newOfVertex[m_src->nextVertex] >= 0) ++m_src->nextVertex;
+					v = m_src->nextVertex;
+				}
+				newVertex(v, -1, -1, -1);
+			}
+			return m_ok;
+		}
+
+		bool ok() const { return m_ok; }
+
+		std::vector<int>		faces;		//3 decoded vertex ids per decoded face
+		std::vector<int64_t>	quantized;	//3 per decoded vertex
+
+	private:
+		int numDecoded() const { return (int)(quantized.size() / 3); }
+
+		//start a new connected component with a face whose vertices are all coded on their own
+		void seed()
+		{
+			int corners[3] = { -1, -1, -1 };
+			int f = -1;
+			if (m_src) {
+				while (m_src->visited[m_src->nextSeed]) ++m_src->nextSeed;
+				f = m_src->nextSeed;
+				m_src->visited[f] = 1;
+				m_src->faceOrder.push_back(f);
+				//corner k goes from the source of halfedge 3f+k to its target
+				for (int k = 0; k < 3; ++k)
+					m_src->outHe.push_back(3 * f + k);
+				corners[0] = m_src->faceInds[3 * f + 2];
+				corners[1] = m_src->faceInds[3 * f];
+				corners[2] = m_src->faceInds[3 * f + 1];
+			}
+			int v[3];
+			for (int k = 0; k < 3 && m_ok; ++k)
+				v[k] = codeVertex(corners[k], 0, -1, -1, -1);
+			if (m_ok)
+				addFace(v[0], v[1], v[2], false, false);
+		}
+
+		//reach the face across edge k of decoded face f
+		void spawn(int f, int k, int twin)
+		{
+			const int a = faces[3 * f + k], b = faces[3 * f + (k + 1) % 3], d = faces[3 * f + (k + 2) % 3];
+			int third = -1;
+			if (m_src) {
+				//the new face goes b -> a -> third, its first edge being the twin
+				const int t0 = twin, t1 = twin - twin % 3 + (twin + 1) % 3, t2 = twin - twin % 3 + (twin + 2) % 3;
+				m_src->visited[twin / 3] = 1;
+				m_src->faceOrder.push_back(twin / 3);
+				m_src->outHe.push_back(t0);
+				m_src->outHe.push_back(t1);
+				m_src->outHe.push_back(t2);
+				third = m_src->faceInds[t1];
+			}
+			const int before = numDecoded();
+			int c = codeVertex(third, 1, b, a, d);
+			if (m_ok)
+				addFace(b, a, c, true, numDecoded() > before);
+		}
+
+		//a corner of a new face: a new vertex with its position, or one already decoded.
+		//Old vertices are looked up among the neighbours of the gate vertices a and b first.
+		int codeVertex(int original, int context, int a, int b, int d)
+		{
+			int isNew = 1;
+			if (m_src)
+				isNew = m_src->newOfVertex[original] < 0;
+			if (numDecoded() == 0)
+				isNew = 1;	//nothing to refer to yet
+			else if (numDecoded() == m_numVertices)
+				isNew = 0;
+			else
+				isNew = m_conn.bit(m_isNew[context], isNew);
+			if (isNew)
+				return newVertex(original, a, b, d);
+
+			int target = m_src ? m_src->newOfVertex[original] : -1;
+			//the latest neighbours first
+			std::vector<int> & candidates = m_candidates;
+			candidates.clear();
+			if (a >= 0) {
+				const std::vector<int> & na = m_neighbours[a];
+				for (size_t i = na.size(); i-- > 0 && (int)candidates.size() < maxCandidates; )
+					if (na[i] != b) candidates.push_back(na[i]);
+				const std::vector<int> & nb = m_neighbours[b];
+				for (size_t i = nb.size(); i-- > 0 && (int)candidates.size() < maxCandidates; )
+					if (nb[i] != a) candidates.push_back(nb[i]);
+			}
+			int index = maxCandidates;
+			if (m_src)
+				for (size_t i = 0; i < candidates.size(); ++i)
+					if (candidates[i] == target) {
+						index = (int)i;
+						break;
+					}
+			index = (int)codeTree(m_conn, m_candidate + (a >= 0 ? maxCandidates + 1 : 0), 4, index);
+			if (index < (int)candidates.size())
+				return candidates[index];
+			if (index != maxCandidates) {
+				m_ok = false;
+				return 0;
+			}
+			uint64_t id = codeUInt(m_conn, m_vertexId, m_src ? (uint64_t)target : 0);
+			if (id >= (uint64_t)numDecoded()) {
+				m_ok = false;
+				return 0;
+			}
+			return (int)id;
+		}
+
+		//a new vertex, predicted from gate (a, b) and opposite vertex d, or from the previous new vertex
+		int newVertex(int original, int a, int b, int d)
+		{
+			const int v = numDecoded();
+			if (v >= m_numVertices) {
+				m_ok = false;
+				return 0;
+			}
+			int64_t prediction[3] = { 0, 0, 0 };
+			for (int k = 0; k < 3; ++k) {
+				if (d >= 0)
+					prediction[k] = quantized[3 * a + k] + quantized[3 * b + k] - quantized[3 * d + k];
+				else if (v > 0)
+					prediction[k] = quantized[3 * (v - 1) + k];
+			}
+			const int context = d >= 0 ? 0 : 1;
+			for (int k = 0; k < 3; ++k) {
+				int64_t residual = m_src ? m_src->quantized[3 * original + k] - prediction[k] : 0;
+				residual = unzigzag(codeUInt(m_geom, m_residual[context][k], zigzag(residual)));
+				quantized.push_back(prediction[k] + residual);
+			}
+			if (m_src) {
+				m_src->newOfVertex[original] = v;
+				m_src->vertexOrder.push_back(original);
+			}
+			return v;
+		}
+
+		void addFace(int v0, int v1, int v2, bool spawned, bool thirdNew)
+		{
+			if (v0 == v1 || v1 == v2 || v2 == v0) {
+				m_ok = false;
+				return;
+			}
+			faces.push_back(v0);
+			faces.push_back(v1);
+			faces.push_back(v2);
+			m_spawned.push_back(spawned);
+			m_thirdNew.push_back(thirdNew ? 1 : 0);
+			link(v0, v1);
+			link(v1, v2);
+			link(v2, v0);
+		}
+
+		void link(int a, int b)
+		{
+			std::vector<int> & na = m_neighbours[a];
+			if (std::find(na.begin(), na.end(), b) == na.end()) na.push_back(b);
+			std::vector<int> & nb = m_neighbours[b];
+			if (std::find(nb.begin(), nb.end(), a) == nb.end()) nb.push_back(a);
+		}
+
+		Coder &							m_conn;
+		Coder &							m_geom;
+		Source *						m_src;
+		int								m_numVertices;
+		int								m_numFaces;
+		bool							m_ok;
+		std::vector<bool>				m_spawned;		//per decoded face, whether it was reached from another one
+		std::vector<char>				m_thirdNew;		//per decoded face, whether its third vertex was new
+		std::vector<std::vector<int> >	m_neighbours;	//decoded vertex neighbours, in the order they were linked
+		std::vector<int>				m_candidates;
+
+		uint16_t						m_spawn[3 * 3];
+		uint16_t						m_isNew[2];
+		uint16_t						m_candidate[2 * (maxCandidates + 1)];
+		UIntModel						m_vertexId;
+		UIntModel						m_residual[2][3];
+	};
+
+	uint64_t checksum(const std::vector<int> & faces, const std::vector<int64_t> & quantized)
+	{
+		uint64_t h = BinaryFormat::hashBytes(faces.empty() ? "" : (const char *)&faces[0], faces.size() * sizeof(int));
+		return h ^ (BinaryFormat::hashBytes(quantized.empty() ? "" : (const char *)&quantized[0], quantized.size() * sizeof(int64_t)) * 31);
+	}
+}
+
+namespace CompressedFormat
+{
+	bool encode(const double coords[], int numVertices, const int faceInds[], int numFaces, int bits,
+		std::vector<char> & out, std::vector<int> * vertexOrder, std::vector<int> * faceOrder, int numThreads)
+	{
+		if (bits < 1 || bits > maxBits) {
+			std::cerr << "Error: the quantization must use 1 to " << maxBits << " bits!" << std::endl;
+			return false;
+		}
+		Connectivity conn;
+		if (!conn.build(faceInds, numVertices, numFaces, numThreads))
+			return false;
+
+		Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, magic, sizeof(header.magic));
+		header.version = version;
+		header.byteOrder = byteOrderMark;
+		header.bits = bits;
+		header.numVertices = numVertices;
+		header.numFaces = numFaces;
+		for (int k = 0; k < 3; ++k) {
+			header.boxMin[k] = numVertices ? coords[k] : 0;
+			header.boxMax[k] = numVertices ? coords[k] : 0;
+		}
+		for (int v = 0; v < numVertices; ++v)
+			for (int k = 0; k < 3; ++k) {
+				header.boxMin[k] = std::min(header.boxMin[k], coords[3 * v + k]);
+				header.boxMax[k] = std::max(header.boxMax[k], coords[3 * v + k]);
+			}
+		const double levels = (double)((1u << bits) - 1);
+		std::vector<int64_t> quantized(3 * (size_t)numVertices);
+		for (int v = 0; v < numVertices; ++v)
+			for (int k = 0; k < 3; ++k) {
+				double extent = header.boxMax[k] - header.boxMin[k];
+				quantized[3 * v + k] = extent > 0 ? (int64_t)floor((coords[3 * v + k] - header.boxMin[k]) / extent * levels + 0.5) : 0;
+			}
+
+		Source source;
+		source.faceInds = faceInds;
+		source.heTwin = conn.heTwin.data();
+		source.quantized = quantized.data();
+		source.newOfVertex.assign(numVertices, -1);
+		source.visited.assign(numFaces, 0);
+		source.nextSeed = 0;
+		source.nextVertex = 0;
+		source.vertexOrder.reserve(numVertices);
+		source.faceOrder.reserve(numFaces);
+		source.outHe.reserve(3 * (size_t)numFaces);
+		std::vector<char> connectivity, geometry;
+		RangeEncoder connCoder(connectivity), geomCoder(geometry);
+		Traversal<RangeEncoder> traversal(connCoder, geomCoder, &source, numVertices, numFaces);
+		if (!traversal.run()) {
+			std::cerr << "Error: the mesh cannot be compressed!" << std::endl;
+			return false;
+		}
+		connCoder.flush();
+		geomCoder.flush();
+		header.connectivityBytes = connectivity.size();
+		header.geometryBytes = geometry.size();
+		header.checksum = checksum(traversal.faces, traversal.quantized);
+
+		out.resize(sizeof(header) + connectivity.size() + geometry.size());
+		memcpy(&out[0], &header, sizeof(header));
+		if (!connectivity.empty())
+			memcpy(&out[sizeof(header)], &connectivity[0], connectivity.size());
+		if (!geometry.empty())
+			memcpy(&out[sizeof(header) + connectivity.size()], &geometry[0], geometry.size());
+		if (vertexOrder)
+			vertexOrder->swap(source.vertexOrder);
+		if (faceOrder)
+			faceOrder->swap(source.faceOrder);
+		return true;
+	}
+
+	bool decode(const char * data, size_t size, std::vector<double> & coords, std::vector<int> & faceInds, std::string & error)
+	{
+		Header header;
+		if (size < sizeof(header)) {
+			error = "the file is too short";
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+		if (memcmp(header.magic, magic, sizeof(header.magic)) != 0) {
+			error = "not a compressed mesh file";
+			return false;
+		}
+		if (header.version != version || header.byteOrder != byteOrderMark) {
+			error = "unsupported version or byte order";
+			return false;
+		}
+		if (header.bits < 1 || header.bits > (uint32_t)maxBits || header.numVertices < 0 || header.numFaces < 0
+			|| header.connectivityBytes > size - sizeof(header)
+			|| header.geometryBytes != size - sizeof(header) - header.connectivityBytes) {
+			error = "bad header";
+			return false;
+		}
+		//a coded bit costs at least 0.022 bits of output: every face codes a bit, every vertex 18 bits
+		if ((uint64_t)header.numFaces > 512 * (header.connectivityBytes + 8) || (uint64_t)header.numVertices > 64 * (header.geometryBytes + 8)) {
+			error = "bad element counts";
+			return false;
+		}
+
+		const char * conn = data + sizeof(header);
+		const char * geom = conn + header.connectivityBytes;
+		RangeDecoder connCoder(conn, geom), geomCoder(geom, geom + header.geometryBytes);
+		Traversal<RangeDecoder> traversal(connCoder, geomCoder, NULL, header.numVertices, header.numFaces);
+		if (!traversal.run() || connCoder.overrun() || geomCoder.overrun()
+			|| checksum(traversal.faces, traversal.quantized) != header.checksum) {
+			error = "the data is corrupted";
+			return false;
+		}
+
+		faceInds.swap(traversal.faces);
+		coords.resize(3 * (size_t)header.numVertices);
+		const double levels = (double)((1u << header.bits) - 1);
+		for (int v = 0; v < header.numVertices; ++v)
+			for (int k = 0; k < 3; ++k)
+				coords[3 * v + k] = header.boxMin[k] + (header.boxMax[k] - header.boxMin[k]) * (traversal.quantized[3 * v + k] / levels);
+		return true;
+	}
+}
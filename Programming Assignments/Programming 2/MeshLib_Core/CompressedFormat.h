@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Compressed mesh files written by Mesh::writeCompressedFile(), for archiving and transfer.
+// A fixed Header is followed by two range-coded streams:
+//	connectivity	the faces, coded by a breadth-first traversal over the shared edges: for each face,
+//					which of its edges lead to a face not reached yet, and for each face reached, whether
+//					its third vertex is new or one of the vertices already around its gate
+//	geometry		the positions quantized to bits per axis over the bounding box, each new vertex
+//					predicted by the parallelogram rule from the face it was reached through
+// The decoded mesh lists its vertices and faces in traversal order. Its connectivity is exactly the
+// original one, and each coordinate is within half a quantization step (maxError()) of the original.
+// The checksum covers the decoded faces and quantized positions, so corrupted data is detected.
+namespace CompressedFormat
+{
+	const char		magic[8] = { 'M', 'e', 's', 'h', 'L', 'i', 'b', 'Z' };
+	const uint32_t	version = 1;
+	const uint32_t	byteOrderMark = 0x01020304;
+	const int		maxBits = 30;
+
+	struct Header
+	{
+		char		magic[8];
+		uint32_t	version;
+		uint32_t	byteOrder;
+		uint32_t	bits;				//quantization bits per axis
+		int32_t		numVertices;
+		int32_t		numFaces;
+		uint32_t	reserved;
+		double		boxMin[3];
+		double		boxMax[3];
+		uint64_t	connectivityBytes;
+		uint64_t	geometryBytes;
+		uint64_t	checksum;
+	};
+
+	//largest difference between an original coordinate on axis k and the decoded one
+	inline double maxError(const Header & header, int k)
+	{
+		return (header.boxMax[k] - header.boxMin[k]) / (double)((1u << header.bits) - 1) / 2;
+	}
+
+	//compress a triangle mesh given as xyz coordinates and vertex indices (3 per face, as in Connectivity),
+	//quantizing the positions to bits per axis (1 to maxBits). vertexOrder and faceOrder, when given,
+	//receive the original vertex of each decoded vertex and the original face of each decoded face.
+	//Returns false and reports the error when the mesh cannot be coded (bad indices, non-manifold).
+	bool encode(const double coords[], int numVertices, const int faceInds[], int numFaces, int bits,
+		std::vector<char> & out, std::vector<int> * vertexOrder = NULL, std::vector<int> * faceOrder = NULL,
+		int numThreads = 0);
+
+	//decompress [data, data + size); error tells what is wrong when it fails
+	bool decode(const char * data, size_t size, std::vector<double> & coords, std::vector<int> & faceInds,
+		std::string & error);
+}
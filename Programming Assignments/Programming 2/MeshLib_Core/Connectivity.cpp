@@ -0,0 +1,181 @@
+#include "Connectivity.h"
+#include "Parallel.h"
+#include <atomic>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+	//a halfedge sorted by its undirected vertex pair, then by its own id
+	struct PairKey
+	{
+		unsigned long long	key;	//(min vertex id, max vertex id)
+		int					he;
+	};
+
+	struct PairKeyLess
+	{
+		bool operator()(const PairKey & a, const PairKey & b) const
+		{
+			return a.key < b.key || (a.key == b.key && a.he < b.he);
+		}
+	};
+
+	inline int sourceOf(const int * faceInds, int h) { return faceInds[h - h % 3 + (h + 2) % 3]; }
+}
+
+void Connectivity::clear()
+{
+	heTwin.clear();
+	heEdge.clear();
+	heIndex.clear();
+	edgeHe.clear();
+	vertexHe.clear();
+	vertexBoundary.clear();
+}
+
+bool Connectivity::build(const int * faceInds, int numVertices, int numFaces, int numThreads)
+{
+	clear();
+	numThreads = Parallel::resolveThreadCount(numThreads);
+	const size_t nh = 3 * (size_t)numFaces;
+
+	//(1) validate the indices, reporting the first bad face like Mesh::createFace(int[]) does
+	std::vector<int> badFace(numThreads, -1);
+	Parallel::forChunks(numThreads, numThreads, [&](int c) {
+		for (size_t h = nh * c / numThreads, e = nh * (c + 1) / numThreads; h < e; ++h)
+			if (faceInds[h] < 0 || faceInds[h] >= numVertices) {
+				badFace[c] = (int)(h / 3);
+				return;
+			}
+	});
+	for (int c = 0; c < numThreads; ++c)
+		if (badFace[c] >= 0) {
+			int f = badFace[c];
+			for (int i = 0; i < 3; ++i)
+				if (faceInds[3 * f + i] < 0 || faceInds[3 * f + i] >= numVertices) {
+					std::cerr << "Error: invalid vertex id: " << faceInds[3 * f + i] << " provided when creating face "
+						<< f << " !" << std::endl;
+					break;
+				}
+			return false;
+		}
+
+	//(2) sort the halfedges by undirected vertex pair so that the halfedges of an edge are adjacent
+	std::vector<PairKey> keys(nh);
+	Parallel::forRange(nh, numThreads, [&](size_t b, size_t e) {
+		for (size_t h = b; h < e; ++h) {
+			unsigned int s = sourceOf(faceInds, (int)h), t = faceInds[h];
+			if (s > t) std::swap(s, t);
+			keys[h].key = ((unsigned long long)s << 32) | t;
+			keys[h].he = (int)h;
+		}
+	});
+	Parallel::sort(keys.empty() ? NULL : &keys[0], nh, numThreads, PairKeyLess());
+
+	//(3) pair the halfedges of every group, replaying what createFace() would do in face order:
+	//a halfedge [s,t] takes the edge of the first earlier halfedge [t,s], or starts a new edge
+	heTwin.assign(nh, -1);
+	std::vector<int> owner(nh);				//he(0) of the edge of each halfedge
+	std::vector<char> startsEdge(nh, 0);
+	std::vector<char> nonManifold(numThreads, 0);
+	Parallel::forChunks(numThreads, numThreads, [&](int c) {
+		size_t g = nh * c / numThreads, end = nh * (c + 1) / numThreads;
+		while (g > 0 && g < nh && keys[g].key == keys[g - 1].key) ++g;	//the group belongs to the previous slice
+		while (g < end) {
+			size_t ge = g + 1;
+			while (ge < nh && keys[ge].key == keys[g].key) ++ge;
+			for (size_t a = g; a < ge; ++a) {
+				int h = keys[a].he;
+				int s = sourceOf(faceInds, h), t = faceInds[h];
+				int found = -1;
+				for (size_t b = g; b < a && found < 0; ++b) {
+					int h2 = keys[b].he;
+					if (faceInds[h2] == s && sourceOf(faceInds, h2) == t)
+						found = h2;
+				}
+				if (found < 0) {
+					owner[h] = h;
+					startsEdge[h] = 1;
+				}
+				else if (heTwin[owner[found]] >= 0)	//the edge already has two halfedges
+					nonManifold[c] = 1;
+				else {
+					owner[h] = found;
+					heTwin[h] = found;
+					heTwin[found] = h;
+				}
+			}
+			g = ge;
+		}
+	});
+	for (int c = 0; c < numThreads; ++c)
+		if (nonManifold[c]) {
+			std::cerr << "Error: an edge appears more than twice. Non-manifold surfaces!" << std::endl;
+			clear();
+			return false;
+		}
+	std::vector<PairKey>().swap(keys);
+
+	//(4) edges are numbered in the order of their first halfedge
+	std::vector<int> edgeOfStart(nh);
+	int numEdges = Parallel::exclusiveScan(startsEdge.empty() ? NULL : &startsEdge[0],
+		edgeOfStart.empty() ? NULL : &edgeOfStart[0], nh, numThreads);
+	heEdge.resize(nh);
+	edgeHe.resize(2 * (size_t)numEdges);
+	Parallel::forRange(nh, numThreads, [&](size_t b, size_t e) {
+		for (size_t h = b; h < e; ++h) {
+			int edge = edgeOfStart[owner[h]];
+			heEdge[h] = edge;
+			if (startsEdge[h]) {
+				edgeHe[2 * (size_t)edge] = (int)h;
+				edgeHe[2 * (size_t)edge + 1] = heTwin[h];
+			}
+		}
+	});
+
+	//(5) halfedge indices: he(0) then he(1) of every edge, in edge order
+	std::vector<int> heCount(numEdges), heBase(numEdges);
+	Parallel::forRange(numEdges, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) heCount[i] = edgeHe[2 * i + 1] >= 0 ? 2 : 1;
+	});
+	Parallel::exclusiveScan(heCount.empty() ? NULL : &heCount[0], heBase.empty() ? NULL : &heBase[0], numEdges, numThreads);
+	heIndex.resize(nh);
+	Parallel::forRange(numEdges, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			heIndex[edgeHe[2 * i]] = heBase[i];
+			if (edgeHe[2 * i + 1] >= 0)
+				heIndex[edgeHe[2 * i + 1]] = heBase[i] + 1;
+		}
+	});
+
+	//(6) vertex halfedge (the last halfedge pointing to it, as createFace leaves it) and boundary flags
+	std::unique_ptr<std::atomic<int>[]> lastIn(new std::atomic<int>[numVertices]);
+	std::unique_ptr<std::atomic<char>[]> boundary(new std::atomic<char>[numVertices]);
+	Parallel::forRange(numVertices, numThreads, [&](size_t b, size_t e) {
+		for (size_t v = b; v < e; ++v) {
+			lastIn[v].store(-1, std::memory_order_relaxed);
+			boundary[v].store(0, std::memory_order_relaxed);
+		}
+	});
+	Parallel::forRange(nh, numThreads, [&](size_t b, size_t e) {
+		for (size_t h = b; h < e; ++h) {
+			std::atomic<int> & last = lastIn[faceInds[h]];
+			int cur = last.load(std::memory_order_relaxed);
+			while (cur < (int)h && !last.compare_exchange_weak(cur, (int)h, std::memory_order_relaxed)) {;}
+			if (heTwin[h] < 0) {
+				boundary[faceInds[h]].store(1, std::memory_order_relaxed);
+				boundary[sourceOf(faceInds, (int)h)].store(1, std::memory_order_relaxed);
+			}
+		}
+	});
+	vertexHe.resize(numVertices);
+	vertexBoundary.resize(numVertices);
+	Parallel::forRange(numVertices, numThreads, [&](size_t b, size_t e) {
+		for (size_t v = b; v < e; ++v) {
+			vertexHe[v] = lastIn[v].load(std::memory_order_relaxed);
+			vertexBoundary[v] = boundary[v].load(std::memory_order_relaxed);
+		}
+	});
+	return true;
+}
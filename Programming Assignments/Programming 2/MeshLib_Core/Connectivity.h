@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+// Index-based half-edge connectivity of a triangle mesh given as an indexed face array.
+// Halfedge h = 3*f+i is the i-th halfedge of face f: it points to faceInds[h] and comes from
+// faceInds[3*f+(i+2)%3], its next is 3*f+(i+1)%3 and its prev 3*f+(i+2)%3.
+// The arrays reproduce what Mesh::createFace() builds face after face: same edge ordering,
+// same he(0)/he(1) assignment, same halfedge indices and vertex halfedges.
+class Connectivity
+{
+public:
+	//build the connectivity with multithreaded sort/scan phases (numThreads = 0: all cores).
+	//The result does not depend on the thread count.
+	//Returns false and reports the error when an index is invalid or an edge has more than two faces;
+	//vertices with several fans (non-manifold vertices) are accepted.
+	bool build(const int * faceInds, int numVertices, int numFaces, int numThreads = 0);
+	void clear();
+
+	int numVertices() const { return (int)vertexHe.size(); }
+	int numFaces() const { return (int)heTwin.size() / 3; }
+	int numEdges() const { return (int)edgeHe.size() / 2; }
+
+	std::vector<int>	heTwin;			//twin halfedge, -1 on the boundary
+	std::vector<int>	heEdge;			//edge of each halfedge
+	std::vector<int>	heIndex;		//index() of each halfedge: edges in order, he(0) before he(1)
+	std::vector<int>	edgeHe;			//he(0), he(1) of each edge; he(1) = -1 on the boundary
+	std::vector<int>	vertexHe;		//an incoming halfedge of each vertex, -1 for an isolated vertex
+	std::vector<char>	vertexBoundary;	//whether each vertex is on the boundary
+};
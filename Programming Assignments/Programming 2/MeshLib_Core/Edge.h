@@ -1,7 +1,5 @@
 #pragma once
 
-#include <string>
-
 class Halfedge;
 
 class Edge
@@ -21,13 +19,11 @@ public:
 
 	//optional
 	int & index() {return m_propertyIndex; }
-	std::string & PropertyStr() { return m_propertyStr;}	
 		
 protected:		
 	//for Halfedge Data Structure
 	Halfedge	*	m_halfedge[2];		// for boundary edge, m_halfedge[1]=NULL
 
 	//optional
-	std::string		m_propertyStr;		// a string to store edge properties
 	int				m_propertyIndex;	// index to Property array
 };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Slab allocator for mesh elements.
+// Elements are carved out of large blocks with a bump pointer and are never freed one by one:
+// clear() runs the destructors block by block and releases the blocks at once.
+// Every slot handed out by allocate() must be constructed before clear() is called.
+template <class T>
+class ElementPool
+{
+public:
+	explicit ElementPool(size_t blockSize = 4096) : m_blockSize(blockSize), m_size(0) {;}
+	~ElementPool() { clear(); }
+
+	//a default-constructed element
+	T * create() { return new (allocate(1)) T(); }
+
+	//raw storage for n contiguous elements, to be constructed by the caller (possibly from several threads)
+	T * allocate(size_t n)
+	{
+		if (n == 0)
+			return NULL;
+		if (m_blocks.empty() || m_blocks.back().used + n > m_blocks.back().capacity) {
+			Block b;
+			b.capacity = std::max(m_blockSize, n);
+			b.used = 0;
+			b.data = static_cast<T *>(::operator new(b.capacity * sizeof(T)));
+			m_blocks.push_back(b);
+		}
+		Block & b = m_blocks.back();
+		T * p = b.data + b.used;
+		b.used += n;
+		m_size += n;
+		return p;
+	}
+
+	//destroy every element and release all the blocks
+	void clear()
+	{
+		for (size_t i = 0; i < m_blocks.size(); ++i) {
+			Block & b = m_blocks[i];
+			for (size_t j = 0; j < b.used; ++j)		//compiles to nothing when T has nothing to destroy
+				b.data[j].~T();
+			::operator delete(b.data);
+		}
+		std::vector<Block>().swap(m_blocks);
+		m_size = 0;
+	}
+
+	size_t size() const { return m_size; }
+	size_t memoryUsage() const						//bytes reserved by the blocks
+	{
+		size_t bytes = m_blocks.capacity() * sizeof(Block);
+		for (size_t i = 0; i < m_blocks.size(); ++i)
+			bytes += m_blocks[i].capacity * sizeof(T);
+		return bytes;
+	}
+
+private:
+	ElementPool(const ElementPool &);
+	ElementPool & operator=(const ElementPool &);
+
+	struct Block
+	{
+		T *		data;
+		size_t	used;
+		size_t	capacity;
+	};
+	std::vector<Block>	m_blocks;
+	size_t				m_blockSize;	//elements per block
+	size_t				m_size;			//elements handed out
+};
@@ -13,13 +13,11 @@ public:
 	
 	//optional
 	int				& index() {return m_propertyIndex; }
-	std::string		& PropertyStr() { return m_propertyStr;}
 
 protected:
 	//for Halfedge Data Structure
 	Halfedge	*	m_halfedge;
 
 	//optional	
-	std::string		m_propertyStr;
 	int				m_propertyIndex; // index to Property array
 };
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class Halfedge;
+
+// Open-addressing hash table from a directed vertex pair (source id, target id) to a halfedge.
+// Expected O(1) lookup, no per-entry allocation; used to find twins while a mesh is being built,
+// and as the vertex-pair index of Mesh::buildEdgeIndex(). find() may run on several threads at once.
+class HalfedgeHash
+{
+public:
+	HalfedgeHash() : m_size(0), m_mask(0) {;}
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	size_t memoryUsage() const { return m_slots.capacity() * sizeof(Slot); }
+
+	//make room for n entries without rehashing
+	void reserve(size_t n)
+	{
+		size_t capacity = 16;
+		while (capacity < 2 * n) capacity <<= 1;		//keep the load factor at or below 1/2
+		if (capacity > m_slots.size())
+			rehash(capacity);
+	}
+
+	//release all the entries and the memory used by the table
+	void clear()
+	{
+		std::vector<Slot>().swap(m_slots);
+		m_size = 0;
+		m_mask = 0;
+	}
+
+	//halfedge from srcId to trgId, or NULL
+	Halfedge * find(int srcId, int trgId) const
+	{
+		if (m_slots.empty()) return NULL;
+		unsigned long long k = key(srcId, trgId);
+		for (size_t i = hash(k) & m_mask; ; i = (i + 1) & m_mask) {
+			const Slot & s = m_slots[i];
+			if (!s.he) return NULL;
+			if (s.key == k) return s.he;
+		}
+	}
+
+	//announce a find(srcId, trgId) to come, so that its slot is loaded from memory meanwhile
+	void prefetch(int srcId, int trgId) const
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		if (!m_slots.empty())
+			__builtin_prefetch(&m_slots[hash(key(srcId, trgId)) & m_mask]);
+#else
+		(void)srcId; (void)trgId;
+#endif
+	}
+
+	//register he as the halfedge from srcId to trgId; the first halfedge inserted for a pair is kept
+	void insert(int srcId, int trgId, Halfedge * he)
+	{
+		if (2 * (m_size + 1) > m_slots.size())
+			rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+		place(key(srcId, trgId), he);
+	}
+
+private:
+	struct Slot
+	{
+		Slot() : key(0), he(NULL) {;}
+		unsigned long long	key;
+		Halfedge *			he;		//NULL marks an empty slot
+	};
+
+	static unsigned long long key(int srcId, int trgId)
+	{
+		return ((unsigned long long)(unsigned int)srcId << 32) | (unsigned int)trgId;
+	}
+
+	static size_t hash(unsigned long long k)
+	{
+		k ^= k >> 31;
+		k *= 0x9E3779B97F4A7C15ULL;
+		return (size_t)(k ^ (k >> 32));
+	}
+
+	bool place(unsigned long long k, Halfedge * he)
+	{
+		for (size_t i = hash(k) & m_mask; ; i = (i + 1) & m_mask) {
+			Slot & s = m_slots[i];
+			if (!s.he) {
+				s.key = k;
+				s.he = he;
+				++m_size;
+				return true;
+			}
+			if (s.key == k) return false;
+		}
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<Slot> old;
+		old.swap(m_slots);
+		m_slots.resize(capacity);
+		m_mask = capacity - 1;
+		m_size = 0;
+		for (size_t i = 0; i < old.size(); ++i)
+			if (old[i].he)
+				place(old[i].key, old[i].he);
+	}
+
+	std::vector<Slot>	m_slots;
+	size_t				m_size;
+	size_t				m_mask;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include "Face.h"
+#include "Halfedge.h"
+
+// Every halfedge of a mesh as a random-access range, in slot order: halfedge 3 * f + j is corner j of face f,
+// corner 2 being f->he() (the order of Connectivity, not that of MeshHalfedgeIterator).
+// The iterators compute the halfedge when dereferenced, so operator* returns a Halfedge * by value.
+//
+//		for (Halfedge * he : mesh.halfedges()) ...
+//		std::for_each(std::execution::par, mesh.halfedges().begin(), mesh.halfedges().end(), kernel);
+class MeshHalfedgeRange
+{
+public:
+	class iterator
+	{
+	public:
+		typedef std::random_access_iterator_tag	iterator_category;
+		typedef Halfedge *						value_type;
+		typedef std::ptrdiff_t					difference_type;
+		typedef Halfedge * const *				pointer;
+		typedef Halfedge *						reference;
+
+		iterator() : m_faces(0), m_slot(0) {;}
+		iterator(Face * const * faces, std::ptrdiff_t slot) : m_faces(faces), m_slot(slot) {;}
+
+		Halfedge * operator*() const
+		{
+			Halfedge * he = m_faces[m_slot / 3]->he();
+			int corner = (int)(m_slot % 3);
+			return corner == 2 ? he : corner == 0 ? he->next() : he->prev();
+		}
+		Halfedge * operator[](std::ptrdiff_t n) const { return *(*this + n); }
+
+		iterator &	operator++()		{ ++m_slot; return *this; }
+		iterator	operator++(int)		{ iterator it = *this; ++m_slot; return it; }
+		iterator &	operator--()		{ --m_slot; return *this; }
+		iterator	operator--(int)		{ iterator it = *this; --m_slot; return it; }
+		iterator &	operator+=(std::ptrdiff_t n)	{ m_slot += n; return *this; }
+		iterator &	operator-=(std::ptrdiff_t n)	{ m_slot -= n; return *this; }
+		iterator	operator+(std::ptrdiff_t n) const	{ return iterator(m_faces, m_slot + n); }
+		iterator	operator-(std::ptrdiff_t n) const	{ return iterator(m_faces, m_slot - n); }
+		friend iterator	operator+(std::ptrdiff_t n, const iterator & it)	{ return it + n; }
+		std::ptrdiff_t	operator-(const iterator & it) const	{ return m_slot - it.m_slot; }
+
+		bool operator==(const iterator & it) const	{ return m_slot == it.m_slot; }
+		bool operator!=(const iterator & it) const	{ return m_slot != it.m_slot; }
+		bool operator<(const iterator & it) const	{ return m_slot < it.m_slot; }
+		bool operator>(const iterator & it) const	{ return m_slot > it.m_slot; }
+		bool operator<=(const iterator & it) const	{ return m_slot <= it.m_slot; }
+		bool operator>=(const iterator & it) const	{ return m_slot >= it.m_slot; }
+
+	private:
+		Face * const *	m_faces;
+		std::ptrdiff_t	m_slot;
+	};
+	typedef iterator const_iterator;
+
+	explicit MeshHalfedgeRange(const std::vector<Face *> & faces) : m_faces(faces.empty() ? 0 : &faces[0]), m_size(3 * faces.size()) {;}
+
+	iterator	begin() const	{ return iterator(m_faces, 0); }
+	iterator	end() const		{ return iterator(m_faces, (std::ptrdiff_t)m_size); }
+	size_t		size() const	{ return m_size; }
+	bool		empty() const	{ return m_size == 0; }
+	Halfedge *	operator[](size_t slot) const { return begin()[(std::ptrdiff_t)slot]; }
+
+private:
+	Face * const *	m_faces;
+	size_t			m_size;
+};
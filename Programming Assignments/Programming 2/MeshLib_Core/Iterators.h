@@ -1,5 +1,9 @@
 #pragma once 
 
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
 #include "Vertex.h"
 #include "Mesh.h"
 
@@ -16,58 +20,70 @@ VertexVertexIterator
 VertexEdgeIterator
 VertexOutHalfedgeIterator
 VertexInHalfedgeIterator
+The same traversals as standard ranges: Mesh::vertices(), edges(), faces() and halfedges(), and the
+circulator ranges at the end of this file (faceVertices(f), vertexVertices(v), ...)
 ******************/
 
+//Handle types of the pointer-based Mesh kernel.
+//The circulators below are templates over such a kernel so that they also work on CompactMesh.
+struct PointerKernel
+{
+	typedef Vertex *	VertexHandle;
+	typedef Halfedge *	HalfedgeHandle;
+	typedef Edge *		EdgeHandle;
+	typedef Face *		FaceHandle;
+};
+
 // Enumerating all the vertices
 class MeshVertexIterator
 {
 public:
-	MeshVertexIterator(Mesh * cmesh) :m_Mesh(cmesh){ m_iter = m_Mesh->m_verts.begin(); }
+	MeshVertexIterator(const Mesh * cmesh) :m_Mesh(cmesh){ m_iter = m_Mesh->m_verts.begin(); }
 	Vertex * value() { return *m_iter; }
 	void operator++() { ++m_iter; }
 	bool end() { return m_iter == m_Mesh->m_verts.end(); }
 	Vertex * operator*(){ return value(); }
 	void reset() { m_iter = m_Mesh->m_verts.begin(); }
 private:
-	std::vector<Vertex *>::iterator m_iter;
-	Mesh * m_Mesh;
+	std::vector<Vertex *>::const_iterator m_iter;
+	const Mesh * m_Mesh;
 };
 
 // Enumerating all the faces
 class MeshFaceIterator
 {
 public:
-	MeshFaceIterator(Mesh * cmesh ):m_Mesh(cmesh){ m_iter = m_Mesh->m_faces.begin(); }
+	MeshFaceIterator(const Mesh * cmesh ):m_Mesh(cmesh){ m_iter = m_Mesh->m_faces.begin(); }
 	Face * value() { return *m_iter; }
 	void operator++() { ++m_iter;}
 	bool end() { return m_iter == m_Mesh->m_faces.end(); }
 	Face * operator*(){ return value(); }
 	void reset() { m_iter = m_Mesh->m_faces.begin();}
 private:	
-	Mesh * m_Mesh;
-	std::vector<Face *>::iterator m_iter;
+	const Mesh * m_Mesh;
+	std::vector<Face *>::const_iterator m_iter;
 };
 
 // Enumerating all the edges
 class MeshEdgeIterator
 {
 public:
-	MeshEdgeIterator(Mesh * cmesh ):m_Mesh(cmesh){m_iter = m_Mesh->m_edges.begin();}
+	MeshEdgeIterator(const Mesh * cmesh ):m_Mesh(cmesh){m_iter = m_Mesh->m_edges.begin();}
 	Edge * value() {  return *m_iter; };
 	void operator++() { ++m_iter;}
 	bool end() { return m_iter == m_Mesh->m_edges.end(); }
 	Edge * operator*(){ return value(); }
 	void reset() { m_iter = m_Mesh->m_edges.begin();}
 private:		
-	Mesh * m_Mesh;
-	std::vector<Edge *>::iterator m_iter;
+	const Mesh * m_Mesh;
+	std::vector<Edge *>::const_iterator m_iter;
 };
 
 // Enumerating all the halfedges
 class MeshHalfedgeIterator
 {
 public:
-	MeshHalfedgeIterator( Mesh * cmesh ):m_Mesh(cmesh){ m_id = 0; m_iter = m_Mesh->m_edges.begin(); }
+	MeshHalfedgeIterator(const Mesh * cmesh ):m_Mesh(cmesh){ m_id = 0; m_iter = m_Mesh->m_edges.begin(); }
 	Halfedge * value() {
 		Edge * e = *m_iter; 
 		return e->he(m_id); 
@@ -90,79 +106,109 @@ public:
 	Halfedge * operator*(){ return value(); };
 	void reset() { m_id = 0; m_iter = m_Mesh->m_edges.begin();};
 private:		
-	Mesh * m_Mesh;
-	std::vector<Edge *>::iterator m_iter;
+	const Mesh * m_Mesh;
+	std::vector<Edge *>::const_iterator m_iter;
 	int  m_id;
 };
 
 
 // f -> vertex
-class FaceVertexIterator
+template <class K>
+class FaceVertexIteratorT
 {
 public:
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
 
-	FaceVertexIterator( Face * f ){ m_face = f; m_halfedge = f->he(); }
-	~FaceVertexIterator(){;}
+	FaceVertexIteratorT() : m_face(), m_halfedge() {;}
+	FaceVertexIteratorT( FaceHandle f ){ m_face = f; m_halfedge = f->he(); }
+	~FaceVertexIteratorT(){;}
 	void operator++()	{
 		m_halfedge = m_halfedge->next();
 		if( m_halfedge == m_face->he() )
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 	}
-	Vertex * value() { return m_halfedge->target(); }
-	Vertex * operator*() { return value(); };
-	bool end(){ return (!m_halfedge); };
+	VertexHandle value() const { return m_halfedge->target(); }
+	VertexHandle operator*() const { return value(); };
+	bool end() const { return (!m_halfedge); };
 private:
-	Face *     m_face;
-	Halfedge * m_halfedge;
+	FaceHandle		m_face;
+	HalfedgeHandle	m_halfedge;
 };
+typedef FaceVertexIteratorT<PointerKernel> FaceVertexIterator;
 
 
 // f -> halfedge
-class FaceHalfedgeIterator
+template <class K>
+class FaceHalfedgeIteratorT
 {
 public:
-	FaceHalfedgeIterator( Face * f ){ m_face = f; m_halfedge = f->he(); }
-	~FaceHalfedgeIterator(){;}
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
+
+	FaceHalfedgeIteratorT() : m_face(), m_halfedge() {;}
+	FaceHalfedgeIteratorT( FaceHandle f ){ m_face = f; m_halfedge = f->he(); }
+	~FaceHalfedgeIteratorT(){;}
 	void operator++(){
 		m_halfedge = m_halfedge->next();
 		if( m_halfedge == m_face->he() )
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 	}
-	Halfedge * value() { return m_halfedge; };
-	Halfedge * operator*() { return value(); };
-	bool end(){ return (!m_halfedge); };
+	HalfedgeHandle value() const { return m_halfedge; };
+	HalfedgeHandle operator*() const { return value(); };
+	bool end() const { return (!m_halfedge); };
 private:
-	Face *     m_face;
-	Halfedge * m_halfedge;
+	FaceHandle		m_face;
+	HalfedgeHandle	m_halfedge;
 };
+typedef FaceHalfedgeIteratorT<PointerKernel> FaceHalfedgeIterator;
 
 
 // f -> edge
-class FaceEdgeIterator
+template <class K>
+class FaceEdgeIteratorT
 {
 public:
-	FaceEdgeIterator( Face * f ){ m_face = f; m_halfedge = f->he(); }
-	~FaceEdgeIterator(){;}
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
+
+	FaceEdgeIteratorT() : m_face(), m_halfedge() {;}
+	FaceEdgeIteratorT( FaceHandle f ){ m_face = f; m_halfedge = f->he(); }
+	~FaceEdgeIteratorT(){;}
 
 	void operator++(){
 		m_halfedge = m_halfedge->next();
 		if( m_halfedge == m_face->he() )
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 	}
 
-	Edge * value() { return m_halfedge->edge(); };
-	Edge * operator*() { return value(); };
-	bool end(){ return (!m_halfedge); };
+	EdgeHandle value() const { return m_halfedge->edge(); };
+	EdgeHandle operator*() const { return value(); };
+	bool end() const { return (!m_halfedge); };
 private:
-	Face *     m_face;
-	Halfedge * m_halfedge;
+	FaceHandle		m_face;
+	HalfedgeHandle	m_halfedge;
 };
+typedef FaceEdgeIteratorT<PointerKernel> FaceEdgeIterator;
 
 
-class VertexVertexIterator
+template <class K>
+class VertexVertexIteratorT
 {
 public:
-	VertexVertexIterator( Vertex *  v ){ 
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
+
+	VertexVertexIteratorT() : m_vertex(), m_halfedge(), end_he() {;}
+	VertexVertexIteratorT( VertexHandle v ){ 
 		m_vertex = v; 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
 		if (!m_vertex->boundary())
@@ -170,26 +216,26 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_in_halfedge();
 	}
-	~VertexVertexIterator(){;}
+	~VertexVertexIteratorT(){;}
 	void operator++(){
 		if (m_halfedge == end_he )
 		{
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 			return;
 		}
 		m_halfedge = m_halfedge->ccw_rotate_about_source();
-		if( m_halfedge == NULL )
+		if( !m_halfedge )
 			m_halfedge = end_he; 
 	}
-	Vertex * value() 
+	VertexHandle value() const
 	{ 
 		if( m_vertex->boundary() && m_halfedge == end_he )
 			return end_he->source();
 		else
 			return m_halfedge->target(); 
 	}
-	Vertex * operator*() { return value(); }
-	bool end(){ return !m_halfedge; }
+	VertexHandle operator*() const { return value(); }
+	bool end() const { return !m_halfedge; }
 	void reset() { 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
 		if (!m_vertex->boundary())
@@ -198,15 +244,24 @@ public:
 			end_he= m_vertex->most_ccw_in_halfedge();
 	}
 private:
-	Vertex	 * m_vertex;
-	Halfedge * m_halfedge;
-	Halfedge * end_he;
+	VertexHandle	m_vertex;
+	HalfedgeHandle	m_halfedge;
+	HalfedgeHandle	end_he;
 };
+typedef VertexVertexIteratorT<PointerKernel> VertexVertexIterator;
+
 
-class VertexEdgeIterator
+template <class K>
+class VertexEdgeIteratorT
 {
 public:
-	VertexEdgeIterator( Vertex *  v ){ 
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
+
+	VertexEdgeIteratorT() : m_vertex(), m_halfedge(), end_he() {;}
+	VertexEdgeIteratorT( VertexHandle v ){ 
 		m_vertex = v; 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
 		if (!m_vertex->boundary())
@@ -214,26 +269,26 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_in_halfedge();
 	}
-	~VertexEdgeIterator(){;}
+	~VertexEdgeIteratorT(){;}
 	void operator++()
 	{
 		if (m_halfedge == end_he )
 		{
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 			return;
 		}
 		m_halfedge = m_halfedge->ccw_rotate_about_source();
-		if( m_halfedge == NULL )
+		if( !m_halfedge )
 			m_halfedge = end_he; 
 	}
-	Edge * value() 
+	EdgeHandle value() const
 	{ 
 		return m_halfedge->edge();
 	}
 
-	Edge * operator*() { return value(); }
+	EdgeHandle operator*() const { return value(); }
 
-	bool end(){ return (!m_halfedge); }
+	bool end() const { return (!m_halfedge); }
 	void reset()	{ 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
 		if (!m_vertex->boundary())
@@ -242,16 +297,25 @@ public:
 			end_he= m_vertex->most_ccw_in_halfedge();	
 	}
 private:
-	Vertex	 * m_vertex;
-	Halfedge * m_halfedge;
-	Halfedge * end_he;
+	VertexHandle	m_vertex;
+	HalfedgeHandle	m_halfedge;
+	HalfedgeHandle	end_he;
 
 };
+typedef VertexEdgeIteratorT<PointerKernel> VertexEdgeIterator;
+
 
-class VertexFaceIterator
+template <class K>
+class VertexFaceIteratorT
 {
 public:
-	VertexFaceIterator( Vertex * v )
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
+
+	VertexFaceIteratorT() : m_vertex(), m_halfedge(), end_he() {;}
+	VertexFaceIteratorT( VertexHandle v )
 	{ 
 		m_vertex = v; 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
@@ -260,18 +324,18 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_out_halfedge();
 	}
-	~VertexFaceIterator(){;}
+	~VertexFaceIteratorT(){;}
 	void operator++(){
 		if (m_halfedge == end_he )
 		{
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 			return;
 		}
 		m_halfedge = m_halfedge->ccw_rotate_about_source();
 	}
-	Face * value() { return m_halfedge->face(); };
-	Face * operator*() { return value(); };
-	bool end(){ return (!m_halfedge); };
+	FaceHandle value() const { return m_halfedge->face(); };
+	FaceHandle operator*() const { return value(); };
+	bool end() const { return (!m_halfedge); };
 	void reset()	{ 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
 		if (!m_vertex->boundary())
@@ -279,15 +343,24 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_out_halfedge(); }
 private:
-	Vertex	 * m_vertex;
-	Halfedge * m_halfedge;
-	Halfedge * end_he;
+	VertexHandle	m_vertex;
+	HalfedgeHandle	m_halfedge;
+	HalfedgeHandle	end_he;
 };
+typedef VertexFaceIteratorT<PointerKernel> VertexFaceIterator;
+
 
-class VertexOutHalfedgeIterator
+template <class K>
+class VertexOutHalfedgeIteratorT
 {
 public:
-	VertexOutHalfedgeIterator(Vertex * v ){ 
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
+
+	VertexOutHalfedgeIteratorT() : m_vertex(), m_halfedge(), end_he() {;}
+	VertexOutHalfedgeIteratorT(VertexHandle v ){ 
 		m_vertex = v; 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
 		if (!m_vertex->boundary())
@@ -295,16 +368,16 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_out_halfedge();
 	}
-	~VertexOutHalfedgeIterator(){;}
+	~VertexOutHalfedgeIteratorT(){;}
 	void operator++(){
 		if (m_halfedge == end_he )
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 		else
 			m_halfedge = m_halfedge->ccw_rotate_about_source();
 	}
-	Halfedge * value() { return m_halfedge; }
-	bool end(){ return (!m_halfedge); }
-	Halfedge * operator*() { return value(); }
+	HalfedgeHandle value() const { return m_halfedge; }
+	bool end() const { return (!m_halfedge); }
+	HalfedgeHandle operator*() const { return value(); }
 	void reset()	{ 
 		m_halfedge = m_vertex->most_clw_out_halfedge();
 		if (!m_vertex->boundary())
@@ -312,15 +385,24 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_out_halfedge(); }
 private:
-	Vertex *   m_vertex;
-	Halfedge * m_halfedge;	
-	Halfedge * end_he;
+	VertexHandle	m_vertex;
+	HalfedgeHandle	m_halfedge;
+	HalfedgeHandle	end_he;
 };
+typedef VertexOutHalfedgeIteratorT<PointerKernel> VertexOutHalfedgeIterator;
+
 
-class VertexInHalfedgeIterator
+template <class K>
+class VertexInHalfedgeIteratorT
 {
 public:
-	VertexInHalfedgeIterator(Vertex * v ){ 
+	typedef typename K::VertexHandle	VertexHandle;
+	typedef typename K::HalfedgeHandle	HalfedgeHandle;
+	typedef typename K::EdgeHandle		EdgeHandle;
+	typedef typename K::FaceHandle		FaceHandle;
+
+	VertexInHalfedgeIteratorT() : m_vertex(), m_halfedge(), end_he() {;}
+	VertexInHalfedgeIteratorT(VertexHandle v ){ 
 		m_vertex = v; 
 		m_halfedge = m_vertex->most_clw_in_halfedge();
 		if (!m_vertex->boundary())
@@ -328,16 +410,16 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_in_halfedge();
 	}
-	~VertexInHalfedgeIterator(){;}
+	~VertexInHalfedgeIteratorT(){;}
 	void operator++()	{
 		if (m_halfedge == end_he )
-			m_halfedge = NULL;
+			m_halfedge = HalfedgeHandle();
 		else
 			m_halfedge = m_halfedge->ccw_rotate_about_target();
 	}
-	Halfedge * value() { return m_halfedge; }
-	bool end(){ return (!m_halfedge); }
-	Halfedge * operator*() { return value(); }
+	HalfedgeHandle value() const { return m_halfedge; }
+	bool end() const { return (!m_halfedge); }
+	HalfedgeHandle operator*() const { return value(); }
 	void reset()	{ 
 		m_halfedge = m_vertex->most_clw_in_halfedge();
 		if (!m_vertex->boundary())
@@ -345,8 +427,71 @@ public:
 		else 
 			end_he= m_vertex->most_ccw_in_halfedge(); }
 private:
-	Vertex *   m_vertex;
-	Halfedge * m_halfedge;
-	Halfedge * end_he;
+	VertexHandle	m_vertex;
+	HalfedgeHandle	m_halfedge;
+	HalfedgeHandle	end_he;
+};
+typedef VertexInHalfedgeIteratorT<PointerKernel> VertexInHalfedgeIterator;
+
+
+//Forward iterator over a circulator above, for range-for loops and the standard algorithms;
+//the default-constructed iterator is the end of every circulation
+template <class C>
+class CirculatorIterator
+{
+public:
+	typedef std::forward_iterator_tag					iterator_category;
+	typedef typename std::decay<decltype(std::declval<const C &>().value())>::type	value_type;
+	typedef std::ptrdiff_t								difference_type;
+	typedef const value_type *							pointer;
+	typedef const value_type &							reference;
+
+	CirculatorIterator() : m_step(-1) {;}
+	explicit CirculatorIterator(const C & circulator) : m_circulator(circulator), m_step(0) { load(); }
+
+	reference	operator*() const	{ return m_value; }
+	pointer		operator->() const	{ return &m_value; }
+	CirculatorIterator &	operator++()	{ ++m_circulator; ++m_step; load(); return *this; }
+	CirculatorIterator		operator++(int)	{ CirculatorIterator it = *this; ++*this; return it; }
+	//iterators of the same circulation are equal when they have taken as many steps
+	bool operator==(const CirculatorIterator & it) const	{ return m_step == it.m_step; }
+	bool operator!=(const CirculatorIterator & it) const	{ return m_step != it.m_step; }
+
+private:
+	void load()
+	{
+		if (m_circulator.end())
+			m_step = -1;
+		else
+			m_value = m_circulator.value();
+	}
+
+	C			m_circulator;
+	value_type	m_value;
+	int			m_step;
+};
+
+//The elements around element e, as a forward range: for (Vertex * w : vertexVertices(v)) ...
+template <class C, class E>
+class CirculatorRange
+{
+public:
+	typedef CirculatorIterator<C>	iterator;
+	typedef iterator				const_iterator;
+
+	explicit CirculatorRange(E e) : m_element(e) {;}
+	iterator	begin() const	{ return iterator(C(m_element)); }
+	iterator	end() const		{ return iterator(); }
+
+private:
+	E	m_element;
 };
 
+inline CirculatorRange<FaceVertexIterator, Face *>			faceVertices(Face * f)			{ return CirculatorRange<FaceVertexIterator, Face *>(f); }
+inline CirculatorRange<FaceHalfedgeIterator, Face *>		faceHalfedges(Face * f)			{ return CirculatorRange<FaceHalfedgeIterator, Face *>(f); }
+inline CirculatorRange<FaceEdgeIterator, Face *>			faceEdges(Face * f)				{ return CirculatorRange<FaceEdgeIterator, Face *>(f); }
+inline CirculatorRange<VertexVertexIterator, Vertex *>		vertexVertices(Vertex * v)		{ return CirculatorRange<VertexVertexIterator, Vertex *>(v); }
+inline CirculatorRange<VertexEdgeIterator, Vertex *>		vertexEdges(Vertex * v)			{ return CirculatorRange<VertexEdgeIterator, Vertex *>(v); }
+inline CirculatorRange<VertexFaceIterator, Vertex *>		vertexFaces(Vertex * v)			{ return CirculatorRange<VertexFaceIterator, Vertex *>(v); }
+inline CirculatorRange<VertexOutHalfedgeIterator, Vertex *>	vertexOutHalfedges(Vertex * v)	{ return CirculatorRange<VertexOutHalfedgeIterator, Vertex *>(v); }
+inline CirculatorRange<VertexInHalfedgeIterator, Vertex *>	vertexInHalfedges(Vertex * v)	{ return CirculatorRange<VertexInHalfedgeIterator, Vertex *>(v); }
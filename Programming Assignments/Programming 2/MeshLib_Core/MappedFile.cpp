@@ -0,0 +1,122 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char s_emptyFile[1] = { 0 };
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : m_data(0), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(0) {;}
+
+bool MappedFile::open(const char path[])
+{
+	close();
+	m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size)) {
+		close();
+		return false;
+	}
+	m_size = (size_t)size.QuadPart;
+	if (m_size == 0) {	//an empty file cannot be mapped
+		m_data = s_emptyFile;
+		return true;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping)
+		m_data = (const char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data && m_data != s_emptyFile)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_data = 0;
+	m_size = 0;
+	m_mapping = 0;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+void MappedFile::release(const char * begin, const char * end)
+{
+	if (m_data && m_data != s_emptyFile && begin < end)
+		VirtualUnlock((LPVOID)begin, end - begin);	//unlocking unlocked pages removes them from the working set
+}
+
+#else
+
+MappedFile::MappedFile() : m_data(0), m_size(0), m_fd(-1) {;}
+
+bool MappedFile::open(const char path[])
+{
+	close();
+	m_fd = ::open(path, O_RDONLY);
+	if (m_fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(m_fd, &st) != 0) {
+		close();
+		return false;
+	}
+	m_size = (size_t)st.st_size;
+	if (m_size == 0) {	//an empty file cannot be mapped
+		m_data = s_emptyFile;
+		return true;
+	}
+
+	void * p = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (p == MAP_FAILED) {
+		close();
+		return false;
+	}
+	madvise(p, m_size, MADV_SEQUENTIAL);	//the readers scan the file front to back
+	m_data = (const char *)p;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data && m_data != s_emptyFile)
+		munmap((void *)m_data, m_size);
+	if (m_fd >= 0)
+		::close(m_fd);
+	m_data = 0;
+	m_size = 0;
+	m_fd = -1;
+}
+
+void MappedFile::release(const char * begin, const char * end)
+{
+	if (!m_data || m_data == s_emptyFile)
+		return;
+	//whole pages only: the ones at the ends may still be needed
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t first = (begin - m_data + page - 1) / page * page, last = (end - m_data) / page * page;
+	if (first < last)
+		madvise((void *)(m_data + first), last - first, MADV_DONTNEED);
+}
+
+#endif
+
+MappedFile::~MappedFile() { close(); }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only view of a whole file, memory-mapped when the platform allows it.
+// The view stays valid until close() or destruction.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char path[]);		//map the file, return false if it cannot be opened
+	void close();
+	//drop the pages of [begin, end) from memory after a front to back scan went past them;
+	//they are read again from the file if they are accessed later
+	void release(const char * begin, const char * end);
+
+	const char *	data() const { return m_data; }
+	const char *	end() const  { return m_data + m_size; }
+	size_t			size() const { return m_size; }
+
+private:
+	MappedFile(const MappedFile &);				//not copyable
+	MappedFile & operator=(const MappedFile &);
+
+	const char *	m_data;
+	size_t			m_size;
+#ifdef _WIN32
+	void *			m_file;
+	void *			m_mapping;
+#else
+	int				m_fd;
+#endif
+};
@@ -1,43 +1,71 @@
 #include "Mesh.h"
+#include "BinaryFormat.h"
+#include "CompressedFormat.h"
+#include "Connectivity.h"
+#include "MappedFile.h"
+#include "MeshAttributes.h"
+#include "Parallel.h"
+#include "PLYFormat.h"
+#include "TextFormat.h"
+#include "TextParse.h"
+#include "VertexWeld.h"
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <limits>
 #include <string>
 
 #pragma warning (disable : 4996)
 #pragma warning (disable : 4018)
 
-Mesh::Mesh() {;}
+Mesh::Mesh() : m_edgeIndex(false), m_topologyRevision(0), m_geometryRevision(0), m_movedSince(0), m_derived(0) {;}
 
-Mesh::~Mesh(){clear();}
+Mesh::~Mesh(){clear(); delete m_derived;}
 
 void Mesh::clear(){
-	for (std::vector<Face *>::iterator fiter = m_faces.begin(); fiter!=m_faces.end(); ++fiter)
-	{
-		Face * f = *fiter;
-		delete f;
-	}
-	for (std::vector<Edge *>::iterator eiter = m_edges.begin(); eiter!=m_edges.end(); ++eiter)
-	{
-		Edge * e = *eiter;
-		Halfedge * he1 = e->he(0);
-		Halfedge * he2 = e->he(1);
-		delete he1;
-		if (he2) delete he2;
-		delete e;
-	}
-	for (std::vector<Vertex *>::iterator viter = m_verts.begin(); viter!=m_verts.end(); ++viter)
-	{
-		Vertex * v = *viter;
-		delete v;
-	}
+	//the elements are owned by the pools, which release them block by block
+	m_vertPool.clear();
+	m_edgePool.clear();
+	m_facePool.clear();
+	m_hePool.clear();
 	m_verts.clear();
 	m_edges.clear();
 	m_faces.clear();
+	m_vertProps.clear();
+	m_edgeProps.clear();
+	m_faceProps.clear();
+	m_vertAttrs.resize(0);
+	m_edgeAttrs.resize(0);
+	m_faceAttrs.resize(0);
+	m_heAttrs.resize(0);
+	m_heHash.clear();
+	m_edgeIndex = false;
+	m_moved.clear();
+	m_movedFlags.clear();
+	topologyChanged();
+}
+
+size_t Mesh::memoryUsage()
+{
+	size_t bytes = sizeof(Mesh)
+		+ (m_verts.capacity() + m_edges.capacity() + m_faces.capacity()) * sizeof(void *)
+		+ m_vertPool.memoryUsage() + m_edgePool.memoryUsage() + m_facePool.memoryUsage() + m_hePool.memoryUsage()
+		+ m_vertProps.memoryUsage() + m_edgeProps.memoryUsage() + m_faceProps.memoryUsage()
+		+ m_vertAttrs.memoryUsage() + m_edgeAttrs.memoryUsage() + m_faceAttrs.memoryUsage() + m_heAttrs.memoryUsage()
+		+ m_heHash.memoryUsage()
+		+ m_moved.capacity() * sizeof(int) + m_movedFlags.capacity() + (m_derived ? sizeof(MeshAttributes) : 0);
+	return bytes;
 }
 
 Edge * Mesh::vertexEdge( Vertex * v0, Vertex * v1 )
 {
+	if (m_edgeIndex) {
+		Halfedge * he = m_heHash.find(v0->index(), v1->index());
+		if (!he) he = m_heHash.find(v1->index(), v0->index());
+		return he ? he->edge() : NULL;
+	}
 	//First, check the right most side
 	Halfedge * he0 = v0->most_clw_out_halfedge();
 	if(he0->target() == v1)
@@ -63,6 +91,13 @@ Edge * Mesh::vertexEdge( Vertex * v0, Vertex * v1 )
 
 Edge * Mesh::idEdge( int id0, int id1 )
 {
+	if (m_edgeIndex) {	//the ids are the keys: the vertices are not needed
+		if ((unsigned int)id0 >= m_verts.size() || (unsigned int)id1 >= m_verts.size())
+			return NULL;
+		Halfedge * he = m_heHash.find(id0, id1);
+		if (!he) he = m_heHash.find(id1, id0);
+		return he ? he->edge() : NULL;
+	}
 	Vertex * v0 = indVertex(id0);
 	Vertex * v1 = indVertex(id1);
 	if (!v0 || !v1)
@@ -73,6 +108,8 @@ Edge * Mesh::idEdge( int id0, int id1 )
 
 Halfedge * Mesh::vertexHalfedge( Vertex * v0, Vertex * v1 )
 {
+	if (m_edgeIndex)
+		return m_heHash.find(v0->index(), v1->index());
 	Halfedge * he0 = v0->most_clw_out_halfedge();
 	if(he0->target() == v1)	return he0;
 
@@ -88,6 +125,8 @@ Halfedge * Mesh::vertexHalfedge( Vertex * v0, Vertex * v1 )
 
 Halfedge * Mesh::idHalfedge( int srcVID, int trgVID )
 { //Check the surrounding outgoing half-edges from the source vertex
+	if (m_edgeIndex)
+		return (unsigned int)srcVID < m_verts.size() && (unsigned int)trgVID < m_verts.size() ? m_heHash.find(srcVID, trgVID) : NULL;
 	Vertex * v0 = indVertex(srcVID);
 	Vertex * v1 = indVertex(trgVID);
 	if (!v0 || !v1)
@@ -96,40 +135,138 @@ Halfedge * Mesh::idHalfedge( int srcVID, int trgVID )
 		return vertexHalfedge(v0,v1);
 }
 
+//queries announced to the index ahead of the one being answered, to overlap their cache misses
+static const size_t s_prefetchDistance = 16;
+
+void Mesh::idEdges(const int pairs[], size_t count, Edge * edges[], int numThreads)
+{
+	//the queries only read the mesh (and the index), so they can run side by side
+	Parallel::forRange(count, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			if (m_edgeIndex && i + s_prefetchDistance < e) {
+				const int * p = &pairs[2 * (i + s_prefetchDistance)];
+				m_heHash.prefetch(p[0], p[1]);
+				m_heHash.prefetch(p[1], p[0]);
+			}
+			edges[i] = idEdge(pairs[2 * i], pairs[2 * i + 1]);
+		}
+	});
+}
+
+void Mesh::idHalfedges(const int pairs[], size_t count, Halfedge * halfedges[], int numThreads)
+{
+	Parallel::forRange(count, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			if (m_edgeIndex && i + s_prefetchDistance < e)
+				m_heHash.prefetch(pairs[2 * (i + s_prefetchDistance)], pairs[2 * (i + s_prefetchDistance) + 1]);
+			halfedges[i] = idHalfedge(pairs[2 * i], pairs[2 * i + 1]);
+		}
+	});
+}
+
+void Mesh::markMoved(Vertex * v)
+{
+	if (m_movedFlags.size() < m_verts.size())
+		m_movedFlags.resize(m_verts.size(), 0);
+	++m_geometryRevision;
+	char & flag = m_movedFlags[v->index()];
+	if (!flag) {
+		flag = 1;
+		m_moved.push_back(v->index());
+	}
+}
+
+void Mesh::clearMoved()
+{
+	for (size_t i = 0; i < m_moved.size(); ++i)
+		m_movedFlags[m_moved[i]] = 0;
+	m_moved.clear();
+	m_movedSince = m_geometryRevision;
+}
+
+void Mesh::geometryChanged()
+{
+	++m_geometryRevision;
+	clearMoved();
+}
+
+void Mesh::topologyChanged()
+{
+	++m_topologyRevision;
+	geometryChanged();
+}
+
+MeshAttributes & Mesh::derived()
+{
+	if (!m_derived)
+		m_derived = new MeshAttributes(*this);
+	return *m_derived;
+}
+
+void Mesh::hashHalfedges()
+{
+	m_heHash.clear();
+	m_heHash.reserve(3 * m_faces.size());
+	for (size_t f = 0; f < m_faces.size(); ++f) {
+		Halfedge * he = m_faces[f]->he();
+		for (int j = 0; j < 3; ++j, he = he->next())
+			m_heHash.insert(he->source()->index(), he->target()->index(), he);
+	}
+}
+
+void Mesh::buildEdgeIndex()
+{
+	hashHalfedges();
+	m_edgeIndex = true;
+}
+
+void Mesh::clearEdgeIndex()
+{
+	m_heHash.clear();
+	m_edgeIndex = false;
+}
+
 
 
 //create new geometric simplexes
 
 Vertex * Mesh::createVertex()
 {
-	Vertex * v = new Vertex;		
+	Vertex * v = m_vertPool.create();
 	v->index()= m_verts.size();	
 	m_verts.push_back( v );
+	topologyChanged();
+	m_vertAttrs.resize(m_verts.size());
 	return v;
 }
 
 
 Face * Mesh::createFace()
 {
-	Face * f = new Face();
+	Face * f = m_facePool.create();
 	f->index() = m_faces.size();
 	m_faces.push_back(f);
+	topologyChanged();
+	m_faceAttrs.resize(m_faces.size());
+	m_heAttrs.resize(3 * m_faces.size());
 	return f;
 }
 
 Edge * Mesh::createEdge()
 {
-	Edge * e = new Edge();
+	Edge * e = m_edgePool.create();
 	e->index()=m_edges.size();
 	m_edges.push_back( e );
+	m_edgeAttrs.resize(m_edges.size());
 	return e;
 }
 
 Edge * Mesh::createEdge(Halfedge * he0, Halfedge * he1)
 {
-	Edge * e = new Edge(he0, he1);
+	Edge * e = new (m_edgePool.allocate(1)) Edge(he0, he1);
 	e->index()=m_edges.size();
 	m_edges.push_back( e );
+	m_edgeAttrs.resize(m_edges.size());
 	return e;
 }
 
@@ -154,16 +291,18 @@ Face * Mesh::createFace( int v[3] )
 Face * Mesh::createFace( Vertex * verts[3] )
 {		
 	int i;
+	//the table of the faces so far, released by LabelBoundaryVertices() when the edge index is off
+	if (m_heHash.empty() && !m_faces.empty())
+		hashHalfedges();
 	Face * f = createFace();	
 	//create Half-edges
 	Halfedge * hes[3];
 	for(i = 0; i < 3; i ++ )
 	{
-		hes[i] = new Halfedge;
+		hes[i] = m_hePool.create();
 		hes[i]->target() = verts[i];
 		verts[i]->he() = hes[i];
-		std::vector<Halfedge *> & adjInHEList = v_adjInHEList[verts[i]->index()];
-		adjInHEList.push_back(hes[i]);
+		verts[i]->boundaryHe() = NULL;
 	}
 	//linking to each other, and linking to the face
 	for( i = 0; i < 3; i ++ )
@@ -173,6 +312,9 @@ Face * Mesh::createFace( Vertex * verts[3] )
 		hes[i]->face() = f;
 		f->he() = hes[i];
 	}
+	//registering the new halfedges [source, target] so that their twins can find them
+	for( i = 0; i < 3; i ++ )
+		m_heHash.insert(verts[(i+2)%3]->index(), verts[i]->index(), hes[i]);
 	//Linking these halfedges with edges
 	for( i = 0; i < 3; i ++ )
 	{
@@ -182,18 +324,10 @@ Face * Mesh::createFace( Vertex * verts[3] )
 		//The new halfedge is [ev1, ev0]:
 		//			should we generate a new edge with these two vertices? 
 		//			not necessary: if [ev0, ev1] was an existing halfedge
-		//So, we shall check whether halfedge [ev0,ev1] was created and added into the mesh before, 
-		//		We had the container of one-ring incoming half-edges of ev1
-		std::vector<Halfedge *> & adjInHEList = v_adjInHEList[ev1->index()];
-		for (int j=0; j<adjInHEList.size(); ++j)
-		{
-			Halfedge * he = adjInHEList[j];
-			if (he->source() == ev0)
-			{
-				e = he->edge();
-				break;
-			}
-		}		
+		//So, we shall check whether halfedge [ev0,ev1] was created and added into the mesh before
+		Halfedge * he = m_heHash.find(ev0->index(), ev1->index());
+		if (he)
+			e = he->edge();
 		if (e) { // [ev0, ev1] exists hence the edge exists
 			if (!(e->he(1)))
 				e->he(1) = hes[i];
@@ -210,6 +344,98 @@ Face * Mesh::createFace( Vertex * verts[3] )
 	return f;
 }
 
+bool Mesh::buildFromArrays(const double coords[], int numVertices, const int faceInds[], int numFaces, int numThreads)
+{
+	clear();
+	Connectivity conn;
+	if (!conn.build(faceInds, numVertices, numFaces, numThreads))
+		return false;
+	buildElements(coords, numVertices, faceInds, numFaces, conn.numEdges(), conn.heEdge.data(), conn.heIndex.data(),
+		conn.edgeHe.data(), conn.vertexHe.data(), conn.vertexBoundary.data(), numThreads);
+	return true;
+}
+
+void Mesh::allocateElements(int numVertices, int numEdges, int numFaces, std::vector<Halfedge *> & hes, int numThreads)
+{
+	const size_t nh = 3 * (size_t)numFaces;
+	hes.resize(nh);
+	Vertex * verts = m_vertPool.allocate(numVertices);
+	Face * faces = m_facePool.allocate(numFaces);
+	Edge * edges = m_edgePool.allocate(numEdges);
+	Halfedge * halfedges = m_hePool.allocate(nh);
+	m_verts.resize(numVertices);
+	m_faces.resize(numFaces);
+	m_edges.resize(numEdges);
+	Parallel::forRange(numVertices, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Vertex * v = new (verts + i) Vertex;
+			v->index() = (int)i;
+			m_verts[i] = v;
+		}
+	});
+	Parallel::forRange(numFaces, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Face * f = new (faces + i) Face;
+			f->index() = (int)i;
+			m_faces[i] = f;
+			for (int j = 0; j < 3; ++j)
+				hes[3 * i + j] = new (halfedges + 3 * i + j) Halfedge;
+		}
+	});
+	Parallel::forRange(numEdges, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Edge * edge = new (edges + i) Edge;
+			edge->index() = (int)i;
+			m_edges[i] = edge;
+		}
+	});
+	m_vertAttrs.resize(numVertices);
+	m_edgeAttrs.resize(numEdges);
+	m_faceAttrs.resize(numFaces);
+	m_heAttrs.resize(nh);
+}
+
+void Mesh::buildElements(const double coords[], int numVertices, const int faceInds[], int numFaces, int numEdges,
+	const int heEdge[], const int heIndex[], const int edgeHe[], const int vertexHe[], const char vertexBoundary[],
+	int numThreads)
+{
+	//allocate every element, then link them; each phase is split over the threads
+	std::vector<Halfedge *> hes;
+	allocateElements(numVertices, numEdges, numFaces, hes, numThreads);
+	Parallel::forRange(numVertices, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Vertex * v = m_verts[i];
+			v->point() = MeshPoint(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+			int he = vertexHe[i];
+			v->he() = he >= 0 ? hes[he] : NULL;
+			v->boundary() = vertexBoundary[i] != 0;
+		}
+	});
+	Parallel::forRange(numFaces, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Face * f = m_faces[i];
+			for (int j = 0; j < 3; ++j) {
+				Halfedge * he = hes[3 * i + j];
+				he->target() = m_verts[faceInds[3 * i + j]];
+				he->next() = hes[3 * i + (j + 1) % 3];
+				he->prev() = hes[3 * i + (j + 2) % 3];
+				he->face() = f;
+				he->edge() = m_edges[heEdge[3 * i + j]];
+				he->index() = heIndex[3 * i + j];
+			}
+			f->he() = hes[3 * i + 2];
+		}
+	});
+	Parallel::forRange(numEdges, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			int he1 = edgeHe[2 * i + 1];
+			m_edges[i]->he(0) = hes[edgeHe[2 * i]];
+			m_edges[i]->he(1) = he1 >= 0 ? hes[he1] : NULL;
+		}
+	});
+	linkBoundaryHalfedges(numThreads);
+}
+
 void Mesh::LabelBoundaryVertices()
 {// we should do this once, after the half-edge data structure has been created
 	for( std::vector<Edge *>::iterator eiter = m_edges.begin(); 	eiter!=m_edges.end(); ++eiter)
@@ -224,11 +450,76 @@ void Mesh::LabelBoundaryVertices()
 			he[0]->source()->boundary() = true;
 		}
 	}	
+	linkBoundaryHalfedges(1);
+	//the twins are all found: the halfedge table was only kept for them unless it is the edge index
+	if (!m_edgeIndex)
+		m_heHash.clear();
 }
 
-bool Mesh::readMFile( const char inputFile[])
+void Mesh::linkBoundaryHalfedges(int numThreads)
+{
+	//walk each fan once here rather than in every circulation; a vertex with several fans (non-manifold)
+	//keeps the one of its current he(), as the walks did, unless that fan is closed: the circulations of a
+	//boundary vertex run from one boundary halfedge to the other and would never end there
+	std::vector<char> closed(m_verts.size(), 0);
+	Parallel::forRange(m_verts.size(), numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Vertex * v = m_verts[i];
+			if (!v->boundary() || !v->he() || v->boundaryHe())
+				continue;
+			Halfedge * in = v->most_ccw_in_halfedge();
+			Halfedge * out = v->most_clw_out_halfedge();
+			if (!in->twin() && !out->twin()) {
+				v->he() = in;
+				v->boundaryHe() = out;
+			}
+			else
+				closed[i] = 1;
+		}
+	});
+	if (std::find(closed.begin(), closed.end(), 1) == closed.end())
+		return;
+
+	//these few take the last boundary halfedge coming in, in face order, and the fan it opens
+	for (size_t i = 0; i < m_faces.size(); ++i) {
+		Halfedge * he = m_faces[i]->he();
+		for (int j = 0; j < 3; ++j, he = he->next())
+			if (!he->twin() && closed[he->target()->index()])
+				he->target()->he() = he;
+	}
+	for (size_t i = 0; i < m_verts.size(); ++i) {
+		Vertex * v = m_verts[i];
+		if (closed[i] && !v->he()->twin()) {
+			v->he() = v->most_ccw_in_halfedge();
+			v->boundaryHe() = v->most_clw_out_halfedge();
+		}
+	}
+}
+
+//size and hash of a text mesh file, to tell whether a binary cache was made from it
+static bool sourceSignature(const char inputFile[], unsigned long long & size, unsigned long long & hash)
+{
+	MappedFile file;
+	if (!file.open(inputFile))
+		return false;
+	size = file.size();
+	hash = BinaryFormat::hashFile(file.data(), file.size());
+	return true;
+}
+
+bool Mesh::readMFile( const char inputFile[], bool useCache)
 {	
 	std::cout << "Reading mesh " << inputFile << " ...";
+	unsigned long long sourceSize = 0, sourceHash = 0;
+	std::string cacheFile;
+	if (useCache && sourceSignature(inputFile, sourceSize, sourceHash)) {
+		cacheFile = BinaryFormat::cachePath(inputFile);
+		if (loadBinaryFile(cacheFile.c_str(), true, sourceSize, sourceHash)) {
+			printf("Done! (from %s)\n", cacheFile.c_str());
+			return true;
+		}
+	}
+
 	FILE * fp = fopen( inputFile, "r" );
 	if( !fp ){
 		std::cerr << "Can't open file " << inputFile << "!" <<std::endl;
@@ -238,6 +529,11 @@ bool Mesh::readMFile( const char inputFile[])
 	char line[1024];
 	clear();
 
+	//collect the elements first, then build the half-edge data structure from them
+	std::vector<double> coords;
+	std::vector<int> faceInds;
+	std::vector<std::pair<int, std::string> > vertexProps, faceProps;
+
 	while(!feof(fp)){	
 		fgets(line, 1024, fp);
 		if(!strlen(line)) continue;
@@ -245,20 +541,15 @@ bool Mesh::readMFile( const char inputFile[])
 		if (!str) continue;
 
 		if( !strcmp(str, "Vertex" ) ){ //parsing a line of vertex element
-			str = strtok(NULL," \r\n{");
-			int id = atoi( str );
-			Vertex * v  = createVertex(); // Note: the index in M File starts with 1, while our default index starts with 0
+			str = strtok(NULL," \r\n{");		//the id: vertices are numbered in file order
+			int vid = (int)(coords.size() / 3); // Note: the index in M File starts with 1, while our default index starts with 0
 			
 			//parsing (x,y,z)
 			for( int i = 0 ; i < 3; i ++ ){
 				str = strtok(NULL," \r\n{");
-				v->point()[i] = atof( str );
+				coords.push_back( atof( str ) );
 			}
 
-			//Storing the neighboring halfedges, for efficient edge searching in the initialization stage
-			std::vector<Halfedge *> heList; 
-			v_adjInHEList.push_back(heList);
-
 			//parsing the property string 
 			str = strtok( NULL, "\r\n");
 			if(!str || strlen( str ) == 0) continue;
@@ -266,21 +557,19 @@ bool Mesh::readMFile( const char inputFile[])
 			int sp = s.find("{");
 			int ep = s.find("}");
 			if( sp >= 0 && ep >= 0 )
-				v->PropertyStr() = s.substr( sp+1, ep-sp-1 );
+				vertexProps.push_back( std::make_pair(vid, s.substr( sp+1, ep-sp-1 )) );
 			continue;
 		}
 		else if( !strcmp(str,"Face") ){ //parsing a line of face element
 			
 			str = strtok(NULL, " \r\n");
 			if( !str || strlen( str ) == 0 ) continue;
-			int id = atoi( str );
-			int vids[3];
+			int fid = (int)(faceInds.size() / 3);
 			for( int i = 0; i < 3; i ++ )
 			{
 				str = strtok(NULL," \r\n{");
-				vids[i] = atoi(str) -1; //Note: the index in M File starts with 1, while our default index starts with 0
+				faceInds.push_back( atoi(str) -1 ); //Note: the index in M File starts with 1, while our default index starts with 0
 			}
-			Face * f = createFace( vids );  
 			if (!str) continue;
 			str = strtok( NULL, "\r\n");
 			if( !str || strlen( str ) == 0 ) continue;
@@ -288,111 +577,239 @@ bool Mesh::readMFile( const char inputFile[])
 			int sp = s.find("{");
 			int ep = s.find("}");
 			if( sp >= 0 && ep >= 0 )
-				f->PropertyStr() = s.substr( sp+1, ep-sp-1 );
+				faceProps.push_back( std::make_pair(fid, s.substr( sp+1, ep-sp-1 )) );
 			continue;
 		}
 	}
-	
-	LabelBoundaryVertices();
-
 	fclose(fp);
 
-	int heInd = 0;
-	for (std::vector<Edge*>::iterator eit = m_edges.begin(); eit != m_edges.end(); ++eit){
-		Edge * e = *eit;
-		Halfedge * he0 = e->he(0);
-		he0->index() = heInd++;
-		Halfedge * he1 = e->he(1);
-		if (he1)
-			he1->index() = heInd++;
-	}
-
-	//After initialization, the neighboring halfedges list is not needed anymore; remove them to save space
-	for (int i=0;i<v_adjInHEList.size();++i)
-		v_adjInHEList[i].clear();
-	v_adjInHEList.clear();
+	if (!buildFromArrays(coords.empty() ? NULL : &coords[0], (int)(coords.size() / 3),
+		faceInds.empty() ? NULL : &faceInds[0], (int)(faceInds.size() / 3)))
+		return false;
+	for (size_t i = 0; i < vertexProps.size(); ++i)
+		m_vertProps.set(vertexProps[i].first, vertexProps[i].second);
+	for (size_t i = 0; i < faceProps.size(); ++i)
+		m_faceProps.set(faceProps[i].first, faceProps[i].second);
+	if (!cacheFile.empty())
+		saveBinaryFile(cacheFile.c_str(), sourceSize, sourceHash);
 
 	printf("Done!\n");
 	return true;
 }
 
-bool Mesh::readOBJFile(const char inputFile[])
+namespace
 {
-	std::cout << "Reading mesh " << inputFile << " ...\n";
-	FILE * fp = fopen(inputFile, "r");
-	if (!fp) {
+	//the vertices and faces of one piece of an OBJ file
+	struct OBJChunk
+	{
+		std::vector<double>	coords;
+		std::vector<int>	faceInds;
+		std::vector<size_t>	relative;	//entries of faceInds given relative to the end of the vertex list ("f -3 -2 -1"),
+										//stored from the first vertex of the chunk until the chunk offsets are known
+		size_t				skipped;	//face lines with fewer than 3 vertex indices
+
+		OBJChunk() : skipped(0) {;}
+	};
+}
+
+//parse the lines of [p, end), which has to start at the beginning of a line
+static void parseOBJChunk(const char * p, const char * end, OBJChunk & chunk)
+{
+	std::vector<double> coords;
+	std::vector<int> faceInds;
+	while (p < end) {
+		p = TextParse::skipBlanks(p, end);
+		if (p + 1 < end && TextParse::isBlank(p[1])) {
+			if (p[0] == 'v') { //parsing a line of vertex element
+				p += 2;
+				for (int i = 0; i < 3; i++) {
+					double x;
+					p = TextParse::skipBlanks(p, end);
+					p = TextParse::parseDouble(p, end, x);
+					p = TextParse::skipToken(p, end);
+					coords.push_back(x);
+				}
+			}
+			else if (p[0] == 'f') { //parsing a line of face element, only the vertex index of each "v/vt/vn" token is used
+				p += 2;
+				int vids[3], n = 0;
+				for (; n < 3; n++) {
+					p = TextParse::skipBlanks(p, end);
+					p = TextParse::parseInt(p, end, vids[n]);
+					p = TextParse::skipToken(p, end);
+					if (vids[n] == 0) //no index here: the line ended, or the token is not one (indices start at 1 or -1)
+						break;
+				}
+				if (n < 3) {
+					++chunk.skipped;
+					p = TextParse::nextLine(p, end);
+					continue;
+				}
+				for (int i = 0; i < 3; i++) {
+					if (vids[i] < 0) { //-1 is the last vertex read so far
+						chunk.relative.push_back(faceInds.size());
+						faceInds.push_back((int)(coords.size() / 3) + vids[i]);
+					}
+					else
+						faceInds.push_back(vids[i] - 1); //Note: the index in OBJ File starts with 1, while C++ array index starts with 0
+				}
+			}
+		}
+		p = TextParse::nextLine(p, end);
+	}
+	chunk.coords.swap(coords);
+	chunk.faceInds.swap(faceInds);
+}
+
+bool Mesh::parseOBJFile(const char inputFile[], std::vector<double> & coords, std::vector<int> & faceInds, size_t * fileSize, int numThreads)
+{
+	MappedFile file;
+	if (!file.open(inputFile)) {
 		std::cerr << "Can't open file " << inputFile << "!" << std::endl;
 		return false;
 	}
+	if (fileSize)
+		*fileSize = file.size();
 
-	char line[1024];
-	clear();
-	int id = 1;
+	//split the mapped file at line boundaries; each chunk is parsed in a single pass on its own thread
+	numThreads = Parallel::resolveThreadCount(numThreads);
+	const size_t size = file.size();
+	const int numChunks = numThreads == 1 || size < ((size_t)1 << 20) ? 1 : 4 * numThreads;
+	std::vector<const char *> bounds(numChunks + 1);
+	bounds[0] = file.data();
+	bounds[numChunks] = file.end();
+	for (int c = 1; c < numChunks; ++c) {
+		const char * q = file.data() + size * c / numChunks;
+		if (q[-1] != '\n')
+			q = TextParse::nextLine(q, file.end());
+		bounds[c] = std::max(q, bounds[c - 1]);
+	}
+	std::vector<OBJChunk> chunks(numChunks);
+	Parallel::forChunks(numChunks, numThreads, [&](int c) {
+		parseOBJChunk(bounds[c], bounds[c + 1], chunks[c]);
+	});
 
-	while (!feof(fp)) {
-		fgets(line, 1024, fp);
-		if (!strlen(line)) continue;
-		char * str = strtok(line, " \r\n");
-		if (!str) continue;
-		if (!strcmp(str, "v")) { //parsing a line of vertex element
-			Vertex * v = createVertex();
-			for (int i = 0; i < 3; i++) {
-				str = strtok(NULL, " \r\n{");
-				v->point()[i] = atof(str);
-			}
-			std::vector<Halfedge *> heList; //storing the neighboring halfedges, for efficient edge searching in the initialization stage
-			v_adjInHEList.push_back(heList);
-			id++;
-		}
+	//concatenate the chunks in file order, turning relative indices into global ones
+	std::vector<size_t> coordOffsets(numChunks + 1, 0), faceOffsets(numChunks + 1, 0);
+	for (int c = 0; c < numChunks; ++c) {
+		coordOffsets[c + 1] = coordOffsets[c] + chunks[c].coords.size();
+		faceOffsets[c + 1] = faceOffsets[c] + chunks[c].faceInds.size();
+	}
+	if (numChunks == 1) {
+		coords.swap(chunks[0].coords);
+		faceInds.swap(chunks[0].faceInds);
 	}
+	else {
+		coords.resize(coordOffsets[numChunks]);
+		faceInds.resize(faceOffsets[numChunks]);
+		Parallel::forChunks(numChunks, numThreads, [&](int c) {
+			OBJChunk & chunk = chunks[c];
+			std::copy(chunk.coords.begin(), chunk.coords.end(), coords.begin() + coordOffsets[c]);
+			std::copy(chunk.faceInds.begin(), chunk.faceInds.end(), faceInds.begin() + faceOffsets[c]);
+			std::vector<double>().swap(chunk.coords);
+			std::vector<int>().swap(chunk.faceInds);
+		});
+	}
+	size_t skipped = 0;
+	for (int c = 0; c < numChunks; ++c) {
+		for (size_t i = 0; i < chunks[c].relative.size(); ++i)
+			faceInds[faceOffsets[c] + chunks[c].relative[i]] += (int)(coordOffsets[c] / 3);
+		skipped += chunks[c].skipped;
+	}
+	if (skipped)
+		std::cerr << "Warning: " << skipped << " face line(s) with fewer than 3 vertices skipped in " << inputFile << std::endl;
+	return true;
+}
 
-	bool lastLineDuplicate = false;
-	fp = fopen(inputFile, "r");
-	while (1) {
-		fgets(line, 1024, fp);
-		if (!strlen(line)) continue;
-		if (feof(fp)) break;
-		char * str = strtok(line, " \r\n");
-		if (!str) continue;
-		if (!strcmp(str, "f")) { //parsing a line of face element
-			int fvInds[3];
-			for (int i = 0; i < 3; i++)
-			{
-				str = strtok(NULL, " \r\n{");
-				if (!str) continue;
-				std::string v_id(str);
-				int slash_pos = v_id.find_first_of('/');
-				v_id = v_id.substr(0, slash_pos);
-				fvInds[i] = atoi(v_id.c_str()) - 1; //Note: the index in OBJ File starts with 1, while C++ array index starts with 0
-			}
-			Face * f = createFace(fvInds);
+bool Mesh::readOBJFile(const char inputFile[], bool useCache, int numThreads)
+{
+	std::cout << "Reading mesh " << inputFile << " ...\n";
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	unsigned long long sourceSize = 0, sourceHash = 0;
+	std::string cacheFile;
+	if (useCache && sourceSignature(inputFile, sourceSize, sourceHash)) {
+		cacheFile = BinaryFormat::cachePath(inputFile);
+		if (loadBinaryFile(cacheFile.c_str(), true, sourceSize, sourceHash)) {
+			printf("Done! (from %s, %.3f s in total)\n", cacheFile.c_str(),
+				std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+			return true;
 		}
-		if (feof(fp)) break;
 	}
-	LabelBoundaryVertices();
+	std::vector<double> coords;
+	std::vector<int> faceInds;
+	size_t fileSize = 0;
+	if (!parseOBJFile(inputFile, coords, faceInds, &fileSize, numThreads))
+		return false;
+	double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 
-	fclose(fp);
+	if (!buildFromArrays(coords.empty() ? NULL : &coords[0], (int)(coords.size() / 3),
+		faceInds.empty() ? NULL : &faceInds[0], (int)(faceInds.size() / 3), numThreads))
+		return false;
 
-	int heInd = 0;
-	for (std::vector<Edge*>::iterator eit = m_edges.begin(); eit != m_edges.end(); ++eit){
-		Edge * e = *eit;
-		Halfedge * he0 = e->he(0);
-		he0->index() = heInd++;
-		Halfedge * he1 = e->he(1);
-		if (he1)
-			he1->index() = heInd++;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	double megabytes = fileSize / (1024.0 * 1024.0);
+	printf("Done! (%.2f MB parsed at %.1f MB/s, %.3f s in total)\n", megabytes,
+		parseSeconds > 0 ? megabytes / parseSeconds : 0.0, seconds);
+	if (!cacheFile.empty())
+		saveBinaryFile(cacheFile.c_str(), sourceSize, sourceHash);
+	return true;
+}
+
+//write the lines of elements [0, n) to fp, format(buffer, i) appending the line of element i.
+//Blocks of elements are formatted on numThreads threads at a time, then written in order.
+template <class F>
+static bool writeLines(FILE * fp, size_t n, int numThreads, F format)
+{
+	const size_t blockSize = 1 << 15;
+	numThreads = Parallel::resolveThreadCount(numThreads);
+	std::vector<TextFormat::Buffer> buffers(numThreads);
+	for (size_t begin = 0; begin < n; begin += blockSize * numThreads) {
+		int numBlocks = (int)std::min((size_t)numThreads, (n - begin + blockSize - 1) / blockSize);
+		Parallel::forChunks(numBlocks, numThreads, [&](int c) {
+			TextFormat::Buffer & buffer = buffers[c];
+			buffer.clear();
+			for (size_t i = begin + c * blockSize, e = std::min(n, begin + (c + 1) * blockSize); i < e; ++i)
+				format(buffer, i);
+		});
+		for (int c = 0; c < numBlocks; ++c)
+			if (fwrite(buffers[c].data(), 1, buffers[c].size(), fp) != buffers[c].size())
+				return false;
 	}
+	return true;
+}
 
-	//After initialization, the adjacent halfedge list is not necessary; remove them to save space
-	for (unsigned int i = 0; i<v_adjInHEList.size(); ++i)
-		v_adjInHEList[i].clear();
-	v_adjInHEList.clear();
+//the three vertex indices of a face (starting from 1), in the order the writers list them
+static inline char * writeFaceVertices(char * p, Face * face)
+{
+	Halfedge * the0 = face->he();
+	Halfedge * the1 = the0->next();
+	p = TextFormat::writeInt(p, the0->source()->index() + 1);
+	p = TextFormat::writeChar(p, ' ');
+	p = TextFormat::writeInt(p, the0->target()->index() + 1);
+	p = TextFormat::writeChar(p, ' ');
+	return TextFormat::writeInt(p, the1->target()->index() + 1);
+}
 
-	std::cout << "Done!\n";
-	return true;
+//" x y z " with the output precision (6 digits)
+static inline char * writePoint(char * p, const MeshPoint & point)
+{
+	for (int k = 0; k < 3; ++k) {
+		p = TextFormat::writeChar(p, ' ');
+		p = TextFormat::writeFixed(p, point[k], 6);
+	}
+	return TextFormat::writeChar(p, ' ');
+}
+
+static inline void appendProperty(TextFormat::Buffer & buffer, const std::string & prop)
+{
+	if (prop.empty()) return;
+	char * p = buffer.reserve(prop.size() + 2);
+	p = TextFormat::writeChar(p, '{');
+	memcpy(p, prop.data(), prop.size());
+	buffer.commit(TextFormat::writeChar(p + prop.size(), '}'));
 }
 
-bool Mesh::writeMFile( const char outputFile[] )
+bool Mesh::writeMFile( const char outputFile[], int numThreads )
 {
 	FILE * fp = fopen( outputFile,"w");
 	if ( !fp ){
@@ -401,39 +818,35 @@ bool Mesh::writeMFile( const char outputFile[] )
 	}
 
 	std::cout << "Writing mesh "<< outputFile <<" ...";
-	std::vector<Vertex *>::iterator vit;
-	for (vit=m_verts.begin(); vit!=m_verts.end(); ++vit){
-		Vertex * ver = *vit;
-		std::ostringstream oss;
-		oss.precision(6); oss.setf(std::ios::fixed,std::ios::floatfield);  //setting the output precision: now 6
-		oss << "Vertex " << ver->index()+1 << " " << ver->point()[0] << " " << ver->point()[1] << " " << ver->point()[2];
-		fprintf(fp, "%s ", oss.str().c_str());
-		if (ver->PropertyStr().size() > 0)
-			fprintf(fp, "{%s}", ver->PropertyStr().c_str() );
-		fprintf(fp, "\n");
-	}
-
-	std::vector<Face *>::iterator fit;
-	for (fit=m_faces.begin(); fit!=m_faces.end(); ++fit)
-	{
-		Face * face = *fit;
-		Halfedge * the0 = face->he();
-		Halfedge * the1 = the0->next();
-		int v0 = the0->source()->index() + 1;
-		int v1 = the0->target()->index() + 1;
-		int v2 = the1->target()->index() + 1;
-		fprintf(fp, "Face %d %d %d %d ", face->index() + 1, v0, v1, v2);
-		if (face->PropertyStr().size() > 0)
-			fprintf(fp, "{%s}", face->PropertyStr().c_str() );
-		fprintf(fp, "\n");
-	}
+	bool ok = writeLines(fp, m_verts.size(), numThreads, [&](TextFormat::Buffer & buffer, size_t i) {
+		Vertex * ver = m_verts[i];
+		char * p = buffer.reserve(16 + 3 * TextFormat::maxFixedChars);
+		p = TextFormat::writeString(p, "Vertex ");
+		p = TextFormat::writeInt(p, ver->index() + 1);
+		buffer.commit(writePoint(p, ver->point()));
+		appendProperty(buffer, PropertyStr(ver));
+		buffer.append("\n", 1);
+	});
+	ok = ok && writeLines(fp, m_faces.size(), numThreads, [&](TextFormat::Buffer & buffer, size_t i) {
+		Face * face = m_faces[i];
+		char * p = buffer.reserve(64);
+		p = TextFormat::writeString(p, "Face ");
+		p = TextFormat::writeInt(p, face->index() + 1);
+		p = TextFormat::writeChar(p, ' ');
+		buffer.commit(TextFormat::writeChar(writeFaceVertices(p, face), ' '));
+		appendProperty(buffer, PropertyStr(face));
+		buffer.append("\n", 1);
+	});
 
-	fclose(fp);
+	if (fclose(fp) != 0 || !ok) {
+		std::cerr << "Cannot write file " << outputFile << "!" << std::endl;
+		return false;
+	}
 	std::cout << "Done!" <<std::endl;
 	return true;
 }
 
-bool Mesh::writeOBJFile(const char outputFile[])
+bool Mesh::writeOBJFile(const char outputFile[], int numThreads)
 {
 	FILE * fp = fopen(outputFile, "w");
 	if (!fp) {
@@ -442,114 +855,941 @@ bool Mesh::writeOBJFile(const char outputFile[])
 	}
 
 	std::cout << "Writing mesh " << outputFile << " ...";
-	std::vector<Vertex *>::iterator vit;
-	for (vit = m_verts.begin(); vit != m_verts.end(); ++vit) {
-		Vertex * ver = *vit;
-		std::ostringstream oss;
-		oss.precision(6); oss.setf(std::ios::fixed, std::ios::floatfield);  //setting the output precision: now 6
-		oss << "v " << ver->point()[0] << " " << ver->point()[1] << " " << ver->point()[2];
-		fprintf(fp, "%s ", oss.str().c_str());
-		fprintf(fp, "\n");
-	}
-
-	std::vector<Face *>::iterator fit;
-	for (fit = m_faces.begin(); fit != m_faces.end(); ++fit)
-	{
-		Face * face = *fit;
-		Halfedge * the0 = face->he();
-		Halfedge * the1 = the0->next();
-		int v0 = the0->source()->index() + 1;
-		int v1 = the0->target()->index() + 1;
-		int v2 = the1->target()->index() + 1;
-		fprintf(fp, "f %d %d %d", v0, v1, v2);
-		fprintf(fp, "\n");
-	}
+	bool ok = writeLines(fp, m_verts.size(), numThreads, [&](TextFormat::Buffer & buffer, size_t i) {
+		char * p = buffer.reserve(8 + 3 * TextFormat::maxFixedChars);
+		p = TextFormat::writeChar(p, 'v');
+		p = writePoint(p, m_verts[i]->point());
+		buffer.commit(TextFormat::writeChar(p, '\n'));
+	});
+	ok = ok && writeLines(fp, m_faces.size(), numThreads, [&](TextFormat::Buffer & buffer, size_t i) {
+		char * p = buffer.reserve(48);
+		p = TextFormat::writeString(p, "f ");
+		p = writeFaceVertices(p, m_faces[i]);
+		buffer.commit(TextFormat::writeChar(p, '\n'));
+	});
 
-	fclose(fp);
+	if (fclose(fp) != 0 || !ok) {
+		std::cerr << "Cannot write file " << outputFile << "!" << std::endl;
+		return false;
+	}
 	std::cout << "Done!" << std::endl;
 	return true;
 }
 
-void Mesh::copyTo( Mesh & tMesh )
+//store the values read for an extra vertex property as an attribute of the same type
+template <class T>
+static void setAttribute(AttributeSet & attrs, const std::string & name, const std::vector<double> & values)
 {
-	std::cout << "Copying the mesh...";
+	AttributeArray<T> & attr = attrs.add<T>(name);
+	for (size_t i = 0; i < values.size() && i < attr.size(); ++i)
+		attr[(int)i] = (T)values[i];
+}
 
-	for(std::vector<Vertex *>::iterator viter = m_verts.begin();
-		viter!=m_verts.end(); ++viter)
-	{
-		Vertex * v = *viter;
-		Vertex * nv = tMesh.createVertex();
-		nv->point() = v->point();
-		nv->PropertyStr() = v->PropertyStr();
-		nv->boundary() = v->boundary();
+static void setPLYAttribute(AttributeSet & attrs, const PLYFormat::Property & prop, const std::vector<double> & values)
+{
+	switch (prop.type) {
+	case PLYFormat::Int8:		setAttribute<signed char>(attrs, prop.name, values); break;
+	case PLYFormat::UInt8:		setAttribute<unsigned char>(attrs, prop.name, values); break;
+	case PLYFormat::Int16:		setAttribute<short>(attrs, prop.name, values); break;
+	case PLYFormat::UInt16:		setAttribute<unsigned short>(attrs, prop.name, values); break;
+	case PLYFormat::Int32:		setAttribute<int>(attrs, prop.name, values); break;
+	case PLYFormat::UInt32:		setAttribute<unsigned int>(attrs, prop.name, values); break;
+	case PLYFormat::Float32:	setAttribute<float>(attrs, prop.name, values); break;
+	default:					setAttribute<double>(attrs, prop.name, values); break;
 	}
-	
-	std::vector<Face *>::iterator fiter = m_faces.begin();
-	for(;fiter!=m_faces.end(); ++fiter)
-	{
-		Face * f = *fiter;
-		Face * nf = tMesh.createFace();
-		Halfedge * he[3];
-		Halfedge * nhe[3];
-		he[0] = f->he();		he[1] = he[0]->next();		he[2] = he[1]->next();
-		for (int j=0; j<3; ++j)
-		{
-			nhe[j] = new Halfedge();
-			Vertex * v1 = he[j]->target();
-			Vertex * nv1 = tMesh.indVertex(v1->index());
-			nv1->he()=nhe[j];
-			nhe[j]->target() = nv1;
-			nhe[j]->face() = nf;
-		}
-		for (int j=0;j<3;++j)
-		{
-			nhe[j]->next()=nhe[(j+1)%3];
-			nhe[j]->prev()=nhe[(j+2)%3];
+}
+
+bool Mesh::readPLYFile(const char inputFile[], int numThreads)
+{
+	std::cout << "Reading mesh " << inputFile << " ...\n";
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.open(inputFile)) {
+		std::cerr << "Can't open file " << inputFile << "!" << std::endl;
+		return false;
+	}
+	PLYFormat::Header header;
+	std::string error;
+	if (!header.parse(file.data(), file.end(), error)) {
+		std::cerr << "Error: " << inputFile << ": " << error << "!" << std::endl;
+		return false;
+	}
+
+	//decode the elements in file order; the vertex and face records go straight into the arrays of buildFromArrays()
+	std::vector<double> coords;
+	std::vector<int> faceInds;
+	std::vector<PLYFormat::Property> extraProps;			//scalar vertex properties other than x, y, z
+	std::vector<std::vector<double> > extraValues;
+	PLYFormat::ValueReader reader(file.data() + header.size, file.end(), header.encoding);
+	bool truncated = false;
+	for (size_t e = 0; e < header.elements.size() && reader.ok() && !truncated; ++e) {
+		const PLYFormat::Element & element = header.elements[e];
+		const std::vector<PLYFormat::Property> & props = element.properties;
+		if (!props.empty() && (size_t)element.count > (size_t)(reader.end() - reader.position())) {
+			truncated = true;	//every record takes at least a byte; do not size the arrays from a bad count
+			break;
 		}
-		nf->he()=nhe[0];
-		nf->PropertyStr() = f->PropertyStr();
-	}	
+		if (element.name == "vertex" && coords.empty()) {
+			//where each property goes: 0-2 a coordinate, 3 + j the j-th extra property, -1 nowhere
+			std::vector<int> target(props.size(), -1);
+			static const char * const axes[3] = { "x", "y", "z" };
+			for (int k = 0; k < 3; ++k) {
+				int i = element.findProperty(axes[k]);
+				if (i < 0 || props[i].countType != PLYFormat::NoType) {
+					std::cerr << "Error: " << inputFile << ": the vertices have no " << axes[k] << " coordinate!" << std::endl;
+					return false;
+				}
+				target[i] = k;
+			}
+			for (size_t i = 0; i < props.size(); ++i)
+				if (target[i] < 0 && props[i].countType == PLYFormat::NoType) {
+					target[i] = 3 + (int)extraProps.size();
+					extraProps.push_back(props[i]);
+				}
+			coords.resize(3 * (size_t)element.count);
+			extraValues.assign(extraProps.size(), std::vector<double>((size_t)element.count));
+			const size_t stride = element.recordSize();
+			if (reader.binary() && stride > 0) {
+				//fixed-size records: decode them in place, in parallel
+				const char * base = reader.position();
+				if ((size_t)(reader.end() - base) / stride < (size_t)element.count) {
+					truncated = true;
+					break;
+				}
+				std::vector<size_t> offsets(props.size(), 0);
+				for (size_t i = 1; i < props.size(); ++i)
+					offsets[i] = offsets[i - 1] + PLYFormat::typeSize(props[i - 1].type);
+				const bool swap = reader.swapped();
+				Parallel::forRange((size_t)element.count, numThreads, [&](size_t begin, size_t end) {
+					for (size_t v = begin; v < end; ++v) {
+						const char * record = base + v * stride;
+						for (size_t i = 0; i < props.size(); ++i) {
+							if (target[i] < 0)
+								continue;
+							double value = PLYFormat::ValueReader::decode(record + offsets[i], props[i].type, swap);
+							if (target[i] < 3)
+								coords[3 * v + target[i]] = value;
+							else
+								extraValues[target[i] - 3][v] = value;
+						}
+					}
+				});
+				reader.seek(base + stride * (size_t)element.count);
+			}
+			else {
+				for (long long v = 0; v < element.count; ++v)
+					for (size_t i = 0; i < props.size(); ++i) {
+						if (target[i] < 0)
+							reader.skip(props[i]);
+						else if (target[i] < 3)
+							coords[3 * v + target[i]] = reader.read(props[i].type);
+						else
+							extraValues[target[i] - 3][v] = reader.read(props[i].type);
+					}
+			}
+		}
+		else if (element.name == "face" && faceInds.empty()) {
+			int list = element.findProperty("vertex_indices");
+			if (list < 0)
+				list = element.findProperty("vertex_index");
+			if (list < 0 || props[list].countType == PLYFormat::NoType) {
+				std::cerr << "Error: " << inputFile << ": the faces have no vertex_indices list!" << std::endl;
+				return false;
+			}
+			//polygons are split into a fan of triangles around their first vertex
+			faceInds.reserve(3 * (size_t)element.count);
+			if (reader.binary() && props.size() == 1) {
+				//records holding nothing but the list: decode them in place
+				const PLYFormat::Type countType = props[list].countType, indexType = props[list].type;
+				const size_t countSize = PLYFormat::typeSize(countType), indexSize = PLYFormat::typeSize(indexType);
+				const bool swap = reader.swapped();
+				const char * p = reader.position();
+				const char * end = reader.end();
+				for (long long f = 0; f < element.count && !truncated; ++f) {
+					long long n = 0;
+					if ((size_t)(end - p) >= countSize) {
+						n = (long long)PLYFormat::ValueReader::decode(p, countType, swap);
+						p += countSize;
+					}
+					else
+						truncated = true;
+					if (n < 0 || (size_t)(end - p) / indexSize < (size_t)n) {
+						truncated = true;
+						break;
+					}
+					for (long long k = 2; k < n; ++k) {
+						faceInds.push_back((int)PLYFormat::ValueReader::decode(p, indexType, swap));
+						faceInds.push_back((int)PLYFormat::ValueReader::decode(p + (k - 1) * indexSize, indexType, swap));
+						faceInds.push_back((int)PLYFormat::ValueReader::decode(p + k * indexSize, indexType, swap));
+					}
+					p += n * indexSize;
+				}
+				reader.seek(p);
+				continue;
+			}
+			std::vector<int> polygon;
+			for (long long f = 0; f < element.count && reader.ok(); ++f)
+				for (size_t i = 0; i < props.size(); ++i) {
+					if ((int)i != list) {
+						reader.skip(props[i]);
+						continue;
+					}
+					long long n = (long long)reader.read(props[i].countType);
+					polygon.clear();
+					for (long long k = 0; k < n && reader.ok(); ++k)
+						polygon.push_back((int)reader.read(props[i].type));
+					for (long long k = 2; k < n; ++k) {
+						faceInds.push_back(polygon[0]);
+						faceInds.push_back(polygon[k - 1]);
+						faceInds.push_back(polygon[k]);
+					}
+				}
+		}
+		else
+			for (long long r = 0; r < element.count && reader.ok(); ++r)
+				for (size_t i = 0; i < props.size(); ++i)
+					reader.skip(props[i]);
+	}
+	if (!reader.ok() || truncated) {
+		std::cerr << "Error: " << inputFile << ": the file is truncated!" << std::endl;
+		return false;
+	}
+	double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 
-	for(fiter = m_faces.begin();fiter!=m_faces.end(); ++fiter)
-	{
-		Face * f = *fiter;
-		Face * nf = tMesh.indFace(f->index());
-		Halfedge * he[3];
-		Halfedge * nhe[3];
-		he[0] = f->he();		he[1] = he[0]->next();		he[2] = he[1]->next();
-		nhe[0] = nf->he();		nhe[1] = nhe[0]->next();		nhe[2] = nhe[1]->next();
-		for (int i=0;i<3;++i)
-		{
-			Edge * e = he[i]->edge();
-			if (he[i]==e->he(0))
-			{
-				if (e->boundary())
-				{
-					Edge * ne = tMesh.createEdge(nhe[i], NULL);
-					nhe[i]->edge()=ne;
-					ne->PropertyStr() = e->PropertyStr();
-					continue;
+	if (!buildFromArrays(coords.empty() ? NULL : &coords[0], (int)(coords.size() / 3),
+		faceInds.empty() ? NULL : &faceInds[0], (int)(faceInds.size() / 3), numThreads))
+		return false;
+	for (size_t j = 0; j < extraProps.size(); ++j)
+		setPLYAttribute(m_vertAttrs, extraProps[j], extraValues[j]);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	double megabytes = file.size() / (1024.0 * 1024.0);
+	printf("Done! (%.2f MB parsed at %.1f MB/s, %.3f s in total)\n", megabytes,
+		parseSeconds > 0 ? megabytes / parseSeconds : 0.0, seconds);
+	return true;
+}
+
+bool Mesh::readSTLFile(const char inputFile[], double weldEpsilon, int numThreads)
+{
+	std::cout << "Reading mesh " << inputFile << " ...\n";
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.open(inputFile)) {
+		std::cerr << "Can't open file " << inputFile << "!" << std::endl;
+		return false;
+	}
+
+	//the corners of every triangle; a binary file is an 80-byte header, a uint32 triangle count and
+	//50-byte records (float normal[3], float corners[3][3], uint16 attribute), a text file starts with "solid"
+	std::vector<double> corners;
+	const char * p = file.data();
+	const char * end = file.end();
+	uint32_t count = 0;
+	if (file.size() >= 84)
+		memcpy(&count, p + 80, sizeof(count));
+	bool binary = file.size() >= 84 && (file.size() - 84) / 50 >= count
+		&& (file.size() - 84 == 50 * (size_t)count || strncmp(p, "solid", 5) != 0);
+	if (binary) {
+		corners.resize(9 * (size_t)count);
+		Parallel::forRange(count, numThreads, [&](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; ++t) {
+				const char * record = p + 84 + 50 * t + 12;
+				for (int k = 0; k < 9; ++k) {
+					float x;
+					memcpy(&x, record + 4 * k, sizeof(x));
+					corners[9 * t + k] = x;
 				}
-				//get its twin: twin_he
-				Halfedge * twin_he, * twin_nhe;
-				Face * tf = he[i]->twin()->face();
-				Face * tnf = tMesh.indFace(tf->index());
-				twin_he = tf->he();
-				twin_nhe = tnf->he();
-				for (int j=0;j<3;++j)
-				{
-					if (twin_he->edge()==e)	break;
-					twin_he = twin_he->next();
-					twin_nhe = twin_nhe->next();
+			}
+		});
+	}
+	else {
+		while (p < end) {
+			p = TextParse::skipBlanks(p, end);
+			if (end - p > 6 && strncmp(p, "vertex", 6) == 0 && TextParse::isBlank(p[6])) {
+				p += 6;
+				for (int k = 0; k < 3; ++k) {
+					double x;
+					p = TextParse::skipBlanks(p, end);
+					p = TextParse::parseDouble(p, end, x);
+					corners.push_back(x);
 				}
-				Edge * ne = tMesh.createEdge(nhe[i], twin_nhe);
-				nhe[i]->edge() = ne;
-				twin_nhe->edge() = ne;
-				ne->PropertyStr() = e->PropertyStr();
 			}
+			p = TextParse::nextLine(p, end);
+		}
+		corners.resize(corners.size() / 9 * 9);
+	}
+	const size_t numCorners = corners.size() / 3;
+
+	//weld the corners into vertices. Exact welding gives the same result both ways: with a few cores
+	//the parallel sort beats the serial hash
+	VertexWeld weld;
+	if (weldEpsilon == 0 && Parallel::resolveThreadCount(numThreads) >= 4)
+		weld.weldSorted(corners.empty() ? NULL : &corners[0], numCorners, 0, numThreads);
+	else
+		weld.weldHashed(corners.empty() ? NULL : &corners[0], numCorners, weldEpsilon);
+	std::vector<double>().swap(corners);
+
+	//triangles that lost a corner to the welding are dropped
+	std::vector<int> faceInds;
+	faceInds.reserve(numCorners);
+	for (size_t c = 0; c < numCorners; c += 3) {
+		const int * v = &weld.remap[c];
+		if (v[0] != v[1] && v[1] != v[2] && v[2] != v[0])
+			faceInds.insert(faceInds.end(), v, v + 3);
+	}
+	double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	if (!buildFromArrays(weld.vertices.empty() ? NULL : &weld.vertices[0], weld.numVertices(),
+		faceInds.empty() ? NULL : &faceInds[0], (int)(faceInds.size() / 3), numThreads))
+		return false;
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	printf("Done! (%d triangles welded into %d vertices in %.3f s, %d degenerate ones dropped, %.3f s in total)\n",
+		(int)(numCorners / 3), weld.numVertices(), parseSeconds, (int)(numCorners / 3 - faceInds.size() / 3), seconds);
+	return true;
+}
+
+//the PLY type of a vertex attribute, NoType if it is not a single number
+static PLYFormat::Type plyType(AttributeArrayBase & attr)
+{
+	if (dynamic_cast<AttributeArray<signed char> *>(&attr))		return PLYFormat::Int8;
+	if (dynamic_cast<AttributeArray<unsigned char> *>(&attr))	return PLYFormat::UInt8;
+	if (dynamic_cast<AttributeArray<short> *>(&attr))			return PLYFormat::Int16;
+	if (dynamic_cast<AttributeArray<unsigned short> *>(&attr))	return PLYFormat::UInt16;
+	if (dynamic_cast<AttributeArray<int> *>(&attr))				return PLYFormat::Int32;
+	if (dynamic_cast<AttributeArray<unsigned int> *>(&attr))	return PLYFormat::UInt32;
+	if (dynamic_cast<AttributeArray<float> *>(&attr))			return PLYFormat::Float32;
+	if (dynamic_cast<AttributeArray<double> *>(&attr))			return PLYFormat::Float64;
+	return PLYFormat::NoType;
+}
+
+//entry i of an attribute of PLY type T: the raw bytes in binary, or " value" in text
+template <class T>
+static char * writePLYValue(char * p, AttributeArrayBase * attr, size_t i, bool binary)
+{
+	T value = (*static_cast<AttributeArray<T> *>(attr))[(int)i];
+	if (binary) {
+		memcpy(p, &value, sizeof(T));
+		return p + sizeof(T);
+	}
+	p = TextFormat::writeChar(p, ' ');
+	if (!std::numeric_limits<T>::is_integer)
+		return TextFormat::writeFixed(p, (double)value, 6);
+	return TextFormat::writeInt(p, (int)value);
+}
+
+static char * writePLYValue(char * p, AttributeArrayBase * attr, PLYFormat::Type type, size_t i, bool binary)
+{
+	switch (type) {
+	case PLYFormat::Int8:		return writePLYValue<signed char>(p, attr, i, binary);
+	case PLYFormat::UInt8:		return writePLYValue<unsigned char>(p, attr, i, binary);
+	case PLYFormat::Int16:		return writePLYValue<short>(p, attr, i, binary);
+	case PLYFormat::UInt16:		return writePLYValue<unsigned short>(p, attr, i, binary);
+	case PLYFormat::Int32:		return writePLYValue<int>(p, attr, i, binary);
+	case PLYFormat::UInt32:
+		if (binary) return writePLYValue<unsigned int>(p, attr, i, binary);
+		p = TextFormat::writeChar(p, ' ');
+		return TextFormat::writeUnsigned(p, (*static_cast<AttributeArray<unsigned int> *>(attr))[(int)i]);
+	case PLYFormat::Float32:	return writePLYValue<float>(p, attr, i, binary);
+	default:					return writePLYValue<double>(p, attr, i, binary);
+	}
+}
+
+bool Mesh::writePLYFile(const char outputFile[], bool binary, int numThreads)
+{
+	FILE * fp = fopen(outputFile, "wb");
+	if (!fp) {
+		std::cerr << "Cannot open file " << outputFile << "to write!" << std::endl;
+		return false;
+	}
+
+	//the vertex attributes holding single numbers are written as extra vertex properties
+	std::vector<AttributeArrayBase *> attrs;
+	std::vector<PLYFormat::Type> attrTypes;
+	for (int a = 0; a < m_vertAttrs.numAttributes(); ++a) {
+		AttributeArrayBase & attr = m_vertAttrs.attribute(a);
+		PLYFormat::Type type = plyType(attr);
+		if (type == PLYFormat::NoType || attr.name().empty() || attr.name().find_first_of(" \t\r\n") != std::string::npos)
+			continue;
+		attrs.push_back(&attr);
+		attrTypes.push_back(type);
+	}
+
+	std::cout << "Writing mesh " << outputFile << " ...";
+	std::string header = "ply\nformat ";
+	header += !binary ? "ascii" : PLYFormat::hostIsLittleEndian() ? "binary_little_endian" : "binary_big_endian";
+	header += " 1.0\nelement vertex " + std::to_string(m_verts.size()) + "\n";
+	header += "property double x\nproperty double y\nproperty double z\n";
+	for (size_t a = 0; a < attrs.size(); ++a)
+		header += std::string("property ") + PLYFormat::typeName(attrTypes[a]) + " " + attrs[a]->name() + "\n";
+	header += "element face " + std::to_string(m_faces.size()) + "\n";
+	header += "property list uchar int vertex_indices\nend_header\n";
+	bool ok = fwrite(header.data(), 1, header.size(), fp) == header.size();
+
+	const size_t attrChars = binary ? 8 : TextFormat::maxFixedChars + 2;
+	ok = ok && writeLines(fp, m_verts.size(), numThreads, [&](TextFormat::Buffer & buffer, size_t i) {
+		char * p = buffer.reserve(4 + 3 * (TextFormat::maxFixedChars + 1) + attrs.size() * attrChars);
+		MeshPoint & point = m_verts[i]->point();
+		for (int k = 0; k < 3; ++k) {
+			double x = point[k];
+			if (binary) {
+				memcpy(p, &x, sizeof(x));
+				p += sizeof(x);
+			}
+			else {
+				if (k) p = TextFormat::writeChar(p, ' ');
+				p = TextFormat::writeFixed(p, x, 6);
+			}
+		}
+		for (size_t a = 0; a < attrs.size(); ++a)
+			p = writePLYValue(p, attrs[a], attrTypes[a], i, binary);
+		if (!binary) p = TextFormat::writeChar(p, '\n');
+		buffer.commit(p);
+	});
+	ok = ok && writeLines(fp, m_faces.size(), numThreads, [&](TextFormat::Buffer & buffer, size_t i) {
+		//the corners in the order buildFromArrays() made them, so that reading the file gives back the same halfedges
+		Halfedge * the0 = m_faces[i]->he()->next();
+		int32_t inds[3] = { the0->target()->index(), the0->next()->target()->index(), the0->source()->index() };
+		char * p = buffer.reserve(48);
+		if (binary) {
+			*p++ = 3;
+			memcpy(p, inds, sizeof(inds));
+			p += sizeof(inds);
+		}
+		else {
+			p = TextFormat::writeChar(p, '3');
+			for (int k = 0; k < 3; ++k) {
+				p = TextFormat::writeChar(p, ' ');
+				p = TextFormat::writeInt(p, inds[k]);
+			}
+			p = TextFormat::writeChar(p, '\n');
+		}
+		buffer.commit(p);
+	});
+
+	if (fclose(fp) != 0 || !ok) {
+		std::cerr << "Cannot write file " << outputFile << "!" << std::endl;
+		return false;
+	}
+	std::cout << "Done!" << std::endl;
+	return true;
+}
+
+static void writePadded(FILE * fp, const void * data, size_t bytes)
+{
+	static const char zeros[8] = { 0 };
+	if (bytes)
+		fwrite(data, 1, bytes, fp);
+	fwrite(zeros, 1, BinaryFormat::align8(bytes) - bytes, fp);
+}
+
+static void writeProperties(FILE * fp, const PropertyTable & props)
+{
+	std::vector<int> ids = props.ids();
+	uint32_t count = (uint32_t)ids.size();
+	fwrite(&count, sizeof(count), 1, fp);
+	for (size_t i = 0; i < ids.size(); ++i) {
+		const std::string & str = props.get(ids[i]);
+		int32_t id = ids[i];
+		uint32_t length = (uint32_t)str.size();
+		fwrite(&id, sizeof(id), 1, fp);
+		fwrite(&length, sizeof(length), 1, fp);
+		fwrite(str.data(), 1, length, fp);
+	}
+}
+
+//read a property section written by writeProperties, return the position after it or NULL if it is truncated
+static const char * readProperties(const char * p, const char * end, PropertyTable & props)
+{
+	uint32_t count;
+	if (end - p < (ptrdiff_t)sizeof(count)) return NULL;
+	memcpy(&count, p, sizeof(count));
+	p += sizeof(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		int32_t id;
+		uint32_t length;
+		if (end - p < (ptrdiff_t)(sizeof(id) + sizeof(length))) return NULL;
+		memcpy(&id, p, sizeof(id));
+		memcpy(&length, p + sizeof(id), sizeof(length));
+		p += sizeof(id) + sizeof(length);
+		if ((size_t)(end - p) < length) return NULL;
+		props.set(id, std::string(p, length));
+		p += length;
+	}
+	return p;
+}
+
+bool Mesh::writeBinaryFile(const char outputFile[])
+{
+	std::cout << "Writing mesh " << outputFile << " ...";
+	if (!saveBinaryFile(outputFile, 0, 0)) {
+		std::cerr << "Cannot write file " << outputFile << "!" << std::endl;
+		return false;
+	}
+	std::cout << "Done!" << std::endl;
+	return true;
+}
+
+bool Mesh::saveBinaryFile(const char outputFile[], unsigned long long sourceSize, unsigned long long sourceHash)
+{
+	const int nv = numVertices(), nf = numFaces(), ne = numEdges();
+	const size_t nh = 3 * (size_t)nf;
+
+	//halfedge 3*f+i is the i-th corner of face f, the last one being f->he(), like buildFromArrays() makes them
+	std::vector<Halfedge *> hes(nh);
+	std::vector<int> slotOfIndex(nh, -1);	//halfedge index() -> 3*f+i
+	for (int f = 0; f < nf; ++f) {
+		Halfedge * he = m_faces[f]->he();
+		for (int i = 0; i < 3; ++i) {
+			he = he->next();
+			int h = 3 * f + i;
+			int index = he->index();
+			if (index < 0 || index >= (int)nh || slotOfIndex[index] >= 0) {
+				std::cerr << "Error: the halfedge indices of the mesh are not set!" << std::endl;
+				return false;
+			}
+			hes[h] = he;
+			slotOfIndex[index] = h;
 		}
 	}
-	std::cout<< "Done!" <<std::endl;
+
+	std::vector<double> coords(3 * (size_t)nv);
+	std::vector<int32_t> vertexHe(nv);
+	std::vector<char> vertexBoundary(nv);
+	for (int v = 0; v < nv; ++v) {
+		Vertex * ver = m_verts[v];
+		for (int k = 0; k < 3; ++k)
+			coords[3 * v + k] = ver->point()[k];
+		vertexHe[v] = ver->he() ? slotOfIndex[ver->he()->index()] : -1;
+		vertexBoundary[v] = ver->boundary() ? 1 : 0;
+	}
+	std::vector<int32_t> faceInds(nh), heTwin(nh), heEdge(nh), heIndex(nh);
+	for (size_t h = 0; h < nh; ++h) {
+		Halfedge * he = hes[h];
+		Halfedge * twin = he->twin();
+		faceInds[h] = he->target()->index();
+		heTwin[h] = twin ? slotOfIndex[twin->index()] : -1;
+		heEdge[h] = he->edge()->index();
+		heIndex[h] = he->index();
+	}
+	std::vector<int32_t> edgeHe(2 * (size_t)ne);
+	for (int e = 0; e < ne; ++e) {
+		edgeHe[2 * e] = slotOfIndex[m_edges[e]->he(0)->index()];
+		edgeHe[2 * e + 1] = m_edges[e]->he(1) ? slotOfIndex[m_edges[e]->he(1)->index()] : -1;
+	}
+
+	FILE * fp = fopen(outputFile, "wb");
+	if (!fp)
+		return false;
+	BinaryFormat::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BinaryFormat::magic, sizeof(header.magic));
+	header.version = BinaryFormat::version;
+	header.byteOrder = BinaryFormat::byteOrderMark;
+	header.headerSize = (uint32_t)BinaryFormat::align8(sizeof(header));
+	header.numVertices = nv;
+	header.numFaces = nf;
+	header.numEdges = ne;
+	header.sourceSize = sourceSize;
+	header.sourceHash = sourceHash;
+	writePadded(fp, &header, sizeof(header));
+	writePadded(fp, coords.data(), coords.size() * sizeof(double));
+	writePadded(fp, faceInds.data(), nh * sizeof(int32_t));
+	writePadded(fp, heTwin.data(), nh * sizeof(int32_t));
+	writePadded(fp, heEdge.data(), nh * sizeof(int32_t));
+	writePadded(fp, heIndex.data(), nh * sizeof(int32_t));
+	writePadded(fp, edgeHe.data(), edgeHe.size() * sizeof(int32_t));
+	writePadded(fp, vertexHe.data(), vertexHe.size() * sizeof(int32_t));
+	writePadded(fp, vertexBoundary.data(), vertexBoundary.size());
+	writeProperties(fp, m_vertProps);
+	writeProperties(fp, m_edgeProps);
+	writeProperties(fp, m_faceProps);
+	bool ok = !ferror(fp);
+	if (fclose(fp) != 0)
+		ok = false;
+	if (!ok)
+		remove(outputFile);
+	return ok;
+}
+
+bool Mesh::readBinaryFile(const char inputFile[])
+{
+	std::cout << "Reading mesh " << inputFile << " ...";
+	if (!loadBinaryFile(inputFile, false, 0, 0))
+		return false;
+	std::cout << "Done!" << std::endl;
+	return true;
+}
+
+bool Mesh::writeCompressedFile(const char outputFile[], int bits, int numThreads)
+{
+	std::cout << "Writing mesh " << outputFile << " ...";
+	const int nv = numVertices(), nf = numFaces();
+	std::vector<double> coords(3 * (size_t)nv);
+	for (int v = 0; v < nv; ++v)
+		for (int k = 0; k < 3; ++k)
+			coords[3 * v + k] = m_verts[v]->point()[k];
+	//corner i of face f is the target of its i-th halfedge, the last one being f->he()
+	std::vector<int> faceInds(3 * (size_t)nf);
+	for (int f = 0; f < nf; ++f) {
+		Halfedge * he = m_faces[f]->he();
+		for (int i = 0; i < 3; ++i) {
+			he = he->next();
+			faceInds[3 * f + i] = he->target()->index();
+		}
+	}
+	std::vector<char> data;
+	if (!CompressedFormat::encode(coords.empty() ? NULL : &coords[0], nv, faceInds.empty() ? NULL : &faceInds[0], nf,
+		bits, data, NULL, NULL, numThreads))
+		return false;
+
+	FILE * fp = fopen(outputFile, "wb");
+	if (!fp) {
+		std::cerr << "Cannot open file " << outputFile << " to write!" << std::endl;
+		return false;
+	}
+	bool ok = fwrite(&data[0], 1, data.size(), fp) == data.size();
+	ok = fclose(fp) == 0 && ok;
+	if (!ok) {
+		std::cerr << "Cannot write file " << outputFile << "!" << std::endl;
+		return false;
+	}
+	std::cout << "Done!" << std::endl;
+	return true;
+}
+
+bool Mesh::readCompressedFile(const char inputFile[], int numThreads)
+{
+	std::cout << "Reading mesh " << inputFile << " ...";
+	MappedFile file;
+	if (!file.open(inputFile)) {
+		std::cerr << "Can't open file " << inputFile << "!" << std::endl;
+		return false;
+	}
+	std::vector<double> coords;
+	std::vector<int> faceInds;
+	std::string error;
+	if (!CompressedFormat::decode(file.data(), file.size(), coords, faceInds, error)) {
+		std::cerr << "Error: " << inputFile << ": " << error << "!" << std::endl;
+		return false;
+	}
+	if (!buildFromArrays(coords.empty() ? NULL : &coords[0], (int)(coords.size() / 3),
+		faceInds.empty() ? NULL : &faceInds[0], (int)(faceInds.size() / 3), numThreads))
+		return false;
+	std::cout << "Done!" << std::endl;
+	return true;
+}
+
+bool Mesh::loadBinaryFile(const char inputFile[], bool checkSource, unsigned long long sourceSize, unsigned long long sourceHash)
+{
+	//a stale or broken cache is not an error: the caller then reads the text file
+	#define BINARY_FILE_ERROR(message) { if (!checkSource) std::cerr << "Error: " << inputFile << message << std::endl; return false; }
+
+	MappedFile file;
+	if (!file.open(inputFile)) {
+		if (!checkSource) std::cerr << "Can't open file " << inputFile << "!" << std::endl;
+		return false;
+	}
+	BinaryFormat::Header header;
+	if (file.size() < sizeof(header))
+		BINARY_FILE_ERROR(" is not a binary mesh file!");
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, BinaryFormat::magic, sizeof(header.magic)) != 0 || header.byteOrder != BinaryFormat::byteOrderMark)
+		BINARY_FILE_ERROR(" is not a binary mesh file of this platform!");
+	if (header.version != BinaryFormat::version)
+		BINARY_FILE_ERROR(" has an unsupported version!");
+	if (checkSource && (header.sourceSize != sourceSize || header.sourceHash != sourceHash))
+		return false;
+
+	//locate the arrays, checking they all fit in the file
+	const int nv = header.numVertices, nf = header.numFaces, ne = header.numEdges;
+	if (nv < 0 || nf < 0 || ne < 0 || header.headerSize < sizeof(header))
+		BINARY_FILE_ERROR(" is corrupted!");
+	const size_t nh = 3 * (size_t)nf;
+	const size_t sizes[8] = { 3 * (size_t)nv * sizeof(double), nh * sizeof(int32_t), nh * sizeof(int32_t), nh * sizeof(int32_t),
+		nh * sizeof(int32_t), 2 * (size_t)ne * sizeof(int32_t), (size_t)nv * sizeof(int32_t), (size_t)nv };
+	const char * sections[8];
+	size_t offset = BinaryFormat::align8(header.headerSize);
+	for (int i = 0; i < 8; ++i) {
+		sections[i] = file.data() + offset;
+		offset += BinaryFormat::align8(sizes[i]);
+		if (offset > file.size())
+			BINARY_FILE_ERROR(" is truncated!");
+	}
+	const double * coords = (const double *)sections[0];
+	const int * faceInds = (const int *)sections[1];
+	const int * heEdge = (const int *)sections[3];
+	const int * heIndex = (const int *)sections[4];
+	const int * edgeHe = (const int *)sections[5];
+	const int * vertexHe = (const int *)sections[6];
+	const char * vertexBoundary = sections[7];
+
+	//every index has to point to an element, as nothing is checked while linking
+	bool valid = true;
+	for (size_t h = 0; h < nh; ++h)
+		valid &= faceInds[h] >= 0 && faceInds[h] < nv && heEdge[h] >= 0 && heEdge[h] < ne && heIndex[h] >= 0 && heIndex[h] < (int)nh;
+	for (size_t e = 0; e < 2 * (size_t)ne; ++e)
+		valid &= edgeHe[e] >= (e % 2 ? -1 : 0) && edgeHe[e] < (int)nh;
+	for (int v = 0; v < nv; ++v)
+		valid &= vertexHe[v] >= -1 && vertexHe[v] < (int)nh;
+	//and the links have to agree: each halfedge is one of its edge's and has its own index, the two halfedges
+	//of an edge join the same vertices the opposite ways, and the halfedge of a vertex comes into it
+	if (valid) {
+		auto source = [&](int h) { return faceInds[h - h % 3 + (h + 2) % 3]; };
+		std::vector<char> seen(nh, 0);
+		for (size_t h = 0; h < nh && valid; ++h) {
+			const int e = heEdge[h];
+			valid = (edgeHe[2 * e] == (int)h || edgeHe[2 * e + 1] == (int)h) && !seen[heIndex[h]];
+			seen[heIndex[h]] = 1;
+		}
+		for (int e = 0; e < ne && valid; ++e) {
+			const int h0 = edgeHe[2 * e], h1 = edgeHe[2 * e + 1];
+			valid = heEdge[h0] == e && (h1 < 0 || (h1 != h0 && heEdge[h1] == e && faceInds[h0] == source(h1)
+				&& faceInds[h1] == source(h0)));
+		}
+		for (int v = 0; v < nv && valid; ++v)
+			valid = vertexHe[v] < 0 || faceInds[vertexHe[v]] == v;
+	}
+	PropertyTable props[3];
+	const char * p = file.data() + offset;
+	for (int i = 0; i < 3 && p; ++i)
+		p = readProperties(p, file.end(), props[i]);
+	if (!valid || !p)
+		BINARY_FILE_ERROR(" is corrupted!");
+	#undef BINARY_FILE_ERROR
+
+	clear();
+	buildElements(coords, nv, faceInds, nf, ne, heEdge, heIndex, edgeHe, vertexHe, vertexBoundary, 0);
+	m_vertProps = props[0];
+	m_edgeProps = props[1];
+	m_faceProps = props[2];
+	return true;
+}
+
+//position of halfedge he in the connectivity arrays: 3 per face, in the order of createFace()
+static inline int halfedgeSlot(Halfedge * he)
+{
+	Face * f = he->face();
+	Halfedge * last = f->he();
+	return 3 * f->index() + (he == last ? 2 : he == last->next() ? 0 : 1);
+}
+
+void Mesh::copyTo(Mesh & tMesh, int numThreads)
+{
+	if (&tMesh == this)
+		return;
+	const int nv = numVertices(), ne = numEdges(), nf = numFaces();
+	const size_t nh = 3 * (size_t)nf;
+
+	//halfedges keep their index when every halfedge has its own one in [0, nh), as in the meshes built
+	//from arrays; otherwise (meshes built face by face) they are numbered the way Connectivity does it
+	std::vector<int> heIndex;
+	std::vector<char> seen(nh, 0);
+	bool indexed = true;
+	for (int i = 0; i < nf && indexed; ++i) {
+		Halfedge * he = m_faces[i]->he();
+		for (int j = 0; j < 3 && indexed; ++j, he = he->next()) {
+			int index = he->index();
+			indexed = index >= 0 && (size_t)index < nh && !seen[index];
+			if (indexed) seen[index] = 1;
+		}
+	}
+	std::vector<char>().swap(seen);
+	if (!indexed) {
+		std::vector<int> heBase(ne);
+		for (int i = 0; i < ne; ++i)
+			heBase[i] = m_edges[i]->he(1) ? 2 : 1;
+		Parallel::exclusiveScan(heBase.data(), heBase.data(), ne, numThreads);
+		heIndex.resize(nh);
+		Parallel::forRange(ne, numThreads, [&](size_t b, size_t e) {
+			for (size_t i = b; i < e; ++i) {
+				heIndex[halfedgeSlot(m_edges[i]->he(0))] = heBase[i];
+				if (m_edges[i]->he(1))
+					heIndex[halfedgeSlot(m_edges[i]->he(1))] = heBase[i] + 1;
+			}
+		});
+	}
+
+	//the elements of the copy are those of the same index, and its halfedges those of the same slot
+	const bool edgeIndex = tMesh.m_edgeIndex;
+	std::vector<Halfedge *> hes;
+	if (tMesh.numVertices() == nv && tMesh.numEdges() == ne && tMesh.numFaces() == nf) {
+		//a target of the same size (typically an earlier copy) is relinked in place, without allocating
+		hes.resize(nh);
+		Parallel::forRange(nf, numThreads, [&](size_t b, size_t e) {
+			for (size_t i = b; i < e; ++i) {
+				Halfedge * he = tMesh.m_faces[i]->he();
+				for (int j = 0; j < 3; ++j)
+					hes[3 * i + j] = he = he->next();
+			}
+		});
+	}
+	else {
+		tMesh.clear();
+		tMesh.allocateElements(nv, ne, nf, hes, numThreads);
+	}
+	std::vector<Vertex *> & verts = tMesh.m_verts;
+	std::vector<Edge *> & edges = tMesh.m_edges;
+	std::vector<Face *> & faces = tMesh.m_faces;
+	Parallel::forRange(nv, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Vertex * v = m_verts[i], * tv = verts[i];
+			tv->index() = (int)i;
+			tv->point() = v->point();
+			tv->he() = v->he() ? hes[halfedgeSlot(v->he())] : NULL;
+			tv->boundaryHe() = v->boundaryHe() ? hes[halfedgeSlot(v->boundaryHe())] : NULL;
+			tv->boundary() = v->boundary();
+		}
+	});
+	Parallel::forRange(nf, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Face * tf = faces[i];
+			tf->index() = (int)i;
+			Halfedge * he = m_faces[i]->he();
+			for (int j = 0; j < 3; ++j) {
+				he = he->next();
+				Halfedge * the = hes[3 * i + j];
+				the->target() = verts[he->target()->index()];
+				the->next() = hes[3 * i + (j + 1) % 3];
+				the->prev() = hes[3 * i + (j + 2) % 3];
+				the->face() = tf;
+				the->edge() = edges[he->edge()->index()];
+				the->index() = indexed ? he->index() : heIndex[3 * i + j];
+			}
+			tf->he() = hes[3 * i + 2];
+		}
+	});
+	Parallel::forRange(ne, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Edge * edge = m_edges[i], * tedge = edges[i];
+			tedge->index() = (int)i;
+			tedge->he(0) = hes[halfedgeSlot(edge->he(0))];
+			tedge->he(1) = edge->he(1) ? hes[halfedgeSlot(edge->he(1))] : NULL;
+		}
+	});
+
+	//every element keeps its index in the copy
+	tMesh.m_vertProps = m_vertProps;
+	tMesh.m_edgeProps = m_edgeProps;
+	tMesh.m_faceProps = m_faceProps;
+	tMesh.m_vertAttrs.copyFrom(m_vertAttrs);
+	tMesh.m_edgeAttrs.copyFrom(m_edgeAttrs);
+	tMesh.m_faceAttrs.copyFrom(m_faceAttrs);
+	tMesh.m_heAttrs.copyFrom(m_heAttrs);
+	tMesh.topologyChanged();
+	tMesh.m_moved = m_moved;
+	tMesh.m_movedFlags = m_movedFlags;
+	if (edgeIndex)		//the target keeps its index, now for the copied connectivity
+		tMesh.buildEdgeIndex();
+	else
+		tMesh.m_heHash.clear();
+}
+
+bool Mesh::reorder(MeshOrdering::Method method, int numThreads)
+{
+	const int nv = numVertices(), ne = numEdges(), nf = numFaces();
+	const size_t nh = 3 * (size_t)nf;
+
+	//the mesh as arrays, with the edge and the index of each halfedge slot to carry their data over
+	std::vector<double> coords(3 * (size_t)nv);
+	std::vector<int> faceInds(nh), slotEdge(nh), slotIndex(nh);
+	Parallel::forRange(nv, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i)
+			for (int k = 0; k < 3; ++k)
+				coords[3 * i + k] = m_verts[i]->point()[k];
+	});
+	Parallel::forRange(nf, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			Halfedge * he = m_faces[i]->he();
+			for (int j = 0; j < 3; ++j) {
+				he = he->next();
+				faceInds[3 * i + j] = he->target()->index();
+				slotEdge[3 * i + j] = he->edge()->index();
+				slotIndex[3 * i + j] = he->index();
+			}
+		}
+	});
+
+	MeshOrdering ordering;
+	ordering.build(method, coords.data(), nv, faceInds.data(), nf, numThreads);
+	std::vector<double> newCoords(coords.size());
+	std::vector<int> newFaceInds(nh);
+	Parallel::forRange(nv, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i)
+			for (int k = 0; k < 3; ++k)
+				newCoords[3 * i + k] = coords[3 * (size_t)ordering.vertexOrder[i] + k];
+	});
+	Parallel::forRange(nf, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i)
+			for (int j = 0; j < 3; ++j)
+				newFaceInds[3 * i + j] = ordering.vertexRank[faceInds[3 * (size_t)ordering.faceOrder[i] + j]];
+	});
+	std::vector<double>().swap(coords);
+	std::vector<int>().swap(faceInds);
+	Connectivity conn;
+	if (!conn.build(newFaceInds.data(), nv, nf, numThreads) || conn.numEdges() != ne)
+		return false;		//an edge of more than two faces: the mesh is left as it was
+
+	//the edges and halfedges are numbered by the new connectivity; find the old ones through their slots
+	std::vector<int> edgeOrder(ne), heOrder(nh);
+	std::vector<char> seen(nh, 0);
+	bool indexed = true;
+	for (size_t h = 0; h < nh && indexed; ++h) {
+		indexed = slotIndex[h] >= 0 && (size_t)slotIndex[h] < nh && !seen[slotIndex[h]];
+		if (indexed) seen[slotIndex[h]] = 1;
+	}
+	std::vector<char>().swap(seen);
+	if (!indexed && m_heAttrs.numAttributes() > 0)
+		return false;		//halfedge attributes but no index of their own to follow: the mesh is left as it was
+	Parallel::forRange(nf, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i)
+			for (int j = 0; j < 3; ++j) {
+				size_t h = 3 * i + j, old = 3 * (size_t)ordering.faceOrder[i] + j;
+				heOrder[conn.heIndex[h]] = slotIndex[old];
+				if ((size_t)conn.edgeHe[2 * conn.heEdge[h]] == h)
+					edgeOrder[conn.heEdge[h]] = slotEdge[old];
+			}
+	});
+
+	//rebuild the elements in the new order, the attributes and properties set aside meanwhile
+	AttributeSet vertAttrs, edgeAttrs, faceAttrs, heAttrs;
+	vertAttrs.swap(m_vertAttrs);
+	edgeAttrs.swap(m_edgeAttrs);
+	faceAttrs.swap(m_faceAttrs);
+	heAttrs.swap(m_heAttrs);
+	PropertyTable props[3] = { m_vertProps, m_edgeProps, m_faceProps };
+	const bool edgeIndex = m_edgeIndex;
+	std::vector<int> moved;
+	moved.swap(m_moved);
+	clear();
+	buildElements(newCoords.data(), nv, newFaceInds.data(), nf, conn.numEdges(), conn.heEdge.data(), conn.heIndex.data(),
+		conn.edgeHe.data(), conn.vertexHe.data(), conn.vertexBoundary.data(), numThreads);
+
+	vertAttrs.permute(ordering.vertexOrder);
+	edgeAttrs.permute(edgeOrder);
+	faceAttrs.permute(ordering.faceOrder);
+	if (indexed)		//else there are no halfedge attributes
+		heAttrs.permute(heOrder);
+	m_vertAttrs.swap(vertAttrs);
+	m_edgeAttrs.swap(edgeAttrs);
+	m_faceAttrs.swap(faceAttrs);
+	m_heAttrs.swap(heAttrs);
+	const std::vector<int> * ranks[3] = { &ordering.vertexRank, NULL, &ordering.faceRank };
+	std::vector<int> edgeRank(ne);
+	for (int i = 0; i < ne; ++i)
+		edgeRank[edgeOrder[i]] = i;
+	ranks[1] = &edgeRank;
+	PropertyTable * tables[3] = { &m_vertProps, &m_edgeProps, &m_faceProps };
+	for (int k = 0; k < 3; ++k) {
+		std::vector<int> ids = props[k].ids();
+		for (size_t i = 0; i < ids.size(); ++i)
+			tables[k]->set((*ranks[k])[ids[i]], props[k].get(ids[i]));
+	}
+	for (size_t i = 0; i < moved.size(); ++i)
+		markMoved(m_verts[ordering.vertexRank[moved[i]]]);
+	if (edgeIndex)
+		buildEdgeIndex();
+	return true;
 }
 
 
@@ -1,11 +1,18 @@
 #pragma once
 #include <vector>
+#include "Attributes.h"
 #include "Edge.h"
+#include "ElementPool.h"
 #include "Face.h"
 #include "Halfedge.h"
+#include "HalfedgeHash.h"
+#include "HalfedgeRange.h"
+#include "MeshOrdering.h"
 #include "Vertex.h"
 #include "Point.h"
+#include "PropertyTable.h"
 
+class MeshAttributes;
 
 class Mesh
 {
@@ -18,14 +25,44 @@ public:
 	~Mesh();
 
 	//(2) I/O
-	int numVertices()	{return m_verts.size();}							//number of vertices
-	int numEdges()		{return m_edges.size();}							//number of edges
-	int numFaces()		{return m_faces.size();}							//number of faces
-	void copyTo( Mesh & targetMesh );										//copy current mesh to the target mesh 
-	bool readMFile( const char inFile[]);									//read an "M"-format mesh from inFile
-	bool readOBJFile(const char inFile[]);									//read an "OBJ"-format mesh from inFile
-	bool writeMFile( const char outFile[]);									//write a mesh to outFile in "M"-format
-	bool writeOBJFile(const char outFile[]);								//write a mesh to outFile in "OBJ"-format
+	int numVertices() const	{return m_verts.size();}							//number of vertices
+	int numEdges() const		{return m_edges.size();}							//number of edges
+	int numFaces() const		{return m_faces.size();}							//number of faces
+	size_t memoryUsage();													//approximate bytes held by the mesh, heap overhead included
+	void copyTo(Mesh & targetMesh, int numThreads = 0);						//copy current mesh to the target mesh, with its properties and
+																			//	attributes, using numThreads threads (0: all cores); a target
+																			//	with as many elements of each kind is reused in place
+	bool readMFile( const char inFile[], bool useCache = false);			//read an "M"-format mesh from inFile
+	bool readOBJFile(const char inFile[], bool useCache = false,			//read an "OBJ"-format mesh from inFile, using numThreads
+		int numThreads = 0);												//	threads (0: all cores); useCache: load/save a binary
+																			//	cache inFile.mlb next to it
+	bool writeMFile( const char outFile[], int numThreads = 1);				//write a mesh to outFile in "M"-format
+	bool writeOBJFile(const char outFile[], int numThreads = 1);			//write a mesh to outFile in "OBJ"-format
+																			//	numThreads > 1 (0: all cores) formats blocks in parallel
+	bool readPLYFile(const char inFile[], int numThreads = 0);				//read an ascii or binary "PLY" mesh; polygons are split into
+																			//	triangles and the extra scalar vertex properties (color,
+																			//	confidence, ...) become vertex attributes of their type
+	bool readSTLFile(const char inFile[], double weldEpsilon = 0,			//read a binary or ascii "STL" triangle soup, welding the
+		int numThreads = 0);												//	corners within weldEpsilon (per axis) into shared vertices
+	bool writePLYFile(const char outFile[], bool binary = true,				//write a mesh to outFile in binary or ascii "PLY"-format,
+		int numThreads = 1);												//	with its scalar vertex attributes as vertex properties
+	bool readBinaryFile(const char inFile[]);								//read a mesh with its connectivity from a binary file
+	bool writeBinaryFile(const char outFile[]);								//write a mesh with its connectivity to a binary file
+	bool readCompressedFile(const char inFile[], int numThreads = 0);		//read a mesh from a compressed file (see CompressedFormat)
+	bool writeCompressedFile(const char outFile[], int bits = 16,			//write a mesh to a compressed file, its positions quantized
+		int numThreads = 0);												//	to bits per axis (1 to 30) over its bounding box
+	static bool parseOBJFile(const char inFile[], std::vector<double> & coords,	//read the vertex coordinates and triangle indices
+		std::vector<int> & faceInds, size_t * fileSize = NULL,					//	of an "OBJ" file without building a mesh, parsing
+		int numThreads = 0);													//	chunks of the file on numThreads threads (0: all cores)
+	bool buildFromArrays(const double coords[], int numVertices,			//build the mesh from xyz coordinates and vertex indices
+		const int faceInds[], int numFaces, int numThreads = 0);			//	of triangles, using numThreads threads (0: all cores)
+	bool reorder(MeshOrdering::Method method, int numThreads = 0);		//renumber the vertices along a space-filling curve or by
+																			//	reverse Cuthill-McKee, the faces after them, and rebuild
+																			//	the elements in that order for locality (see MeshOrdering);
+																			//	attributes and properties follow their elements; false,
+																			//	the mesh unchanged, on an edge of more than two faces or
+																			//	with halfedge attributes when the halfedges have no
+																			//	distinct index() in [0, 3 * numFaces()) to keep them by
 	void clear();
 
 	//(3) BASIC OPERATIONS
@@ -39,10 +76,67 @@ public:
 	Face *				indFace(unsigned int ind) { return (ind >= m_faces.size() ? 0 : m_faces[ind]); }
 	Edge *				indEdge(unsigned int ind) { return (ind >= m_edges.size() ? 0 : m_edges[ind]); }
 
+	//the elements in index order as random-access ranges, usable on a const Mesh, in range-for loops and
+	//with the standard (parallel) algorithms:
+	//		std::for_each(std::execution::par, mesh.faces().begin(), mesh.faces().end(), [&](Face * f) { ... });
+	//the halfedges are listed by face, 3 per face (see MeshHalfedgeRange)
+	const std::vector<Vertex *> &	vertices() const	{ return m_verts; }
+	const std::vector<Edge *> &		edges() const		{ return m_edges; }
+	const std::vector<Face *> &		faces() const		{ return m_faces; }
+	MeshHalfedgeRange				halfedges() const	{ return MeshHalfedgeRange(m_faces); }
+
 	Edge *				vertexEdge( Vertex * v0, Vertex * v1 );			//To find an edge sharing v0 and v1
 	Halfedge *			vertexHalfedge(Vertex * srcV, Vertex * trgV);	//To find a half-edge from v0 to v1
 	Edge *				idEdge( int vid0, int vid1 );					
 	Halfedge *			idHalfedge( int srcVid, int trgVid );
+	//the same queries for count vertex id pairs (2 per query, as vid0 vid1 or srcVid trgVid), answered on
+	//numThreads threads (0: all cores); a pair without an edge or with an invalid id gives NULL
+	void				idEdges(const int pairs[], size_t count, Edge * edges[], int numThreads = 0);
+	void				idHalfedges(const int pairs[], size_t count, Halfedge * halfedges[], int numThreads = 0);
+
+	//vertex-pair index: while it is on, the queries above are expected O(1) hash lookups instead of walks
+	//around the one-ring of the vertex. createFace() keeps it up to date; clear() and the readers drop it.
+	void				buildEdgeIndex();
+	void				clearEdgeIndex();
+	bool				hasEdgeIndex() const { return m_edgeIndex; }
+
+	//property strings ("{...}" in M files), stored only for the elements that have one
+	const std::string &	PropertyStr(Vertex * v) const { return m_vertProps.get(v->index()); }
+	const std::string &	PropertyStr(Edge * e) const { return m_edgeProps.get(e->index()); }
+	const std::string &	PropertyStr(Face * f) const { return m_faceProps.get(f->index()); }
+	void				setPropertyStr(Vertex * v, const std::string & str) { m_vertProps.set(v->index(), str); }	//an empty string removes it
+	void				setPropertyStr(Edge * e, const std::string & str) { m_edgeProps.set(e->index(), str); }
+	void				setPropertyStr(Face * f, const std::string & str) { m_faceProps.set(f->index(), str); }
+
+	//typed per-element attributes, indexed by index() and kept at one entry per element as the mesh changes.
+	//Halfedge attributes have 3 entries per face, as halfedge indices run over [0, 3 * numFaces()).
+	AttributeSet &		vertexAttributes()		{ return m_vertAttrs; }
+	AttributeSet &		edgeAttributes()		{ return m_edgeAttrs; }
+	AttributeSet &		faceAttributes()		{ return m_faceAttrs; }
+	AttributeSet &		halfedgeAttributes()	{ return m_heAttrs; }
+
+	//moved vertices: setPoint() moves a vertex and marks it, markMoved() marks a vertex moved in place through
+	//point(). Incremental kernels (see MeshGeometry::update) recompute what depends on the positions around
+	//the marked vertices only, and clear the marks. Mark from one thread at a time. reorder() and copyTo()
+	//keep the marks with their vertices, clear() and the readers drop them.
+	void				setPoint(Vertex * v, const MeshPoint & p) { v->point() = p; markMoved(v); }
+	void				markMoved(Vertex * v);
+	bool				isMoved(Vertex * v) const { return (size_t)v->index() < m_movedFlags.size() && m_movedFlags[v->index()]; }
+	const std::vector<int> &	movedVertices() const { return m_moved; }	//the indices of the marked vertices, in marking order
+	void				clearMoved();
+
+	//revisions, for the data derived from the mesh to tell whether it is still current (see MeshAttributes).
+	//The topology revision changes with the connectivity (clear(), the readers, createFace(), reorder(),
+	//copyTo()), and the geometry revision with it and with every position marked moved. Call geometryChanged()
+	//after moving vertices through point() without marking them; it clears the marks.
+	unsigned long long	topologyRevision() const	{ return m_topologyRevision; }
+	unsigned long long	geometryRevision() const	{ return m_geometryRevision; }
+	unsigned long long	movedSince() const			{ return m_movedSince; }	//the geometry revision after which movedVertices()
+																				//	has every moved vertex
+	void				geometryChanged();
+	//the derived quantities (normals, curvature, bounding box, ...) of the mesh, computed when first asked for
+	//and shared by all the users of the mesh; from one thread at a time
+	MeshAttributes &	derived();
 	
 	
 protected:
@@ -55,7 +149,22 @@ protected:
 	Face *		createFace(Vertex * verts[]);
 	Face *		createFace(int vIds[]);
 
+	void		topologyChanged();
+	//once the faces are all created; also releases the halfedge table createFace() used to find twins
 	void		LabelBoundaryVertices();
+	void		hashHalfedges();			//fill m_heHash with every halfedge
+	//point each boundary vertex at the boundary halfedges of its fan (see Vertex::boundaryHe)
+	void		linkBoundaryHalfedges(int numThreads);
+
+	//create and link all the elements from index-based connectivity (see Connectivity)
+	void		buildElements(const double coords[], int numVertices, const int faceInds[], int numFaces, int numEdges,
+					const int heEdge[], const int heIndex[], const int edgeHe[], const int vertexHe[], const char vertexBoundary[],
+					int numThreads);
+	//construct the elements of an empty mesh with their indices, not linked yet; hes[3 * f + j] is corner j of face f
+	void		allocateElements(int numVertices, int numEdges, int numFaces, std::vector<Halfedge *> & hes, int numThreads);
+	//binary files; the source size and hash identify the text file a cache was made from
+	bool		loadBinaryFile(const char inFile[], bool checkSource, unsigned long long sourceSize, unsigned long long sourceHash);
+	bool		saveBinaryFile(const char outFile[], unsigned long long sourceSize, unsigned long long sourceHash);
 	
 	////(6) Some Basic Mesh Processing Operations
 	////	Flip the input edge, and return it.
@@ -76,8 +185,36 @@ protected:
 	std::vector<Vertex *>				m_verts;		// vertex container
 	std::vector<Face *>					m_faces;		// face container
 
-	//a temporary container to store halfedges surrounding some vertices
-	std::vector<std::vector<Halfedge *>> v_adjInHEList;	
+	//element storage: every element lives in a slab of its mesh and is released by clear()
+	ElementPool<Vertex>					m_vertPool;
+	ElementPool<Edge>					m_edgePool;
+	ElementPool<Face>					m_facePool;
+	ElementPool<Halfedge>				m_hePool;
+
+	//sparse property strings of the vertices, edges and faces
+	PropertyTable						m_vertProps;
+	PropertyTable						m_edgeProps;
+	PropertyTable						m_faceProps;
+
+	//per-element attribute arrays
+	AttributeSet						m_vertAttrs;
+	AttributeSet						m_edgeAttrs;
+	AttributeSet						m_faceAttrs;
+	AttributeSet						m_heAttrs;
+
+	//the halfedges by vertex pair: finds the twin of each new halfedge while the mesh is built face by face
+	//(until LabelBoundaryVertices()), and holds every halfedge while the edge index is on
+	HalfedgeHash						m_heHash;
+	bool								m_edgeIndex;
+
+	//the moved vertices, and a flag per vertex index for whether it is in m_moved (empty while none is)
+	std::vector<int>					m_moved;
+	std::vector<char>					m_movedFlags;
+
+	unsigned long long					m_topologyRevision;
+	unsigned long long					m_geometryRevision;
+	unsigned long long					m_movedSince;
+	MeshAttributes *					m_derived;		//created by derived()
 
 protected:
 	friend class MeshVertexIterator;
@@ -0,0 +1,144 @@
+#include "MeshAttributes.h"
+#include "MeshParallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const unsigned long long never = ~0ull;
+
+	struct Bounds
+	{
+		Point	min;
+		Point	max;
+	};
+}
+
+MeshAttributes::MeshAttributes(Mesh & mesh, size_t grain, ThreadPool & pool)
+	: m_mesh(mesh), m_grain(grain), m_pool(pool), m_topologyStamp(never), m_normalsStamp(never),
+	m_curvatureStamp(never), m_updateFrom(never), m_updateTo(never), m_previousStamp(never), m_updated(false),
+	m_boundsStamp(never) {;}
+
+bool MeshAttributes::hasNormals()
+{
+	return m_mesh.halfedgeAttributes().find<MeshScalar>("angle") && m_mesh.faceAttributes().find<MeshPoint>("normal")
+		&& m_mesh.faceAttributes().find<MeshScalar>("area") && m_mesh.vertexAttributes().find<MeshPoint>("normal");
+}
+
+bool MeshAttributes::hasCurvature()
+{
+	return m_mesh.vertexAttributes().find<MeshScalar>("gaussianCurvature") != NULL;
+}
+
+//an update when the attributes are those of a revision of the same topology that the moved vertices cover;
+//the curvature goes along with the normals when it is asked for and was current with them, and is otherwise
+//brought up to date from the angles: around the vertices of the last update when it was current before it
+void MeshAttributes::refresh(bool curvature)
+{
+	const unsigned long long revision = m_mesh.geometryRevision();
+	if (m_topologyStamp != m_mesh.topologyRevision()) {
+		m_geometry.topologyChanged();
+		m_normalsStamp = m_curvatureStamp = m_updateFrom = m_updateTo = never;
+		m_topologyStamp = m_mesh.topologyRevision();
+	}
+	if (!hasNormals())
+		m_normalsStamp = m_curvatureStamp = m_updateFrom = m_updateTo = never;
+	else if (!hasCurvature())
+		m_curvatureStamp = never;
+	if (m_normalsStamp == revision && (!curvature || m_curvatureStamp == revision))
+		return;
+
+	const unsigned long long previous = m_curvatureStamp;
+	bool updated = false;
+	if (m_normalsStamp != revision) {
+		if (m_normalsStamp != never && m_normalsStamp >= m_mesh.movedSince()) {
+			const bool along = curvature && m_curvatureStamp == m_normalsStamp;
+			const bool incremental = m_geometry.update(m_mesh, m_grain, m_pool, along);
+			m_updateFrom = incremental ? m_normalsStamp : never;
+			if (along) {
+				m_curvatureStamp = revision;
+				updated = incremental;
+			}
+		}
+		else {
+			m_geometry.compute(m_mesh, m_grain, m_pool, curvature);
+			m_updateFrom = never;
+			if (curvature)
+				m_curvatureStamp = revision;
+		}
+		m_normalsStamp = m_updateTo = revision;
+	}
+	if (curvature && m_curvatureStamp != revision) {
+		if (m_curvatureStamp != never && m_curvatureStamp == m_updateFrom && m_updateTo == revision)
+			updated = m_geometry.updateCurvature(m_mesh, m_grain, m_pool);
+		else
+			m_geometry.computeCurvature(m_mesh, m_grain, m_pool);
+		m_curvatureStamp = revision;
+	}
+	if (m_curvatureStamp != previous) {
+		m_previousStamp = previous;
+		m_updated = updated;
+	}
+}
+
+AttributeArray<MeshPoint> & MeshAttributes::faceNormals()
+{
+	refresh(false);
+	return *m_mesh.faceAttributes().find<MeshPoint>("normal");
+}
+
+AttributeArray<MeshScalar> & MeshAttributes::faceAreas()
+{
+	refresh(false);
+	return *m_mesh.faceAttributes().find<MeshScalar>("area");
+}
+
+AttributeArray<MeshScalar> & MeshAttributes::cornerAngles()
+{
+	refresh(false);
+	return *m_mesh.halfedgeAttributes().find<MeshScalar>("angle");
+}
+
+AttributeArray<MeshPoint> & MeshAttributes::vertexNormals()
+{
+	refresh(false);
+	return *m_mesh.vertexAttributes().find<MeshPoint>("normal");
+}
+
+AttributeArray<MeshScalar> & MeshAttributes::gaussianCurvature()
+{
+	refresh(true);
+	return *m_mesh.vertexAttributes().find<MeshScalar>("gaussianCurvature");
+}
+
+//the updated vertices of MeshGeometry are those of the curvature while the normals are not updated past it
+const std::vector<int> * MeshAttributes::updatedVertices(unsigned long long stamp) const
+{
+	return m_updated && stamp == m_previousStamp && m_curvatureStamp == m_updateTo ? &m_geometry.updatedVertices() : NULL;
+}
+
+void MeshAttributes::boundingBox(Point & min, Point & max)
+{
+	if (m_boundsStamp != m_mesh.geometryRevision()) {
+		Bounds empty;
+		empty.min = Point(HUGE_VAL, HUGE_VAL, HUGE_VAL);
+		empty.max = Point(-HUGE_VAL, -HUGE_VAL, -HUGE_VAL);
+		Bounds bounds = parallelReduceVertices(m_mesh, empty, [](Vertex * v) {
+			Bounds b;
+			b.min = b.max = v->point();
+			return b;
+		}, [](const Bounds & a, const Bounds & b) {
+			Bounds c;
+			for (int k = 0; k < 3; ++k) {
+				c.min[k] = std::min(a.min[k], b.min[k]);
+				c.max[k] = std::max(a.max[k], b.max[k]);
+			}
+			return c;
+		}, m_grain, m_pool);
+		m_min = bounds.min;
+		m_max = bounds.max;
+		m_boundsStamp = m_mesh.geometryRevision();
+	}
+	min = m_min;
+	max = m_max;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include "Mesh.h"
+#include "MeshGeometry.h"
+#include "ThreadPool.h"
+
+// The quantities derived from a mesh, computed when first asked for and kept until the mesh changes:
+//		face normals and areas, corner angles, vertex normals	(one MeshGeometry pass)
+//		Gaussian curvature										(with them, or later from the stored angles)
+//		the bounding box										(one pass over the vertices)
+// Each result records the revisions of the mesh it was computed at (see Mesh::geometryRevision) and is
+// computed again on the first request after they change: the per-element quantities by
+// MeshGeometry::update() when the mesh only had vertices marked moved since, by a full pass otherwise. They
+// live in the attributes MeshGeometry fills ("angle", "normal", ...). The first four come from the same pass,
+// so asking for any of them computes all four; the curvature is left out of that pass until it is asked for
+// itself. Mesh::derived() keeps one for each mesh, which every user of the mesh shares:
+//		AttributeArray<MeshPoint> & normals = mesh.derived().vertexNormals();
+// The arrays stay valid until the next request after a change of the mesh.
+class MeshAttributes
+{
+public:
+	explicit MeshAttributes(Mesh & mesh, size_t grain = 1024, ThreadPool & pool = ThreadPool::global());
+
+	AttributeArray<MeshPoint> &		faceNormals();
+	AttributeArray<MeshScalar> &	faceAreas();
+	AttributeArray<MeshScalar> &	cornerAngles();			//by halfedge, at its source
+	AttributeArray<MeshPoint> &		vertexNormals();
+	AttributeArray<MeshScalar> &	gaussianCurvature();
+	void							boundingBox(Point & min, Point & max);
+
+	//the geometry revisions the normals (and angles, areas) and the curvature were last computed at
+	//(~0 before the first time)
+	unsigned long long				normalsStamp() const	{ return m_normalsStamp; }
+	unsigned long long				curvatureStamp() const	{ return m_curvatureStamp; }
+	//the vertices whose curvature the last computation of it changed, when it updated that of the geometry
+	//revision stamp; NULL when it was not such an update, and any of them may have changed
+	const std::vector<int> *		updatedVertices(unsigned long long stamp) const;
+
+private:
+	MeshAttributes(const MeshAttributes &);
+	MeshAttributes & operator=(const MeshAttributes &);
+
+	void				refresh(bool curvature);
+	bool				hasNormals();		//whether the attributes are all there, of their type
+	bool				hasCurvature();
+
+	Mesh &				m_mesh;
+	size_t				m_grain;
+	ThreadPool &		m_pool;
+	MeshGeometry		m_geometry;
+	unsigned long long	m_topologyStamp;
+	unsigned long long	m_normalsStamp;
+	unsigned long long	m_curvatureStamp;
+	unsigned long long	m_updateFrom;		//the normals stamps of the last MeshGeometry::update() (~0 after
+	unsigned long long	m_updateTo;			//	a compute()), whose updated vertices it still lists
+	unsigned long long	m_previousStamp;	//the curvature stamp before the last computation of it,
+	bool				m_updated;			//	and whether it was an update from there
+	unsigned long long	m_boundsStamp;
+	Point				m_min;
+	Point				m_max;
+};
@@ -0,0 +1,301 @@
+#include "MeshGeometry.h"
+#include "MeshParallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//blocks a vertex would have to share with more colors than this go to a last color run serially
+	const int maxColors = 64;
+	const double pi = 3.14159265358979323846;
+
+	//the attributes MeshGeometry fills
+	struct Attributes
+	{
+		AttributeArray<MeshScalar> &	angles;
+		AttributeArray<MeshPoint> &		faceNormals;
+		AttributeArray<MeshScalar> &	areas;
+		AttributeArray<MeshPoint> &		vertexNormals;
+		AttributeArray<MeshScalar> *	curvature;		//NULL when it is not asked for
+
+		Attributes(Mesh & mesh, bool withCurvature)
+			: angles(mesh.halfedgeAttributes().add<MeshScalar>("angle")),
+			faceNormals(mesh.faceAttributes().add<MeshPoint>("normal")),
+			areas(mesh.faceAttributes().add<MeshScalar>("area")),
+			vertexNormals(mesh.vertexAttributes().add<MeshPoint>("normal")),
+			curvature(withCurvature ? &mesh.vertexAttributes().add<MeshScalar>("gaussianCurvature") : NULL) {;}
+
+		//the normal, area and angles of f into its attributes; he receives f->he(), its next and its prev, v their
+		//sources and a the angles there. Returns twice the area, 0 for a degenerate face (of normal 0).
+		double face(Face * f, Halfedge * he[3], Vertex * v[3], double a[3], Point & normal)
+		{
+			he[0] = f->he();
+			he[1] = he[0]->next();
+			he[2] = he[0]->prev();
+			v[0] = he[2]->target();
+			v[1] = he[0]->target();
+			v[2] = he[1]->target();
+			const MeshPoint & p0 = v[0]->point(), & p1 = v[1]->point(), & p2 = v[2]->point();
+			double e0[3], e1[3], e2[3];		//he[0], he[1] and he[2], in double whatever the precision of the mesh
+			for (int k = 0; k < 3; ++k) {
+				e0[k] = (double)p1[k] - p0[k];
+				e1[k] = (double)p2[k] - p1[k];
+				e2[k] = (double)p0[k] - p2[k];
+			}
+			double n[3] = { e2[1] * e0[2] - e2[2] * e0[1], e2[2] * e0[0] - e2[0] * e0[2], e2[0] * e0[1] - e2[1] * e0[0] };
+			double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			a[0] = atan2(length, -(e2[0] * e0[0] + e2[1] * e0[1] + e2[2] * e0[2]));
+			a[1] = atan2(length, -(e0[0] * e1[0] + e0[1] * e1[1] + e0[2] * e1[2]));
+			a[2] = atan2(length, -(e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2]));
+			areas[f] = (MeshScalar)(length / 2);
+			normal = length > 0 ? Point(n[0] / length, n[1] / length, n[2] / length) : Point();
+			faceNormals[f] = normal;
+			for (int j = 0; j < 3; ++j)
+				angles[he[j]] = (MeshScalar)a[j];
+			return length;
+		}
+
+		//the normal (when withNormal) and the curvature (when asked for) of v from the normals and angles of the
+		//faces of its corners [first, last)
+		void gather(Vertex * v, const int * first, const int * last, const std::vector<Face *> & faces, bool withNormal)
+		{
+			Point normal;
+			double sum = 0;
+			for (const int * c = first; c < last; ++c) {
+				Face * f = faces[*c / 3];
+				Halfedge * he = f->he();
+				if (*c % 3 == 1) he = he->next();
+				else if (*c % 3 == 2) he = he->prev();
+				double a = angles[he];
+				if (withNormal) normal += Point(faceNormals[f]) * a;
+				sum += a;
+			}
+			if (withNormal) {
+				double length = normal.norm();
+				vertexNormals[v] = length > 0 ? normal / length : normal;
+			}
+			if (curvature)
+				(*curvature)[v] = (MeshScalar)(2 * pi - sum);
+		}
+	};
+}
+
+//greedy: every block, in order, takes the lowest color none of the blocks around its vertices has yet.
+//On a mesh in a local order (see Mesh::reorder) a block only touches the few blocks next to it, and 4 to 8
+//colors do; on a mesh in random order most blocks share vertices and end up in the serial color.
+void MeshGeometry::colorBlocks(const Mesh & mesh, size_t grain)
+{
+	const std::vector<Face *> & faces = mesh.faces();
+	const size_t nf = faces.size();
+	const int numBlocks = (int)((nf + grain - 1) / grain);
+	std::vector<unsigned long long> used(mesh.numVertices(), 0);
+	std::vector<unsigned char> color(numBlocks);
+	std::vector<int> count(maxColors + 2, 0);
+	for (int b = 0; b < numBlocks; ++b) {
+		size_t first = b * grain, last = std::min(nf, first + grain);
+		unsigned long long taken = 0;
+		for (size_t f = first; f < last; ++f) {
+			Halfedge * he = faces[f]->he();
+			taken |= used[he->target()->index()] | used[he->next()->target()->index()] | used[he->prev()->target()->index()];
+		}
+		int c = 0;
+		while (c < maxColors && (taken >> c & 1)) ++c;
+		if (c < maxColors)
+			for (size_t f = first; f < last; ++f) {
+				Halfedge * he = faces[f]->he();
+				used[he->target()->index()] |= 1ull << c;
+				used[he->next()->target()->index()] |= 1ull << c;
+				used[he->prev()->target()->index()] |= 1ull << c;
+			}
+		color[b] = (unsigned char)c;
+		++count[c + 1];
+	}
+	int numColors = maxColors + 1;
+	while (numColors > 0 && count[numColors] == 0) --numColors;
+
+	m_colorStart.assign(numColors + 1, 0);
+	for (int c = 0; c < numColors; ++c)
+		m_colorStart[c + 1] = m_colorStart[c] + count[c + 1];
+	std::vector<int> fill(m_colorStart.begin(), m_colorStart.end() - 1);
+	m_blocks.resize(numBlocks);
+	for (int b = 0; b < numBlocks; ++b)
+		m_blocks[fill[color[b]]++] = b;
+	m_mesh = &mesh;
+	m_topologyRevision = mesh.topologyRevision();
+	m_grain = grain;
+	m_cornerStart.clear();
+}
+
+//a counting sort of the corners by vertex. Unlike a walk around the fan of a vertex, it finds all the
+//corners of a vertex where several fans meet.
+void MeshGeometry::listCorners(const Mesh & mesh)
+{
+	const std::vector<Face *> & faces = mesh.faces();
+	const size_t nf = faces.size();
+	m_corners.resize(3 * nf);
+	m_cornerStart.assign(mesh.numVertices() + 1, 0);
+	m_cornerRevision = mesh.topologyRevision();
+	auto source = [&](size_t c) {
+		Halfedge * he = faces[c / 3]->he();
+		return (c % 3 == 0 ? he->prev() : c % 3 == 1 ? he : he->next())->target()->index();
+	};
+	for (size_t c = 0; c < 3 * nf; ++c)
+		++m_cornerStart[source(c) + 1];
+	for (int v = 0; v < mesh.numVertices(); ++v)
+		m_cornerStart[v + 1] += m_cornerStart[v];
+	std::vector<int> fill(m_cornerStart.begin(), m_cornerStart.end() - 1);
+	for (size_t c = 0; c < 3 * nf; ++c)
+		m_corners[fill[source(c)]++] = (int)c;
+}
+
+//f(face) for every face, one task per block of the coloring, the faces of a block in order
+template <class F>
+void MeshGeometry::scatterFaces(Mesh & mesh, size_t grain, ThreadPool & pool, F f)
+{
+	if (m_mesh != &mesh || m_topologyRevision != mesh.topologyRevision() || m_grain != grain)
+		colorBlocks(mesh, grain);
+	const std::vector<Face *> & faces = mesh.faces();
+	for (int c = 0; c < numColors(); ++c) {
+		const int * blocks = &m_blocks[0] + m_colorStart[c];
+		size_t n = m_colorStart[c + 1] - m_colorStart[c];
+		pool.parallelFor(n, c < maxColors ? 1 : n, [&](size_t b, size_t e) {
+			for (size_t i = b; i < e; ++i)
+				for (size_t face = blocks[i] * grain, last = std::min(faces.size(), face + grain); face < last; ++face)
+					f(faces[face]);
+		});
+	}
+}
+
+void MeshGeometry::compute(Mesh & mesh, size_t grain, ThreadPool & pool, bool curvature)
+{
+	Attributes attributes(mesh, curvature);
+	AttributeArray<MeshPoint> & vertexNormals = attributes.vertexNormals;
+
+	if (grain == 0) grain = 1;
+	vertexNormals.fill(MeshPoint());
+	if (curvature)
+		attributes.curvature->fill(MeshScalar(2 * pi));
+	scatterFaces(mesh, grain, pool, [&](Face * f) {
+		Halfedge * he[3];
+		Vertex * v[3];
+		double a[3];
+		Point normal;
+		double length = attributes.face(f, he, v, a, normal);
+		for (int j = 0; j < 3; ++j) {
+			if (curvature)
+				(*attributes.curvature)[v[j]] -= (MeshScalar)a[j];
+			if (length == 0) continue;
+			MeshPoint & vn = vertexNormals[v[j]];
+			for (int k = 0; k < 3; ++k)
+				vn[k] += (MeshScalar)(normal[k] * a[j]);
+		}
+	});
+
+	parallelForVertices(mesh, [&](Vertex * v) {
+		MeshPoint & n = vertexNormals[v];
+		MeshScalar length = n.norm();
+		if (length > 0) n /= length;
+	}, grain, pool);
+	m_updatedFaces.clear();
+	m_updatedVertices.clear();
+	mesh.clearMoved();
+}
+
+//the same subtractions in the same order as compute(), from the angles it stored: the same bits
+void MeshGeometry::computeCurvature(Mesh & mesh, size_t grain, ThreadPool & pool)
+{
+	AttributeArray<MeshScalar> * angles = mesh.halfedgeAttributes().find<MeshScalar>("angle");
+	if (!angles) {
+		compute(mesh, grain, pool);
+		return;
+	}
+	AttributeArray<MeshScalar> & curvature = mesh.vertexAttributes().add<MeshScalar>("gaussianCurvature");
+	if (grain == 0) grain = 1;
+	curvature.fill(MeshScalar(2 * pi));
+	scatterFaces(mesh, grain, pool, [&](Face * f) {
+		Halfedge * he = f->he();
+		curvature[he->prev()->target()] -= (*angles)[he];
+		curvature[he->target()] -= (*angles)[he->next()];
+		curvature[he->next()->target()] -= (*angles)[he->prev()];
+	});
+}
+
+bool MeshGeometry::updateCurvature(Mesh & mesh, size_t grain, ThreadPool & pool)
+{
+	if (m_mesh != &mesh || m_topologyRevision != mesh.topologyRevision() || m_cornerStart.empty()
+		|| m_cornerRevision != mesh.topologyRevision() || !mesh.halfedgeAttributes().find<MeshScalar>("angle")) {
+		computeCurvature(mesh, grain, pool);
+		return false;
+	}
+	Attributes attributes(mesh, true);
+	if (grain == 0) grain = 1;
+	const std::vector<Face *> & faces = mesh.faces();
+	const std::vector<Vertex *> & verts = mesh.vertices();
+	pool.parallelFor(m_updatedVertices.size(), grain, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			int v = m_updatedVertices[i];
+			attributes.gather(verts[v], &m_corners[0] + m_cornerStart[v], &m_corners[0] + m_cornerStart[v + 1], faces, false);
+		}
+	});
+	return true;
+}
+
+bool MeshGeometry::update(Mesh & mesh, size_t grain, ThreadPool & pool, bool curvature)
+{
+	const std::vector<int> & moved = mesh.movedVertices();
+	if (m_mesh != &mesh || m_topologyRevision != mesh.topologyRevision() || moved.size() * 8 > (size_t)mesh.numVertices()) {
+		compute(mesh, grain, pool, curvature);
+		return false;
+	}
+	Attributes attributes(mesh, curvature);
+	if (grain == 0) grain = 1;
+	if (m_cornerStart.empty() || m_cornerRevision != mesh.topologyRevision())
+		listCorners(mesh);
+
+	//the faces around the moved vertices, then the vertices of these faces, each once
+	const std::vector<Face *> & faces = mesh.faces();
+	const std::vector<Vertex *> & verts = mesh.vertices();
+	m_faceMarks.resize(mesh.numFaces(), 0);
+	m_vertexMarks.resize(mesh.numVertices(), 0);
+	m_updatedFaces.clear();
+	m_updatedVertices.clear();
+	for (size_t i = 0; i < moved.size(); ++i) {
+		for (int c = m_cornerStart[moved[i]]; c < m_cornerStart[moved[i] + 1]; ++c) {
+			Face * f = faces[m_corners[c] / 3];
+			if (m_faceMarks[f->index()]) continue;
+			m_faceMarks[f->index()] = 1;
+			m_updatedFaces.push_back(f->index());
+			Halfedge * he = f->he();
+			for (int j = 0; j < 3; ++j, he = he->next()) {
+				int w = he->target()->index();
+				if (m_vertexMarks[w]) continue;
+				m_vertexMarks[w] = 1;
+				m_updatedVertices.push_back(w);
+			}
+		}
+	}
+	//in index order, which is memory order on a mesh in a local order
+	std::sort(m_updatedFaces.begin(), m_updatedFaces.end());
+	std::sort(m_updatedVertices.begin(), m_updatedVertices.end());
+	for (size_t i = 0; i < m_updatedFaces.size(); ++i)
+		m_faceMarks[m_updatedFaces[i]] = 0;
+	for (size_t i = 0; i < m_updatedVertices.size(); ++i)
+		m_vertexMarks[m_updatedVertices[i]] = 0;
+
+	pool.parallelFor(m_updatedFaces.size(), grain, [&](size_t b, size_t e) {
+		Halfedge * he[3];
+		Vertex * v[3];
+		double a[3];
+		Point normal;
+		for (size_t i = b; i < e; ++i)
+			attributes.face(faces[m_updatedFaces[i]], he, v, a, normal);
+	});
+	pool.parallelFor(m_updatedVertices.size(), grain, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			int v = m_updatedVertices[i];
+			attributes.gather(verts[v], &m_corners[0] + m_cornerStart[v], &m_corners[0] + m_cornerStart[v + 1], faces, true);
+		}
+	});
+	mesh.clearMoved();
+	return true;
+}
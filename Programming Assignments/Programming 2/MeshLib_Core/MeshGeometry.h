@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+// Corner angles, face normals and areas, vertex normals and Gaussian curvature of a mesh in one pass over
+// its faces. Every face computes its edge vectors, its normal and area (one square root) and its three
+// angles (atan2 of twice the area and of the dot product at the corner) once, and adds its share into its
+// three vertices; a light pass over the vertices then normalizes the normals. The results are those of the
+// separate passes of hw2.cpp, in the attributes (of type MeshScalar and MeshPoint, double unless the library
+// is built for float geometry; the per-face arithmetic is in double either way):
+//		halfedge "angle"				the angle of the face of the halfedge at its source
+//		face "normal", "area"
+//		vertex "normal"					the unit average of the normals of the faces around, weighted by their angle
+//		vertex "gaussianCurvature"		2 pi minus the angles around, on the boundary too (unlike StreamingMesh)
+//
+// The faces are cut into blocks of grain consecutive faces, and the blocks colored so that no two blocks of
+// a color share a vertex. The blocks of a color run in parallel, each one serially, so the adds do not race
+// and every vertex receives its adds in the same order whatever the number of threads. The coloring is
+// made on the first call and kept for the next ones on the same mesh with the same topology revision (see
+// Mesh::topologyRevision) and the same grain; call topologyChanged() to drop it otherwise.
+//
+// After vertex moves marked on the mesh (Mesh::setPoint, Mesh::markMoved), update() recomputes the faces
+// around the moved vertices and gathers the normal and curvature of the vertices of these faces from the
+// faces around them, in time proportional to the moved vertices rather than to the mesh. The first update()
+// after a compute() of a new topology lists the corners of every vertex (4 bytes per corner) for that:
+//		mesh.setPoint(v, p);		//for every moved vertex
+//		geometry.update(mesh);
+// With curvature false, compute() and update() leave the curvature out (it is then stale), for users of the
+// normals alone; computeCurvature() and updateCurvature() bring it up to date later from the stored angles,
+// without the per-face trigonometry.
+class MeshGeometry
+{
+public:
+	MeshGeometry() : m_mesh(0), m_topologyRevision(0), m_grain(0), m_cornerRevision(0) {;}
+
+	void compute(Mesh & mesh, size_t grain = 1024, ThreadPool & pool = ThreadPool::global(), bool curvature = true);
+	//recompute around the vertices marked moved since the last compute() or update() on this mesh, and clear
+	//the marks; false when it computed the whole mesh instead: without a compute() of the same topology
+	//before, or with more than an eighth of the vertices moved. compute() clears the marks too.
+	bool update(Mesh & mesh, size_t grain = 1024, ThreadPool & pool = ThreadPool::global(), bool curvature = true);
+	//the curvature alone from the angles: of every vertex, or of the updatedVertices() of the last update(),
+	//which is enough when the curvature was current before that update; false when it computed every vertex
+	void computeCurvature(Mesh & mesh, size_t grain = 1024, ThreadPool & pool = ThreadPool::global());
+	bool updateCurvature(Mesh & mesh, size_t grain = 1024, ThreadPool & pool = ThreadPool::global());
+	void topologyChanged() { m_mesh = 0; }
+
+	//the indices of the faces and vertices the last update() recomputed
+	const std::vector<int> & updatedFaces() const		{ return m_updatedFaces; }
+	const std::vector<int> & updatedVertices() const	{ return m_updatedVertices; }
+
+	int numColors() const { return (int)m_colorStart.size() - 1; }
+
+private:
+	void colorBlocks(const Mesh & mesh, size_t grain);
+	template <class F>
+	void scatterFaces(Mesh & mesh, size_t grain, ThreadPool & pool, F f);
+	void listCorners(const Mesh & mesh);
+
+	const Mesh *		m_mesh;			//the mesh the coloring is for,
+	unsigned long long	m_topologyRevision;	//	at this revision
+	size_t				m_grain;
+	std::vector<int>	m_blocks;		//block indices by color, in order within a color
+	std::vector<int>	m_colorStart;	//the blocks of color c are m_blocks[m_colorStart[c], m_colorStart[c + 1])
+	std::vector<int>	m_corners;		//3 * f + j for corner j of face f (the source of f->he(), its next, its prev),
+	std::vector<int>	m_cornerStart;	//	by vertex: those of vertex v are m_corners[m_cornerStart[v], m_cornerStart[v + 1]),
+	unsigned long long	m_cornerRevision;	//	for this topology revision of the mesh
+	std::vector<int>	m_updatedFaces;
+	std::vector<int>	m_updatedVertices;
+	std::vector<char>	m_faceMarks;	//all 0 between calls
+	std::vector<char>	m_vertexMarks;
+};
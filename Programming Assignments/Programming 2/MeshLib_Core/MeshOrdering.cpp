@@ -0,0 +1,224 @@
+#include "MeshOrdering.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+	const int curveBits = 21;		//per axis: 63-bit curve keys
+
+	struct KeyedIndex
+	{
+		unsigned long long	key;
+		int					index;
+
+		bool operator<(const KeyedIndex & b) const { return key < b.key || (key == b.key && index < b.index); }
+	};
+
+	//the bits of x, y and z interleaved, most significant first (x before y before z)
+	inline unsigned long long interleave(const unsigned c[3])
+	{
+		unsigned long long key = 0;
+		for (int b = curveBits - 1; b >= 0; --b)
+			for (int k = 0; k < 3; ++k)
+				key = (key << 1) | ((c[k] >> b) & 1);
+		return key;
+	}
+
+	//position along the Hilbert curve of cell c, by Skilling's transform of the coordinates into the
+	//"transposed" Hilbert index (Programming the Hilbert curve, 2004), interleaved into one key
+	inline unsigned long long hilbertKey(unsigned c[3])
+	{
+		const unsigned m = 1u << (curveBits - 1);
+		for (unsigned q = m; q > 1; q >>= 1) {
+			unsigned p = q - 1;
+			for (int k = 0; k < 3; ++k) {
+				if (c[k] & q)
+					c[0] ^= p;
+				else {
+					unsigned t = (c[0] ^ c[k]) & p;
+					c[0] ^= t;
+					c[k] ^= t;
+				}
+			}
+		}
+		c[1] ^= c[0];
+		c[2] ^= c[1];
+		unsigned t = 0;
+		for (unsigned q = m; q > 1; q >>= 1)
+			if (c[2] & q) t ^= q - 1;
+		for (int k = 0; k < 3; ++k)
+			c[k] ^= t;
+		return interleave(c);
+	}
+}
+
+void MeshOrdering::clear()
+{
+	std::vector<int>().swap(vertexOrder);
+	std::vector<int>().swap(vertexRank);
+	std::vector<int>().swap(faceOrder);
+	std::vector<int>().swap(faceRank);
+}
+
+void MeshOrdering::build(Method method, const double * coords, int numVertices, const int * faceInds, int numFaces,
+	int numThreads)
+{
+	clear();
+	if (method == ReverseCuthillMcKee)
+		cuthillMcKeeOrder(faceInds, numVertices, numFaces);
+	else
+		curveOrder(method == Hilbert, coords, numVertices, numThreads);
+	vertexRank.resize(numVertices);
+	for (int i = 0; i < numVertices; ++i)
+		vertexRank[vertexOrder[i]] = i;
+	orderFaces(faceInds, numFaces, numThreads);
+}
+
+void MeshOrdering::curveOrder(bool hilbert, const double * coords, int numVertices, int numThreads)
+{
+	//cubic cells, so that the curve does not favor the long axis of a flat or thin mesh
+	double lo[3] = { 0, 0, 0 }, extent = 0;
+	for (int k = 0; k < 3; ++k) {
+		double a = HUGE_VAL, b = -HUGE_VAL;
+		for (int i = 0; i < numVertices; ++i) {
+			double x = coords[3 * i + k];
+			if (x < a) a = x;
+			if (x > b) b = x;
+		}
+		if (a <= b) {
+			lo[k] = a;
+			extent = std::max(extent, b - a);
+		}
+	}
+	const double scale = extent > 0 ? ((1u << curveBits) - 1) / extent : 0;
+
+	std::vector<KeyedIndex> keys(numVertices);
+	Parallel::forRange(numVertices, numThreads, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) {
+			unsigned c[3];
+			for (int k = 0; k < 3; ++k) {
+				double q = (coords[3 * i + k] - lo[k]) * scale;
+				c[k] = q > 0 ? (unsigned)std::min(q, (double)((1u << curveBits) - 1)) : 0;	//NaN goes to 0
+			}
+			keys[i].key = hilbert ? hilbertKey(c) : interleave(c);
+			keys[i].index = (int)i;
+		}
+	});
+	if (!keys.empty())
+		Parallel::sort(&keys[0], keys.size(), numThreads, std::less<KeyedIndex>());
+	vertexOrder.resize(numVertices);
+	for (int i = 0; i < numVertices; ++i)
+		vertexOrder[i] = keys[i].index;
+}
+
+void MeshOrdering::cuthillMcKeeOrder(const int * faceInds, int numVertices, int numFaces)
+{
+	//the neighbors of each vertex, sorted and without repeats
+	std::vector<int> start(numVertices + 1, 0);
+	for (size_t h = 0; h < 3 * (size_t)numFaces; ++h)
+		start[faceInds[h] + 1] += 2;
+	for (int v = 0; v < numVertices; ++v)
+		start[v + 1] += start[v];
+	std::vector<int> adjacent(start[numVertices]);
+	std::vector<int> fill(start.begin(), start.end() - 1);
+	for (int f = 0; f < numFaces; ++f)
+		for (int j = 0; j < 3; ++j) {
+			int v = faceInds[3 * f + j];
+			adjacent[fill[v]++] = faceInds[3 * f + (j + 1) % 3];
+			adjacent[fill[v]++] = faceInds[3 * f + (j + 2) % 3];
+		}
+	std::vector<int> degree(numVertices);
+	for (int v = 0; v < numVertices; ++v) {
+		std::vector<int>::iterator first = adjacent.begin() + start[v];
+		std::sort(first, adjacent.begin() + start[v + 1]);
+		degree[v] = (int)(std::unique(first, adjacent.begin() + start[v + 1]) - first);
+	}
+
+	//breadth-first from v over the vertices not placed yet, listing them in out; returns the number of levels
+	//and where the last one starts in out. seen is stamped rather than cleared between the searches
+	std::vector<int> seen(numVertices, -1);
+	int stamp = 0;
+	auto levels = [&](int v, std::vector<int> & out, size_t & lastBegin) {
+		++stamp;
+		out.clear();
+		out.push_back(v);
+		seen[v] = stamp;
+		int numLevels = 0;
+		for (size_t levelBegin = 0; levelBegin < out.size(); ++numLevels) {
+			size_t levelEnd = out.size();
+			for (size_t i = levelBegin; i < levelEnd; ++i)
+				for (int a = start[out[i]]; a < start[out[i]] + degree[out[i]]; ++a) {
+					int n = adjacent[a];
+					if (seen[n] != stamp && seen[n] != -2) {
+						seen[n] = stamp;
+						out.push_back(n);
+					}
+				}
+			lastBegin = levelBegin;
+			levelBegin = levelEnd;
+		}
+		return numLevels;
+	};
+	auto byDegree = [&](int a, int b) { return degree[a] < degree[b] || (degree[a] == degree[b] && a < b); };
+
+	vertexOrder.clear();
+	vertexOrder.reserve(numVertices);
+	std::vector<int> component;
+	for (int seed = 0; seed < numVertices; ++seed) {
+		if (seen[seed] == -2)
+			continue;
+		//pseudo-peripheral start (George and Liu): move to a vertex of lowest degree in the last level
+		//of the search for as long as that makes the search deeper
+		int first = seed;
+		size_t lastBegin;
+		int depth = levels(first, component, lastBegin);
+		for (int iteration = 0; iteration < 8; ++iteration) {
+			int next = component[lastBegin];
+			for (size_t i = lastBegin + 1; i < component.size(); ++i)
+				if (byDegree(component[i], next)) next = component[i];
+			int nextDepth = levels(next, component, lastBegin);
+			if (nextDepth <= depth)
+				break;
+			first = next;
+			depth = nextDepth;
+		}
+
+		//Cuthill-McKee: breadth-first from there, visiting the neighbors of each vertex by increasing degree
+		size_t head = vertexOrder.size();
+		vertexOrder.push_back(first);
+		seen[first] = -2;
+		for (; head < vertexOrder.size(); ++head) {
+			int v = vertexOrder[head];
+			size_t begin = vertexOrder.size();
+			for (int a = start[v]; a < start[v] + degree[v]; ++a)
+				if (seen[adjacent[a]] != -2) {
+					seen[adjacent[a]] = -2;
+					vertexOrder.push_back(adjacent[a]);
+				}
+			std::sort(vertexOrder.begin() + begin, vertexOrder.end(), byDegree);
+		}
+	}
+	std::reverse(vertexOrder.begin(), vertexOrder.end());
+}
+
+void MeshOrdering::orderFaces(const int * faceInds, int numFaces, int numThreads)
+{
+	std::vector<KeyedIndex> keys(numFaces);
+	Parallel::forRange(numFaces, numThreads, [&](size_t b, size_t e) {
+		for (size_t f = b; f < e; ++f) {
+			int r = std::min(vertexRank[faceInds[3 * f]], std::min(vertexRank[faceInds[3 * f + 1]], vertexRank[faceInds[3 * f + 2]]));
+			keys[f].key = (unsigned long long)r;
+			keys[f].index = (int)f;
+		}
+	});
+	if (!keys.empty())
+		Parallel::sort(&keys[0], keys.size(), numThreads, std::less<KeyedIndex>());
+	faceOrder.resize(numFaces);
+	faceRank.resize(numFaces);
+	for (int i = 0; i < numFaces; ++i) {
+		faceOrder[i] = keys[i].index;
+		faceRank[keys[i].index] = i;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+// Orderings of the vertices and faces of a triangle mesh that keep neighbors close in memory.
+// The vertices are ordered along a space-filling curve through their bounding box, or by the
+// reverse Cuthill-McKee ordering of the vertex graph, which keeps the indices of the two ends of
+// every edge close (low bandwidth). The faces then follow their vertices: by the lowest new index
+// of their corners, in the original order between ties.
+// Mesh::reorder() renumbers a mesh with them.
+class MeshOrdering
+{
+public:
+	enum Method
+	{
+		Morton,					//Z-order curve
+		Hilbert,				//Hilbert curve: no jumps between cells, slightly slower to compute
+		ReverseCuthillMcKee		//breadth-first over the edges, from a peripheral vertex of each component
+	};
+
+	//order numVertices vertices (xyz coords) used by numFaces triangles (3 vertex indices each),
+	//using numThreads threads (0: all cores) for the sorts; the result does not depend on the thread count
+	void build(Method method, const double * coords, int numVertices, const int * faceInds, int numFaces,
+		int numThreads = 0);
+	void clear();
+
+	std::vector<int>	vertexOrder;	//old index of the i-th vertex of the new order
+	std::vector<int>	vertexRank;		//new index of each old vertex
+	std::vector<int>	faceOrder;		//old index of the i-th face of the new order
+	std::vector<int>	faceRank;		//new index of each old face
+
+private:
+	void curveOrder(bool hilbert, const double * coords, int numVertices, int numThreads);
+	void cuthillMcKeeOrder(const int * faceInds, int numVertices, int numFaces);
+	void orderFaces(const int * faceInds, int numFaces, int numThreads);
+};
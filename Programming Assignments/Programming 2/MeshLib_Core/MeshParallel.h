@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+// Per-element loops over a mesh on a ThreadPool. f(Vertex *), f(Face *) or f(Halfedge *) runs once for every
+// element, in blocks of grain consecutive elements: mesh.vertices() and mesh.faces() order, and the slot order
+// of mesh.halfedges(). f may write what belongs to its element (its attributes, for a halfedge also the
+// entry of one other halfedge it alone maps to) and read anything else; adding into the attributes of
+// neighbors would race, so a vertex sums over its halfedges instead of every halfedge adding into its source.
+//
+//		parallelForFaces(mesh, [&](Face * f) { normals[f] = ...; });
+//		double area = parallelReduceFaces(mesh, 0.0, [&](Face * f) { return areas[f]; }, std::plus<double>());
+//
+// The reductions fold map(element) into identity block by block, in element order, and then combine the
+// block results in block order: the result only depends on the grain, not on the thread count.
+
+template <class F>
+void parallelForVertices(const Mesh & mesh, F f, size_t grain = 1024, ThreadPool & pool = ThreadPool::global())
+{
+	const std::vector<Vertex *> & vertices = mesh.vertices();
+	pool.parallelFor(vertices.size(), grain, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) f(vertices[i]);
+	});
+}
+
+template <class F>
+void parallelForFaces(const Mesh & mesh, F f, size_t grain = 1024, ThreadPool & pool = ThreadPool::global())
+{
+	const std::vector<Face *> & faces = mesh.faces();
+	pool.parallelFor(faces.size(), grain, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i) f(faces[i]);
+	});
+}
+
+template <class F>
+void parallelForHalfedges(const Mesh & mesh, F f, size_t grain = 4096, ThreadPool & pool = ThreadPool::global())
+{
+	MeshHalfedgeRange halfedges = mesh.halfedges();
+	pool.parallelFor(halfedges.size(), grain, [&](size_t b, size_t e) {
+		MeshHalfedgeRange::iterator it = halfedges.begin() + (std::ptrdiff_t)b;
+		for (size_t i = b; i < e; ++i, ++it) f(*it);
+	});
+}
+
+template <class T, class Map, class Combine>
+T parallelReduceVertices(const Mesh & mesh, T identity, Map map, Combine combine, size_t grain = 1024,
+	ThreadPool & pool = ThreadPool::global())
+{
+	const std::vector<Vertex *> & vertices = mesh.vertices();
+	return pool.parallelReduce(vertices.size(), grain, identity, [&](size_t b, size_t e) {
+		T value = identity;
+		for (size_t i = b; i < e; ++i) value = combine(value, map(vertices[i]));
+		return value;
+	}, combine);
+}
+
+template <class T, class Map, class Combine>
+T parallelReduceFaces(const Mesh & mesh, T identity, Map map, Combine combine, size_t grain = 1024,
+	ThreadPool & pool = ThreadPool::global())
+{
+	const std::vector<Face *> & faces = mesh.faces();
+	return pool.parallelReduce(faces.size(), grain, identity, [&](size_t b, size_t e) {
+		T value = identity;
+		for (size_t i = b; i < e; ++i) value = combine(value, map(faces[i]));
+		return value;
+	}, combine);
+}
+
+template <class T, class Map, class Combine>
+T parallelReduceHalfedges(const Mesh & mesh, T identity, Map map, Combine combine, size_t grain = 4096,
+	ThreadPool & pool = ThreadPool::global())
+{
+	MeshHalfedgeRange halfedges = mesh.halfedges();
+	return pool.parallelReduce(halfedges.size(), grain, identity, [&](size_t b, size_t e) {
+		T value = identity;
+		MeshHalfedgeRange::iterator it = halfedges.begin() + (std::ptrdiff_t)b;
+		for (size_t i = b; i < e; ++i, ++it) value = combine(value, map(*it));
+		return value;
+	}, combine);
+}
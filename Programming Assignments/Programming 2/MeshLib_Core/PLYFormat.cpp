@@ -0,0 +1,140 @@
+#include "PLYFormat.h"
+#include <cstdlib>
+
+namespace PLYFormat
+{
+	static const char * const typeNames[] = { "char", "uchar", "short", "ushort", "int", "uint", "float", "double", "" };
+	static const char * const sizedTypeNames[] = { "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64", "" };
+
+	const char * typeName(Type type) { return typeNames[type]; }
+
+	Type typeFromName(const std::string & name)
+	{
+		for (int t = 0; t < NoType; ++t)
+			if (name == typeNames[t] || name == sizedTypeNames[t])
+				return (Type)t;
+		return NoType;
+	}
+
+	int Element::findProperty(const std::string & propName) const
+	{
+		for (size_t i = 0; i < properties.size(); ++i)
+			if (properties[i].name == propName)
+				return (int)i;
+		return -1;
+	}
+
+	size_t Element::recordSize() const
+	{
+		size_t bytes = 0;
+		for (size_t i = 0; i < properties.size(); ++i) {
+			if (properties[i].countType != NoType)
+				return 0;
+			bytes += typeSize(properties[i].type);
+		}
+		return bytes;
+	}
+
+	int Header::findElement(const std::string & elementName) const
+	{
+		for (size_t i = 0; i < elements.size(); ++i)
+			if (elements[i].name == elementName)
+				return (int)i;
+		return -1;
+	}
+
+	//split the line [p, end) into blank-separated words
+	static void splitWords(const char * p, const char * end, std::vector<std::string> & words)
+	{
+		words.clear();
+		while (true) {
+			p = TextParse::skipBlanks(p, end);
+			if (p >= end || TextParse::isLineEnd(*p))
+				return;
+			const char * q = TextParse::skipToken(p, end);
+			words.push_back(std::string(p, q));
+			p = q;
+		}
+	}
+
+	bool Header::parse(const char * p, const char * end, std::string & error)
+	{
+		const char * start = p;
+		elements.clear();
+		encoding = Ascii;
+		std::vector<std::string> words;
+		bool hasFormat = false;
+		for (int line = 0; p < end; ++line) {
+			const char * next = TextParse::nextLine(p, end);
+			splitWords(p, next, words);
+			p = next;
+			if (line == 0) {
+				if (words.size() != 1 || words[0] != "ply") {
+					error = "not a PLY file";
+					return false;
+				}
+				continue;
+			}
+			if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+				continue;
+			if (words[0] == "end_header") {
+				if (!hasFormat) {
+					error = "no format line";
+					return false;
+				}
+				size = p - start;
+				return true;
+			}
+			if (words[0] == "format" && words.size() >= 2) {
+				if (words[1] == "ascii") encoding = Ascii;
+				else if (words[1] == "binary_little_endian") encoding = BinaryLittleEndian;
+				else if (words[1] == "binary_big_endian") encoding = BinaryBigEndian;
+				else {
+					error = "unknown format " + words[1];
+					return false;
+				}
+				hasFormat = true;
+			}
+			else if (words[0] == "element" && words.size() == 3) {
+				Element element;
+				element.name = words[1];
+				element.count = atoll(words[2].c_str());
+				if (element.count < 0) {
+					error = "negative count of element " + words[1];
+					return false;
+				}
+				elements.push_back(element);
+			}
+			else if (words[0] == "property" && !elements.empty()) {
+				Property prop;
+				if (words.size() == 3) {
+					prop.type = typeFromName(words[1]);
+					prop.countType = NoType;
+					prop.name = words[2];
+				}
+				else if (words.size() == 5 && words[1] == "list") {
+					prop.countType = typeFromName(words[2]);
+					prop.type = typeFromName(words[3]);
+					prop.name = words[4];
+					if (prop.countType == NoType || prop.countType == Float32 || prop.countType == Float64) {
+						error = "bad list count type " + words[2];
+						return false;
+					}
+				}
+				else
+					prop.type = NoType;
+				if (prop.type == NoType) {
+					error = "bad property line";
+					return false;
+				}
+				elements.back().properties.push_back(prop);
+			}
+			else {
+				error = "bad header line " + (words.empty() ? std::string() : words[0]);
+				return false;
+			}
+		}
+		error = "no end_header line";
+		return false;
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "TextParse.h"
+
+// The PLY ("Stanford polygon") format used by Mesh::readPLYFile() and Mesh::writePLYFile().
+// A text header lists the elements of the file (vertex, face, ...) with their count and properties,
+// followed by the element records either as ASCII text or as packed binary values.
+namespace PLYFormat
+{
+	enum Encoding { Ascii, BinaryLittleEndian, BinaryBigEndian };
+	enum Type { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, NoType };
+
+	inline int		typeSize(Type type)
+	{
+		static const int sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+		return sizes[type];
+	}
+	const char *	typeName(Type type);					//the name written in headers ("uchar", "float", ...)
+	Type			typeFromName(const std::string & name);	//accepts both "uchar" and "uint8" styles, NoType if unknown
+
+	struct Property
+	{
+		std::string	name;
+		Type		type;		//type of the value, or of the items of a list
+		Type		countType;	//type of the item count of a list, NoType for a single value
+	};
+
+	struct Element
+	{
+		std::string				name;
+		long long				count;
+		std::vector<Property>	properties;
+
+		int		findProperty(const std::string & name) const;	//-1 if there is none
+		size_t	recordSize() const;								//bytes of a binary record, 0 if it has a list
+	};
+
+	struct Header
+	{
+		Encoding				encoding;
+		std::vector<Element>	elements;
+		size_t					size;		//bytes up to and including the "end_header" line
+
+		//parse the header at the start of [p, end); error tells what is wrong when it fails
+		bool	parse(const char * p, const char * end, std::string & error);
+		int		findElement(const std::string & name) const;	//-1 if there is none
+	};
+
+	inline bool hostIsLittleEndian()
+	{
+		const uint16_t one = 1;
+		return *(const unsigned char *)&one == 1;
+	}
+
+	//Sequential reader of the values of the element records, for either encoding.
+	//Reading past the end yields zeros and clears ok().
+	class ValueReader
+	{
+	public:
+		ValueReader(const char * p, const char * end, Encoding encoding)
+			: m_p(p), m_end(end), m_ascii(encoding == Ascii),
+			m_swap(encoding != Ascii && (encoding == BinaryLittleEndian) != hostIsLittleEndian()), m_ok(true) {;}
+
+		double read(Type type)
+		{
+			if (m_ascii) {
+				while (m_p < m_end && (TextParse::isBlank(*m_p) || TextParse::isLineEnd(*m_p))) ++m_p;
+				if (m_p >= m_end) { m_ok = false; return 0; }
+				double value;
+				const char * q = TextParse::parseDouble(m_p, m_end, value);
+				m_p = (q == m_p) ? TextParse::skipToken(m_p, m_end) : q;
+				return value;
+			}
+			int n = typeSize(type);
+			if (m_end - m_p < n) { m_p = m_end; m_ok = false; return 0; }
+			double value = decode(m_p, type, m_swap);
+			m_p += n;
+			return value;
+		}
+
+		//the binary value of the given type at p
+		static double decode(const char * p, Type type, bool swap)
+		{
+			switch (type) {
+			case Int8:		return load<int8_t>(p, swap);
+			case UInt8:		return load<uint8_t>(p, swap);
+			case Int16:		return load<int16_t>(p, swap);
+			case UInt16:	return load<uint16_t>(p, swap);
+			case Int32:		return load<int32_t>(p, swap);
+			case UInt32:	return load<uint32_t>(p, swap);
+			case Float32:	return load<float>(p, swap);
+			case Float64:	return load<double>(p, swap);
+			default:		return 0;
+			}
+		}
+
+		//skip a whole property: one value, or a list with its count
+		void skip(const Property & prop)
+		{
+			if (prop.countType == NoType) {
+				read(prop.type);
+				return;
+			}
+			long long n = (long long)read(prop.countType);
+			if (!m_ascii && n > 0) {
+				long long bytes = n * typeSize(prop.type);
+				if (m_end - m_p < bytes) { m_p = m_end; m_ok = false; return; }
+				m_p += bytes;
+				return;
+			}
+			for (long long i = 0; i < n && m_ok; ++i)
+				read(prop.type);
+		}
+
+		const char *	position() const { return m_p; }
+		const char *	end() const { return m_end; }
+		bool			binary() const { return !m_ascii; }
+		bool			swapped() const { return m_swap; }
+		bool			ok() const { return m_ok; }
+		void			seek(const char * p) { m_p = p; }	//continue at p, after the caller decoded [position(), p) itself
+
+	private:
+		template <class T>
+		static T load(const char * p, bool swap)
+		{
+			T value;
+			if (!swap) {
+				memcpy(&value, p, sizeof(T));
+				return value;
+			}
+			char bytes[sizeof(T)];
+			for (size_t i = 0; i < sizeof(T); ++i)
+				bytes[i] = p[sizeof(T) - 1 - i];
+			memcpy(&value, bytes, sizeof(T));
+			return value;
+		}
+
+		const char *	m_p;
+		const char *	m_end;
+		bool			m_ascii;
+		bool			m_swap;		//the file is binary of the other endianness
+		bool			m_ok;
+	};
+}
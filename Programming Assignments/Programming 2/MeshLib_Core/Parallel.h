@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "ThreadPool.h"
+
+// Minimal fork-join helpers used by the bulk mesh operations.
+// Work is always split into the same chunks for a given thread count, and every helper
+// produces the same result whatever the thread count.
+// They run on ThreadPool::global(), like the per-element loops, so that the whole library shares one set of
+// threads: numThreads bounds how many of them work on a call, and more than the pool has run as many as it has.
+namespace Parallel
+{
+	//number of threads used when a caller passes 0: those of the global pool
+	inline int defaultThreadCount()
+	{
+		return ThreadPool::global().numThreads();
+	}
+
+	inline int resolveThreadCount(int numThreads)
+	{
+		return numThreads > 0 ? numThreads : defaultThreadCount();
+	}
+
+	//run f(chunk) for every chunk in [0, numChunks), spreading the chunks over numThreads threads: in runs of
+	//consecutive chunks, one per thread, when that is fewer than the pool has, one at a time otherwise
+	template <class F>
+	void forChunks(int numChunks, int numThreads, F f)
+	{
+		numThreads = std::min(resolveThreadCount(numThreads), numChunks);
+		if (numThreads <= 1) {
+			for (int c = 0; c < numChunks; ++c) f(c);
+			return;
+		}
+		ThreadPool & pool = ThreadPool::global();
+		size_t grain = numThreads < pool.numThreads() ? (numChunks + numThreads - 1) / numThreads : 1;
+		pool.parallelFor(numChunks, grain, [&](size_t b, size_t e) {
+			for (size_t c = b; c < e; ++c) f((int)c);
+		});
+	}
+
+	//run f(begin, end) on numThreads contiguous slices of [0, n)
+	template <class F>
+	void forRange(size_t n, int numThreads, F f)
+	{
+		numThreads = resolveThreadCount(numThreads);
+		if (n < 1024) numThreads = 1;		//not worth a thread
+		forChunks(numThreads, numThreads, [&](int c) {
+			f(n * c / numThreads, n * (c + 1) / numThreads);
+		});
+	}
+
+	//out[i] = in[0] + ... + in[i-1]; returns the total. in and out may alias.
+	template <class In, class Out>
+	Out exclusiveScan(const In * in, Out * out, size_t n, int numThreads)
+	{
+		numThreads = resolveThreadCount(numThreads);
+		if (n < 1024) numThreads = 1;
+		std::vector<Out> sums(numThreads + 1, Out(0));
+		forChunks(numThreads, numThreads, [&](int c) {
+			Out s = Out(0);
+			for (size_t i = n * c / numThreads, e = n * (c + 1) / numThreads; i < e; ++i) s += (Out)in[i];
+			sums[c + 1] = s;
+		});
+		for (int c = 0; c < numThreads; ++c) sums[c + 1] += sums[c];
+		forChunks(numThreads, numThreads, [&](int c) {
+			Out s = sums[c];
+			for (size_t i = n * c / numThreads, e = n * (c + 1) / numThreads; i < e; ++i) {
+				Out v = (Out)in[i];
+				out[i] = s;
+				s += v;
+			}
+		});
+		return sums[numThreads];
+	}
+
+	//sort [first, first + n): each thread sorts a slice, then the slices are merged pairwise.
+	//less must be a strict total order for the result to be independent of the thread count.
+	template <class T, class Less>
+	void sort(T * first, size_t n, int numThreads, Less less)
+	{
+		numThreads = resolveThreadCount(numThreads);
+		if (numThreads <= 1 || n < 8192) {
+			std::sort(first, first + n, less);
+			return;
+		}
+		std::vector<size_t> bounds(numThreads + 1);
+		for (int c = 0; c <= numThreads; ++c) bounds[c] = n * c / numThreads;
+		forChunks(numThreads, numThreads, [&](int c) {
+			std::sort(first + bounds[c], first + bounds[c + 1], less);
+		});
+
+		std::vector<T> buffer(n);
+		T * src = first;
+		T * dst = &buffer[0];
+		for (size_t width = 1; width < (size_t)numThreads; width *= 2) {
+			int numMerges = (int)((numThreads + 2 * width - 1) / (2 * width));
+			forChunks(numMerges, numThreads, [&](int m) {
+				size_t lo = bounds[m * 2 * width];
+				size_t mid = bounds[std::min((size_t)numThreads, m * 2 * width + width)];
+				size_t hi = bounds[std::min((size_t)numThreads, m * 2 * width + 2 * width)];
+				std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, less);
+			});
+			std::swap(src, dst);
+		}
+		if (src != first)
+			std::copy(src, src + n, first);
+	}
+}
@@ -2,42 +2,63 @@
 #include <cmath>
 
 /*!
-* The Point Class
+* The Point Class, on scalar type T: Point is PointT<double> and PointF PointT<float>.
+* Points of the two precisions convert into each other implicitly.
 */
-class Point
+template <class T>
+class PointT
 {
 public:
-	/*! 
+	typedef T Scalar;
+
+	/*!
 	*Constructor
 	@param x x coordinate
 	@param y y coordinate
 	@param z z coordinate
 	*/
-	Point( double x, double y, double z ){ v[0] = x; v[1] = y; v[2] = z;}							
-	Point() { v[0] = v[1] = v[2] = 0; }																/*! Default Constructor */
-	~Point() {;}				
-
-	double & operator[](int i) {return v[i];}														/*! Accessing the i-th coordinator */	
-	double norm() const { return sqrt( fabs( v[0] * v[0] + v[1] * v[1] + v[2] * v[2] ) );}			/*! Square root distance to the origin */
-	double norm2() const { return fabs( v[0] * v[0] + v[1] * v[1] + v[2] * v[2] ) ;}				/*! Square distance to the origin */
-
-	Point  & operator += ( Point & p) { v[0] += p[0]; v[1] += p[1]; v[2] += p[2]; return *this; }	/*! Adding two point vectors (3-dimensional vectors) */
-	Point  & operator -= ( Point & p) { v[0] -= p[0]; v[1] -= p[1]; v[2] -= p[2]; return *this; }	/*! Subtraction between two point vectors (3-dimensional vectors) */
-	Point  & operator *= ( double  s) { v[0] *= s   ; v[1] *=    s; v[2] *=    s; return *this; }	/*! Scaling a (3-dimensional vectors) */
-	Point  & operator /= ( double  s) { v[0] /= s   ; v[1] /=    s; v[2] /=    s; return *this; }	/*! Scale division (3-dimensional vectors) */
-
-	double	operator*(Point & p)	const	{return v[0]*p[0]+ v[1]*p[1] + v[2]*p[2];}
-	Point	operator+(Point & p)	const	{return Point(v[0]+p[0], v[1]+p[1], v[2]+p[2]);}
-	Point	operator-(Point & p)	const	{return Point(v[0]-p[0], v[1]-p[1], v[2]-p[2]);}
-	Point	operator*(double s )	const	{return Point(v[0]*s, v[1]*s, v[2]*s);}
-	Point	operator/(double s )	const	{return Point(v[0]/s, v[1]/s, v[2]/s);}
-	Point	operator-()				const	{return Point(-v[0],-v[1],-v[2]);}
-	Point	operator^( Point & p2)	const	{
-		return Point( v[1] * p2[2] - v[2] * p2[1],
+	PointT( T x, T y, T z ){ v[0] = x; v[1] = y; v[2] = z;}
+	PointT() { v[0] = v[1] = v[2] = 0; }															/*! Default Constructor */
+	template <class U>
+	PointT( const PointT<U> & p ) { v[0] = (T)p.v[0]; v[1] = (T)p.v[1]; v[2] = (T)p.v[2]; }			/*! Conversion from the other precision */
+	~PointT() {;}
+
+	T & operator[](int i) {return v[i];}															/*! Accessing the i-th coordinator */
+	const T & operator[](int i) const {return v[i];}
+	T norm() const { return std::sqrt( std::fabs( v[0] * v[0] + v[1] * v[1] + v[2] * v[2] ) );}				/*! Square root distance to the origin */
+	T norm2() const { return std::fabs( v[0] * v[0] + v[1] * v[1] + v[2] * v[2] ) ;}					/*! Square distance to the origin */
+
+	PointT  & operator += ( const PointT & p) { v[0] += p[0]; v[1] += p[1]; v[2] += p[2]; return *this; }	/*! Adding two point vectors (3-dimensional vectors) */
+	PointT  & operator -= ( const PointT & p) { v[0] -= p[0]; v[1] -= p[1]; v[2] -= p[2]; return *this; }	/*! Subtraction between two point vectors (3-dimensional vectors) */
+	PointT  & operator *= ( T  s) { v[0] *= s   ; v[1] *=    s; v[2] *=    s; return *this; }			/*! Scaling a (3-dimensional vectors) */
+	PointT  & operator /= ( T  s) { v[0] /= s   ; v[1] /=    s; v[2] /=    s; return *this; }			/*! Scale division (3-dimensional vectors) */
+
+	T		operator*(const PointT & p)	const	{return v[0]*p[0]+ v[1]*p[1] + v[2]*p[2];}
+	PointT	operator+(const PointT & p)	const	{return PointT(v[0]+p[0], v[1]+p[1], v[2]+p[2]);}
+	PointT	operator-(const PointT & p)	const	{return PointT(v[0]-p[0], v[1]-p[1], v[2]-p[2]);}
+	PointT	operator*(T s )				const	{return PointT(v[0]*s, v[1]*s, v[2]*s);}
+	PointT	operator/(T s )				const	{return PointT(v[0]/s, v[1]/s, v[2]/s);}
+	PointT	operator-()					const	{return PointT(-v[0],-v[1],-v[2]);}
+	PointT	operator^( const PointT & p2)	const	{
+		return PointT( v[1] * p2[2] - v[2] * p2[1],
 				 v[2] * p2[0] - v[0] * p2[2],
 				 v[0] * p2[1] - v[1] * p2[0]);}
 
 
 public:
-	double v[3];
+	T v[3];
 };
+
+typedef PointT<double>	Point;
+typedef PointT<float>	PointF;
+
+// The precision of the geometry a Mesh stores: its vertex positions, and the normals, areas, angles and
+// curvature MeshGeometry computes. Double unless the library and the program are built with
+// MESHLIB_FLOAT_GEOMETRY defined, which halves the memory and bandwidth they take, for rendering and
+// analyses that need no more than float precision. The readers and writers convert from and to it.
+#ifdef MESHLIB_FLOAT_GEOMETRY
+typedef float	MeshScalar;
+#else
+typedef double	MeshScalar;
+#endif
+typedef PointT<MeshScalar>	MeshPoint;
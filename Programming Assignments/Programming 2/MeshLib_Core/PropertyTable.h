@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Sparse table of property strings (the "{...}" blocks of M files), keyed by element index.
+// Only the elements that have a property take any memory; all others read as an empty string.
+class PropertyTable
+{
+public:
+	//the property of element id, "" when it has none
+	const std::string & get(int id) const
+	{
+		static const std::string none;
+		if (m_props.empty())
+			return none;
+		std::unordered_map<int, std::string>::const_iterator it = m_props.find(id);
+		return it == m_props.end() ? none : it->second;
+	}
+
+	//set the property of element id; an empty string removes it
+	void set(int id, const std::string & str)
+	{
+		if (str.empty())
+			m_props.erase(id);
+		else
+			m_props[id] = str;
+	}
+
+	bool has(int id) const { return !m_props.empty() && m_props.count(id) > 0; }
+	size_t size() const { return m_props.size(); }
+	bool empty() const { return m_props.empty(); }
+	void clear() { std::unordered_map<int, std::string>().swap(m_props); }
+
+	//the ids of the elements that have a property, in increasing order
+	std::vector<int> ids() const
+	{
+		std::vector<int> result;
+		result.reserve(m_props.size());
+		for (std::unordered_map<int, std::string>::const_iterator it = m_props.begin(); it != m_props.end(); ++it)
+			result.push_back(it->first);
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	//approximate bytes held by the table: buckets, one node per entry and the long strings
+	size_t memoryUsage() const
+	{
+		size_t bytes = sizeof(PropertyTable) + m_props.bucket_count() * sizeof(void *);
+		for (std::unordered_map<int, std::string>::const_iterator it = m_props.begin(); it != m_props.end(); ++it) {
+			bytes += sizeof(void *) + sizeof(size_t) + sizeof(std::pair<const int, std::string>);
+			if (it->second.capacity() > 15)
+				bytes += it->second.capacity() + 1;
+		}
+		return bytes;
+	}
+
+private:
+	std::unordered_map<int, std::string>	m_props;
+};
@@ -0,0 +1,266 @@
+#include "SimdGeometry.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Each vector type V below provides the same interface, over which the kernel is written once:
+//		V::Scalar, V::size, V::Index		the element type, the lanes, a vector of vertex indices
+//		V::splat(s), V::indices(p)			s in every lane; p[0], p[3], p[6]... (a corner of consecutive faces)
+//		V::gather(base, index), v.store(p)
+//		+ - * /, sqrtOf, absOf, minOf, maxOf
+//		less(a, b), select(mask, a, b)		a lane mask, and a where the mask is set, b elsewhere
+namespace
+{
+	//the portable vector: N lanes in a plain array
+	template <class T, int N>
+	struct Lanes
+	{
+		typedef T Scalar;
+		enum { size = N };
+		struct Index { int v[N]; };
+
+		T v[N];
+
+		static Lanes splat(T s) { Lanes r; for (int i = 0; i < N; ++i) r.v[i] = s; return r; }
+		static Index indices(const int * p) { Index r; for (int i = 0; i < N; ++i) r.v[i] = p[3 * i]; return r; }
+		static Lanes gather(const T * base, const Index & index)
+		{
+			Lanes r;
+			for (int i = 0; i < N; ++i) r.v[i] = base[index.v[i]];
+			return r;
+		}
+		void store(T * p) const { for (int i = 0; i < N; ++i) p[i] = v[i]; }
+	};
+
+#define LANEWISE(result, expression) \
+	template <class T, int N> inline Lanes<T, N> result \
+	{ Lanes<T, N> r; for (int i = 0; i < N; ++i) r.v[i] = expression; return r; }
+	LANEWISE(operator+(const Lanes<T, N> & a, const Lanes<T, N> & b), a.v[i] + b.v[i])
+	LANEWISE(operator-(const Lanes<T, N> & a, const Lanes<T, N> & b), a.v[i] - b.v[i])
+	LANEWISE(operator*(const Lanes<T, N> & a, const Lanes<T, N> & b), a.v[i] * b.v[i])
+	LANEWISE(operator/(const Lanes<T, N> & a, const Lanes<T, N> & b), a.v[i] / b.v[i])
+	LANEWISE(operator-(const Lanes<T, N> & a), -a.v[i])
+	LANEWISE(sqrtOf(const Lanes<T, N> & a), std::sqrt(a.v[i]))
+	LANEWISE(absOf(const Lanes<T, N> & a), std::fabs(a.v[i]))
+	LANEWISE(minOf(const Lanes<T, N> & a, const Lanes<T, N> & b), a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+	LANEWISE(maxOf(const Lanes<T, N> & a, const Lanes<T, N> & b), a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+	LANEWISE(less(const Lanes<T, N> & a, const Lanes<T, N> & b), a.v[i] < b.v[i] ? T(1) : T(0))
+	LANEWISE(select(const Lanes<T, N> & mask, const Lanes<T, N> & a, const Lanes<T, N> & b), mask.v[i] != 0 ? a.v[i] : b.v[i])
+#undef LANEWISE
+
+#if defined(__AVX2__)
+	struct Double4
+	{
+		typedef double Scalar;
+		enum { size = 4 };
+		typedef __m128i Index;
+
+		__m256d v;
+
+		static Double4 make(__m256d v) { Double4 r; r.v = v; return r; }
+		static Double4 splat(double s) { return make(_mm256_set1_pd(s)); }
+		//the masked gathers, all lanes on: the plain ones leave their source register undefined, which GCC warns about
+		static Index indices(const int * p)
+		{
+			return _mm_mask_i32gather_epi32(_mm_setzero_si128(), p, _mm_setr_epi32(0, 3, 6, 9), _mm_set1_epi32(-1), 4);
+		}
+		static Double4 gather(const double * base, Index index)
+		{
+			return make(_mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, index, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8));
+		}
+		void store(double * p) const { _mm256_storeu_pd(p, v); }
+	};
+
+	inline Double4 operator+(Double4 a, Double4 b)	{ return Double4::make(_mm256_add_pd(a.v, b.v)); }
+	inline Double4 operator-(Double4 a, Double4 b)	{ return Double4::make(_mm256_sub_pd(a.v, b.v)); }
+	inline Double4 operator*(Double4 a, Double4 b)	{ return Double4::make(_mm256_mul_pd(a.v, b.v)); }
+	inline Double4 operator/(Double4 a, Double4 b)	{ return Double4::make(_mm256_div_pd(a.v, b.v)); }
+	inline Double4 operator-(Double4 a)				{ return Double4::make(_mm256_xor_pd(a.v, _mm256_set1_pd(-0.0))); }
+	inline Double4 sqrtOf(Double4 a)				{ return Double4::make(_mm256_sqrt_pd(a.v)); }
+	inline Double4 absOf(Double4 a)					{ return Double4::make(_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)); }
+	inline Double4 minOf(Double4 a, Double4 b)		{ return Double4::make(_mm256_min_pd(a.v, b.v)); }
+	inline Double4 maxOf(Double4 a, Double4 b)		{ return Double4::make(_mm256_max_pd(a.v, b.v)); }
+	inline Double4 less(Double4 a, Double4 b)		{ return Double4::make(_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)); }
+	inline Double4 select(Double4 mask, Double4 a, Double4 b) { return Double4::make(_mm256_blendv_pd(b.v, a.v, mask.v)); }
+
+	struct Float8
+	{
+		typedef float Scalar;
+		enum { size = 8 };
+		typedef __m256i Index;
+
+		__m256 v;
+
+		static Float8 make(__m256 v) { Float8 r; r.v = v; return r; }
+		static Float8 splat(float s) { return make(_mm256_set1_ps(s)); }
+		static Index indices(const int * p)
+		{
+			return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), p, _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21),
+				_mm256_set1_epi32(-1), 4);
+		}
+		static Float8 gather(const float * base, Index index)
+		{
+			return make(_mm256_mask_i32gather_ps(_mm256_setzero_ps(), base, index, _mm256_castsi256_ps(_mm256_set1_epi32(-1)), 4));
+		}
+		void store(float * p) const { _mm256_storeu_ps(p, v); }
+	};
+
+	inline Float8 operator+(Float8 a, Float8 b)	{ return Float8::make(_mm256_add_ps(a.v, b.v)); }
+	inline Float8 operator-(Float8 a, Float8 b)	{ return Float8::make(_mm256_sub_ps(a.v, b.v)); }
+	inline Float8 operator*(Float8 a, Float8 b)	{ return Float8::make(_mm256_mul_ps(a.v, b.v)); }
+	inline Float8 operator/(Float8 a, Float8 b)	{ return Float8::make(_mm256_div_ps(a.v, b.v)); }
+	inline Float8 operator-(Float8 a)			{ return Float8::make(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+	inline Float8 sqrtOf(Float8 a)				{ return Float8::make(_mm256_sqrt_ps(a.v)); }
+	inline Float8 absOf(Float8 a)				{ return Float8::make(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+	inline Float8 minOf(Float8 a, Float8 b)		{ return Float8::make(_mm256_min_ps(a.v, b.v)); }
+	inline Float8 maxOf(Float8 a, Float8 b)		{ return Float8::make(_mm256_max_ps(a.v, b.v)); }
+	inline Float8 less(Float8 a, Float8 b)		{ return Float8::make(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+	inline Float8 select(Float8 mask, Float8 a, Float8 b) { return Float8::make(_mm256_blendv_ps(b.v, a.v, mask.v)); }
+
+	template <class T> struct Vector;
+	template <> struct Vector<double>	{ typedef Double4 Type; };
+	template <> struct Vector<float>	{ typedef Float8 Type; };
+	const char * const vectorName = "AVX2";
+#else
+	template <class T> struct Vector;
+	template <> struct Vector<double>	{ typedef Lanes<double, 4> Type; };
+	template <> struct Vector<float>	{ typedef Lanes<float, 8> Type; };
+	const char * const vectorName = "portable";
+#endif
+
+	//atan(u) for |u| <= 0.66 (Cephes): u + u^3 P(u^2) / Q(u^2) in double, a polynomial in float,
+	//and the largest u the approximation is used for after the reduction atan(t) = pi / 4 + atan((t - 1) / (t + 1))
+	template <class V>
+	inline V atanReduced(V u, double)
+	{
+		typedef typename V::Scalar T;
+		V z = u * u;
+		V p = (((V::splat(T(-8.750608600031904122785e-1)) * z + V::splat(T(-1.615753718733365076637e1))) * z
+			+ V::splat(T(-7.500855792314704667340e1))) * z + V::splat(T(-1.228866684490136173410e2))) * z
+			+ V::splat(T(-6.485021904942025371773e1));
+		V q = ((((z + V::splat(T(2.485846490142306297962e1))) * z + V::splat(T(1.650270098316988542046e2))) * z
+			+ V::splat(T(4.328810604912902668951e2))) * z + V::splat(T(4.853903996359136964868e2))) * z
+			+ V::splat(T(1.945506571482613964425e2));
+		return u + u * z * p / q;
+	}
+	inline double reductionThreshold(double) { return 0.66; }
+
+	template <class V>
+	inline V atanReduced(V u, float)
+	{
+		typedef typename V::Scalar T;
+		V z = u * u;
+		V p = ((V::splat(T(8.05374449538e-2)) * z - V::splat(T(1.38776856032e-1))) * z
+			+ V::splat(T(1.99777106478e-1))) * z - V::splat(T(3.33329491539e-1));
+		return u + u * z * p;
+	}
+	inline float reductionThreshold(float) { return 0.4142135623730950488f; }
+
+	//atan2(y, x) for y >= 0, in [0, pi]: atan of min(y, |x|) / max(y, |x|) in [0, 1], then reflected
+	template <class V>
+	inline V angle(V y, V x)
+	{
+		typedef typename V::Scalar T;
+		const V zero = V::splat(T(0)), one = V::splat(T(1));
+		const T pi = T(3.14159265358979323846);
+		V ax = absOf(x);
+		V hi = maxOf(y, ax), lo = minOf(y, ax);
+		V t = select(less(zero, hi), lo / hi, zero);
+		V reduce = less(V::splat(reductionThreshold(T())), t);
+		V u = select(reduce, (t - one) / (t + one), t);
+		V a = atanReduced(u, T()) + select(reduce, V::splat(pi / 4), zero);
+		a = select(less(ax, y), V::splat(pi / 2) - a, a);
+		return select(less(x, zero), V::splat(pi) - a, a);
+	}
+
+	//the faces [f, f + V::size) of inds (which points at their first corner), written at out + f
+	template <class V>
+	inline void computeBlock(const typename V::Scalar * x, const typename V::Scalar * y, const typename V::Scalar * z,
+		const int * inds, const SimdGeometry::Triangles<typename V::Scalar> & out, size_t f)
+	{
+		typedef typename V::Scalar T;
+		typename V::Index i0 = V::indices(inds), i1 = V::indices(inds + 1), i2 = V::indices(inds + 2);
+		V x0 = V::gather(x, i0), y0 = V::gather(y, i0), z0 = V::gather(z, i0);
+		V x1 = V::gather(x, i1), y1 = V::gather(y, i1), z1 = V::gather(z, i1);
+		V x2 = V::gather(x, i2), y2 = V::gather(y, i2), z2 = V::gather(z, i2);
+		V e0x = x1 - x0, e0y = y1 - y0, e0z = z1 - z0;		//edge j from corner j to corner j + 1
+		V e1x = x2 - x1, e1y = y2 - y1, e1z = z2 - z1;
+		V e2x = x0 - x2, e2y = y0 - y2, e2z = z0 - z2;
+		V nx = e2y * e0z - e2z * e0y, ny = e2z * e0x - e2x * e0z, nz = e2x * e0y - e2y * e0x;
+		V length = sqrtOf(nx * nx + ny * ny + nz * nz);		//twice the area
+
+		const V zero = V::splat(T(0));
+		if (out.area)
+			(length * V::splat(T(0.5))).store(out.area + f);
+		if (out.normal[0]) {
+			V positive = less(zero, length);
+			V inverse = V::splat(T(1)) / select(positive, length, V::splat(T(1)));
+			select(positive, nx * inverse, zero).store(out.normal[0] + f);
+			select(positive, ny * inverse, zero).store(out.normal[1] + f);
+			select(positive, nz * inverse, zero).store(out.normal[2] + f);
+		}
+		if (out.angle[0]) {
+			angle(length, -(e2x * e0x + e2y * e0y + e2z * e0z)).store(out.angle[0] + f);
+			angle(length, -(e0x * e1x + e0y * e1y + e0z * e1z)).store(out.angle[1] + f);
+			angle(length, -(e1x * e2x + e1y * e2y + e1z * e2z)).store(out.angle[2] + f);
+		}
+		if (out.length[0]) {
+			sqrtOf(e0x * e0x + e0y * e0y + e0z * e0z).store(out.length[0] + f);
+			sqrtOf(e1x * e1x + e1y * e1y + e1z * e1z).store(out.length[1] + f);
+			sqrtOf(e2x * e2x + e2y * e2y + e2z * e2z).store(out.length[2] + f);
+		}
+	}
+}
+
+namespace SimdGeometry
+{
+	template <class T>
+	void computeTriangles(const T * x, const T * y, const T * z, const int * faceInds, size_t first, size_t last,
+		const Triangles<T> & out)
+	{
+		typedef typename Vector<T>::Type V;
+		const size_t n = V::size;
+		size_t f = first;
+		for (; f + n <= last; f += n)
+			computeBlock<V>(x, y, z, faceInds + 3 * f, out, f);
+		if (f == last)
+			return;
+
+		//the last faces, padded with copies of the last one, through a block of local outputs
+		int inds[3 * n];
+		T buffer[10][n];
+		Triangles<T> local;
+		local.area = out.area ? buffer[0] : 0;
+		for (int k = 0; k < 3; ++k) {
+			local.normal[k] = out.normal[0] ? buffer[1 + k] : 0;
+			local.angle[k] = out.angle[0] ? buffer[4 + k] : 0;
+			local.length[k] = out.length[0] ? buffer[7 + k] : 0;
+		}
+		for (size_t i = 0; i < n; ++i)
+			for (int j = 0; j < 3; ++j)
+				inds[3 * i + j] = faceInds[3 * std::min(f + i, last - 1) + j];
+		computeBlock<V>(x, y, z, inds, local, 0);
+		for (size_t i = 0; f + i < last; ++i) {
+			if (out.area) out.area[f + i] = buffer[0][i];
+			for (int k = 0; k < 3; ++k) {
+				if (out.normal[0]) out.normal[k][f + i] = buffer[1 + k][i];
+				if (out.angle[0]) out.angle[k][f + i] = buffer[4 + k][i];
+				if (out.length[0]) out.length[k][f + i] = buffer[7 + k][i];
+			}
+		}
+	}
+
+	template <class T>
+	int blockSize() { return Vector<T>::Type::size; }
+
+	const char * instructionSet() { return vectorName; }
+
+	template void computeTriangles<float>(const float *, const float *, const float *, const int *, size_t, size_t,
+		const Triangles<float> &);
+	template void computeTriangles<double>(const double *, const double *, const double *, const int *, size_t, size_t,
+		const Triangles<double> &);
+	template int blockSize<float>();
+	template int blockSize<double>();
+}
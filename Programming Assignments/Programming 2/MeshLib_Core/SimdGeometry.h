@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+// Per-triangle geometry computed several triangles at a time with SIMD instructions: unit normals, areas,
+// interior angles and edge lengths, from positions stored as structure of arrays (x[], y[], z[]).
+// Every block of triangles gathers the coordinates of its corners into vector registers and works on
+// whole registers from there: 4 triangles at a time in double precision, 8 in float. Built with AVX2
+// (e.g. -mavx2, or -march=native on a recent x86), the kernels use AVX2 registers and gathers; otherwise
+// they run on plain arrays of the same widths, which the compiler is free to vectorize for its target.
+// The angles come from a polynomial arc tangent of twice the area and the dot product at the corner,
+// accurate to about 1e-15 in double. In float the rounding of the coordinates and of their differences
+// dominates: the angles, like the other outputs, are within about 1e-4 of the double ones (see Ex10).
+//
+//		SimdGeometry::Triangles<float> out;
+//		out.area = areas.data();
+//		SimdGeometry::computeTriangles(x, y, z, faceInds, 0, numFaces, out);
+namespace SimdGeometry
+{
+	//the outputs, one entry per face in arrays indexed by face; a NULL array is not computed, and the three
+	//arrays of normal, angle and length are computed together, or not at all when the first is NULL
+	template <class T>
+	struct Triangles
+	{
+		T *	normal[3];		//unit normal, by axis; 0 for a degenerate triangle
+		T *	area;
+		T *	angle[3];		//interior angle at corner j, the vertex faceInds[3 * f + j]
+		T *	length[3];		//length of edge j, from corner j to corner j + 1
+
+		Triangles() : area(0)
+		{
+			for (int k = 0; k < 3; ++k) normal[k] = angle[k] = length[k] = 0;
+		}
+	};
+
+	//the faces [first, last) of the triangles faceInds (3 vertex indices each) over the positions x, y, z;
+	//for float and double
+	template <class T>
+	void computeTriangles(const T * x, const T * y, const T * z, const int * faceInds, size_t first, size_t last,
+		const Triangles<T> & out);
+
+	//triangles per block for T
+	template <class T>
+	int blockSize();
+
+	//"AVX2" or "portable"
+	const char * instructionSet();
+}
@@ -0,0 +1,871 @@
+#include "StreamingMesh.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "PLYFormat.h"
+#include "Point.h"
+#include "TextFormat.h"
+#include "TextParse.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdint.h>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const int		gridBits = 7;								//the faces are counted on a grid of 128^3 cells
+	const int		gridSize = 1 << gridBits;
+	const size_t	releaseBytes = (size_t)64 << 20;			//input read between two releases of its pages
+	const size_t	faceBufferInts = 4 << 14;					//buffered face records per cluster
+
+	bool makeDirectory(const std::string & path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+		struct _stat st;
+		return _stat(path.c_str(), &st) == 0 && (st.st_mode & _S_IFDIR);
+#else
+		mkdir(path.c_str(), 0777);
+		struct stat st;
+		return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+	}
+
+	//the bits of x (gridBits of them) spread to every third bit
+	uint32_t spreadBits(uint32_t x)
+	{
+		uint32_t r = 0;
+		for (int b = 0; b < gridBits; ++b)
+			r |= ((x >> b) & 1u) << (3 * b);
+		return r;
+	}
+
+	//cubic cells over [boxMin, boxMax], numbered along a Morton curve so that cells with close
+	//numbers are close in space. The cells are cubes so that thin parts of the box are not cut into
+	//slices, which would interleave the clusters.
+	struct Grid
+	{
+		double	origin[3];
+		double	scale;
+
+		Grid(const double boxMin[3], const double boxMax[3])
+		{
+			double extent = 0;
+			for (int k = 0; k < 3; ++k) {
+				origin[k] = boxMin[k];
+				extent = std::max(extent, boxMax[k] - boxMin[k]);
+			}
+			scale = extent > 0 ? gridSize / extent : 0;
+		}
+
+		uint32_t cell(const double p[3]) const
+		{
+			uint32_t code = 0;
+			for (int k = 0; k < 3; ++k) {
+				double x = (p[k] - origin[k]) * scale;
+				int i = x > 0 ? (int)x : 0;
+				code |= spreadBits((uint32_t)std::min(i, gridSize - 1)) << k;
+			}
+			return code;
+		}
+	};
+
+	// One front to back pass over the vertices or the faces of an OBJ or PLY file.
+	// The file is mapped, and the pages read are released as the pass goes, so that
+	// only a few megabytes of it are in memory at any time.
+	class InputStream
+	{
+	public:
+		bool open(const char path[], std::string & error)
+		{
+			if (!m_file.open(path)) {
+				error = "cannot open the file";
+				return false;
+			}
+			std::string name(path);
+			std::string ext = name.size() > 4 ? name.substr(name.size() - 4) : "";
+			for (size_t i = 0; i < ext.size(); ++i) ext[i] = (char)tolower(ext[i]);
+			m_ply = ext == ".ply";
+			if (!m_ply && ext != ".obj") {
+				error = "only .obj and .ply files can be streamed";
+				return false;
+			}
+			return !m_ply || m_header.parse(m_file.data(), m_file.end(), error);
+		}
+
+		size_t size() const { return m_file.size(); }
+
+		//vertex(const double xyz[3]) for every vertex, in file order
+		template <class V>
+		bool vertices(V vertex, std::string & error)
+		{
+			return m_ply ? scanPLY(vertex, [](const int *) {}, true, error) : scanOBJ(vertex, [](const int *) {});
+		}
+
+		//face(const int v[3]) for every triangle, in file order, with vertex indices from 0 (not checked)
+		template <class F>
+		bool faces(F face, std::string & error)
+		{
+			return m_ply ? scanPLY([](const double *) {}, face, false, error) : scanOBJ([](const double *) {}, face);
+		}
+
+	private:
+		//drop the pages before p every releaseBytes
+		void progress(const char * p)
+		{
+			if ((size_t)(p - m_released) >= releaseBytes) {
+				m_file.release(m_released, p);
+				m_released = p;
+			}
+		}
+
+		//the lines as parsed by Mesh::parseOBJFile()
+		template <class V, class F>
+		bool scanOBJ(V vertex, F face)
+		{
+			const char * p = m_file.data(), * end = m_file.end();
+			m_released = p;
+			int numVertices = 0;
+			while (p < end) {
+				p = TextParse::skipBlanks(p, end);
+				if (p + 1 < end && TextParse::isBlank(p[1])) {
+					if (p[0] == 'v') {
+						p += 2;
+						double xyz[3];
+						for (int i = 0; i < 3; i++) {
+							p = TextParse::skipBlanks(p, end);
+							p = TextParse::parseDouble(p, end, xyz[i]);
+							p = TextParse::skipToken(p, end);
+						}
+						vertex(xyz);
+						++numVertices;
+					}
+					else if (p[0] == 'f') {
+						p += 2;
+						int v[3], n = 0;
+						for (; n < 3; n++) {
+							p = TextParse::skipBlanks(p, end);
+							p = TextParse::parseInt(p, end, v[n]);
+							p = TextParse::skipToken(p, end);
+							if (v[n] == 0) break;		//fewer than 3 vertices: the line is skipped
+							v[n] = v[n] < 0 ? numVertices + v[n] : v[n] - 1;
+						}
+						if (n == 3)
+							face(v);
+					}
+				}
+				p = TextParse::nextLine(p, end);
+				progress(p);
+			}
+			m_file.release(m_released, end);
+			return true;
+		}
+
+		//the elements as read by Mesh::readPLYFile(): polygons are split into fans of triangles
+		template <class V, class F>
+		bool scanPLY(V vertex, F face, bool wantVertices, std::string & error)
+		{
+			PLYFormat::ValueReader reader(m_file.data() + m_header.size, m_file.end(), m_header.encoding);
+			m_released = m_file.data();
+			std::vector<int> polygon;
+			for (size_t e = 0; e < m_header.elements.size() && reader.ok(); ++e) {
+				const PLYFormat::Element & element = m_header.elements[e];
+				const int numProps = (int)element.properties.size();
+				const size_t recordSize = element.recordSize();
+				const bool isVertex = element.name == "vertex", isFace = element.name == "face";
+
+				//records that are not needed are jumped over when they have a fixed size
+				if (reader.binary() && recordSize > 0 && !isFace && (!isVertex || !wantVertices)) {
+					if ((unsigned long long)(reader.end() - reader.position()) / recordSize < (unsigned long long)element.count) {
+						error = "the file is truncated";
+						return false;
+					}
+					reader.seek(reader.position() + recordSize * element.count);
+					continue;
+				}
+				int axis[3] = { -1, -1, -1 }, list = -1;
+				if (isVertex) {
+					static const char * const axes[3] = { "x", "y", "z" };
+					for (int k = 0; k < 3; ++k)
+						if ((axis[k] = element.findProperty(axes[k])) < 0) {
+							error = std::string("the vertices have no ") + axes[k] + " coordinate";
+							return false;
+						}
+				}
+				if (isFace) {
+					list = element.findProperty("vertex_indices");
+					if (list < 0) list = element.findProperty("vertex_index");
+					if (list < 0 || element.properties[list].countType == PLYFormat::NoType) {
+						error = "the faces have no vertex_indices list";
+						return false;
+					}
+				}
+				for (long long r = 0; r < element.count && reader.ok(); ++r) {
+					double xyz[3] = { 0, 0, 0 };
+					for (int i = 0; i < numProps; ++i) {
+						const PLYFormat::Property & prop = element.properties[i];
+						if (i == list) {
+							int n = (int)reader.read(prop.countType);
+							polygon.resize(n > 0 ? n : 0);
+							for (int j = 0; j < n && reader.ok(); ++j)
+								polygon[j] = (int)reader.read(prop.type);
+						}
+						else if (isVertex && prop.countType == PLYFormat::NoType && (i == axis[0] || i == axis[1] || i == axis[2]))
+							xyz[i == axis[0] ? 0 : i == axis[1] ? 1 : 2] = reader.read(prop.type);
+						else
+							reader.skip(prop);
+					}
+					if (isVertex && wantVertices)
+						vertex(xyz);
+					if (isFace)
+						for (size_t j = 2; j < polygon.size(); ++j) {
+							int v[3] = { polygon[0], polygon[j - 1], polygon[j] };
+							face(v);
+						}
+					progress(reader.position());
+				}
+			}
+			m_file.release(m_released, m_file.end());
+			if (!reader.ok()) {
+				error = "the file is truncated";
+				return false;
+			}
+			return true;
+		}
+
+		MappedFile			m_file;
+		bool				m_ply;
+		PLYFormat::Header	m_header;
+		const char *		m_released;		//the pages before it are released
+	};
+
+	// Appends fixed-size records to files, through a buffer per file.
+	class RecordWriter
+	{
+	public:
+		RecordWriter(const std::vector<std::string> & paths) : m_paths(paths), m_buffers(paths.size()), m_ok(true)
+		{
+			for (size_t i = 0; i < paths.size(); ++i) {		//start with empty files
+				FILE * fp = fopen(paths[i].c_str(), "wb");
+				if (!fp) m_ok = false;
+				else fclose(fp);
+			}
+		}
+
+		void append(int i, const int * values, int n)
+		{
+			std::vector<int> & buffer = m_buffers[i];
+			buffer.insert(buffer.end(), values, values + n);
+			if (buffer.size() >= faceBufferInts)
+				flush(i);
+		}
+
+		//write what is left in the buffers; false if any write failed
+		bool close()
+		{
+			for (size_t i = 0; i < m_buffers.size(); ++i)
+				flush((int)i);
+			return m_ok;
+		}
+
+	private:
+		//files are opened only while their buffer is written, so that any number of them can be used
+		void flush(int i)
+		{
+			std::vector<int> & buffer = m_buffers[i];
+			if (buffer.empty()) return;
+			FILE * fp = fopen(m_paths[i].c_str(), "ab");
+			if (!fp || fwrite(&buffer[0], sizeof(int), buffer.size(), fp) != buffer.size())
+				m_ok = false;
+			if (fp) fclose(fp);
+			buffer.clear();
+		}
+
+		std::vector<std::string>		m_paths;
+		std::vector<std::vector<int> >	m_buffers;
+		bool							m_ok;
+	};
+
+	//the face records of the temporary files: id and 3 vertex ids
+	const int recordInts = 4;
+
+	inline int numRecords(const MappedFile & file) { return (int)(file.size() / (recordInts * sizeof(int))); }
+	inline const int * records(const MappedFile & file) { return (const int *)file.data(); }
+
+	bool boxesOverlap(const double minA[3], const double maxA[3], const double minB[3], const double maxB[3])
+	{
+		for (int k = 0; k < 3; ++k)
+			if (maxA[k] < minB[k] || maxB[k] < minA[k]) return false;
+		return true;
+	}
+
+	double secondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// A column of the output PLY files: one property read from an attribute array
+	struct Column
+	{
+		std::string			name;
+		PLYFormat::Type		type;
+		const char *		data;		//value of element 0
+		size_t				stride;		//bytes from one element to the next
+	};
+
+	//the columns of the attributes that can be written: double, float, int and the components of Point
+	void attributeColumns(AttributeSet & set, std::vector<Column> & columns)
+	{
+		for (int i = 0; i < set.numAttributes(); ++i) {
+			AttributeArrayBase & a = set.attribute(i);
+			if (a.size() == 0) continue;
+			Column column = { a.name(), PLYFormat::NoType, NULL, 0 };
+			if (AttributeArray<double> * d = dynamic_cast<AttributeArray<double> *>(&a)) {
+				column.type = PLYFormat::Float64; column.data = (const char *)d->data(); column.stride = sizeof(double);
+			}
+			else if (AttributeArray<float> * f = dynamic_cast<AttributeArray<float> *>(&a)) {
+				column.type = PLYFormat::Float32; column.data = (const char *)f->data(); column.stride = sizeof(float);
+			}
+			else if (AttributeArray<int> * n = dynamic_cast<AttributeArray<int> *>(&a)) {
+				column.type = PLYFormat::Int32; column.data = (const char *)n->data(); column.stride = sizeof(int);
+			}
+			else if (AttributeArray<Point> * p = dynamic_cast<AttributeArray<Point> *>(&a)) {
+				static const char * const suffixes[3] = { "_x", "_y", "_z" };
+				static const char * const normal[3] = { "nx", "ny", "nz" };	//the usual names of normals
+				for (int k = 0; k < 3; ++k) {
+					column.name = a.name() == "normal" ? normal[k] : a.name() + suffixes[k];
+					column.type = PLYFormat::Float64;
+					column.data = (const char *)p->data()->v + k * sizeof(double);
+					column.stride = sizeof(Point);
+					columns.push_back(column);
+				}
+				continue;
+			}
+			else continue;
+			columns.push_back(column);
+		}
+	}
+
+	inline char * writeColumns(char * p, const std::vector<Column> & columns, int i)
+	{
+		for (size_t c = 0; c < columns.size(); ++c) {
+			int n = PLYFormat::typeSize(columns[c].type);
+			memcpy(p, columns[c].data + i * columns[c].stride, n);
+			p += n;
+		}
+		return p;
+	}
+
+	//the 3 angles of face f
+	void cornerAngles(const MeshCluster & cluster, int f, double angles[3])
+	{
+		const int * v = &cluster.faceInds[3 * f];
+		for (int i = 0; i < 3; ++i) {
+			const double * p = &cluster.coords[3 * v[i]];
+			const double * a = &cluster.coords[3 * v[(i + 1) % 3]];
+			const double * b = &cluster.coords[3 * v[(i + 2) % 3]];
+			double u[3] = { a[0] - p[0], a[1] - p[1], a[2] - p[2] };
+			double w[3] = { b[0] - p[0], b[1] - p[1], b[2] - p[2] };
+			double lengths = sqrt((u[0] * u[0] + u[1] * u[1] + u[2] * u[2]) * (w[0] * w[0] + w[1] * w[1] + w[2] * w[2]));
+			double c = lengths > 0 ? (u[0] * w[0] + u[1] * w[1] + u[2] * w[2]) / lengths : 1;
+			angles[i] = acos(std::max(-1.0, std::min(1.0, c)));
+		}
+	}
+
+	//the cross product of the edges of face f, twice its area in length
+	void crossProduct(const MeshCluster & cluster, int f, double n[3])
+	{
+		const int * v = &cluster.faceInds[3 * f];
+		const double * p0 = &cluster.coords[3 * v[0]], * p1 = &cluster.coords[3 * v[1]], * p2 = &cluster.coords[3 * v[2]];
+		double u[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		double w[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		n[0] = u[1] * w[2] - u[2] * w[1];
+		n[1] = u[2] * w[0] - u[0] * w[2];
+		n[2] = u[0] * w[1] - u[1] * w[0];
+	}
+}
+
+StreamingMesh::StreamingMesh() : m_numVertices(0), m_numFaces(0), m_haveTempFiles(false) {;}
+
+StreamingMesh::~StreamingMesh() { removeTempFiles(); }
+
+std::string StreamingMesh::tempFacesPath(int c) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "/faces_%05d.tmp", c);
+	return m_dir + name;
+}
+
+void StreamingMesh::removeTempFiles()
+{
+	if (!m_haveTempFiles) return;
+	remove((m_dir + "/vertices.tmp").c_str());
+	for (int c = 0; c < numClusters(); ++c)
+		remove(tempFacesPath(c).c_str());
+	m_haveTempFiles = false;
+}
+
+long long StreamingMesh::largestCluster() const
+{
+	long long largest = 0;
+	for (size_t c = 0; c < m_clusters.size(); ++c)
+		largest = std::max(largest, m_clusters[c].numFaces + m_clusters[c].numHaloFaces);
+	return largest;
+}
+
+bool StreamingMesh::partition(const char inputFile[], const char outputDir[], int clusterFaces)
+{
+	removeTempFiles();
+	m_clusters.clear();
+	m_inputFile = inputFile;
+	m_dir = outputDir;
+	m_numVertices = m_numFaces = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::cout << "Partitioning mesh " << inputFile << " ...\n";
+
+	std::string error;
+	InputStream input;
+	if (!input.open(inputFile, error)) {
+		std::cerr << "Error: " << inputFile << ": " << error << "!" << std::endl;
+		return false;
+	}
+	if (!makeDirectory(m_dir)) {
+		std::cerr << "Cannot create directory " << m_dir << "!" << std::endl;
+		return false;
+	}
+	m_haveTempFiles = true;
+
+	//pass 1: the vertices go to a temporary file, where they are mapped for the next passes
+	const std::string verticesPath = m_dir + "/vertices.tmp";
+	FILE * fp = fopen(verticesPath.c_str(), "wb");
+	if (!fp) {
+		std::cerr << "Cannot open file " << verticesPath << " to write!" << std::endl;
+		return false;
+	}
+	double boxMin[3], boxMax[3];
+	for (int k = 0; k < 3; ++k) {
+		boxMin[k] = std::numeric_limits<double>::max();
+		boxMax[k] = -std::numeric_limits<double>::max();
+	}
+	std::vector<double> buffer;
+	buffer.reserve(3 << 16);
+	bool written = true;
+	long long numVertices = 0;
+	bool ok = input.vertices([&](const double * xyz) {
+		for (int k = 0; k < 3; ++k) {
+			boxMin[k] = std::min(boxMin[k], xyz[k]);
+			boxMax[k] = std::max(boxMax[k], xyz[k]);
+		}
+		buffer.insert(buffer.end(), xyz, xyz + 3);
+		if (buffer.size() == buffer.capacity()) {
+			written = written && fwrite(&buffer[0], sizeof(double), buffer.size(), fp) == buffer.size();
+			buffer.clear();
+		}
+		++numVertices;
+	}, error);
+	if (!buffer.empty())
+		written = written && fwrite(&buffer[0], sizeof(double), buffer.size(), fp) == buffer.size();
+	written = fclose(fp) == 0 && written;
+	if (!ok || !written || numVertices > std::numeric_limits<int>::max()) {
+		if (ok && !written) error = "cannot write the temporary files";
+		else if (ok) error = "too many vertices";
+		std::cerr << "Error: " << inputFile << ": " << error << "!" << std::endl;
+		return false;
+	}
+	m_numVertices = (int)numVertices;
+
+	MappedFile vertexFile;
+	if (m_numVertices > 0 && !vertexFile.open(verticesPath.c_str())) {
+		std::cerr << "Can't open file " << verticesPath << "!" << std::endl;
+		return false;
+	}
+	const double * positions = (const double *)vertexFile.data();
+	const Grid grid(boxMin, boxMax);
+	const int nv = m_numVertices;
+	auto cellOf = [&](const int * v) {
+		double centroid[3];
+		for (int k = 0; k < 3; ++k)
+			centroid[k] = (positions[3 * v[0] + k] + positions[3 * v[1] + k] + positions[3 * v[2] + k]) / 3;
+		return grid.cell(centroid);
+	};
+
+	//pass 2: count the faces of each grid cell
+	std::vector<long long> cellFaces((size_t)1 << (3 * gridBits), 0);
+	long long numFaces = 0, badFace = -1;
+	ok = input.faces([&](const int * v) {
+		if (badFace < 0 && (v[0] < 0 || v[0] >= nv || v[1] < 0 || v[1] >= nv || v[2] < 0 || v[2] >= nv))
+			badFace = numFaces;
+		if (badFace < 0)
+			++cellFaces[cellOf(v)];
+		++numFaces;
+	}, error);
+	if (ok && badFace >= 0) {
+		ok = false;
+		error = "face " + std::to_string(badFace) + " uses a vertex that does not exist";
+	}
+	if (ok && numFaces > std::numeric_limits<int>::max()) {
+		ok = false;
+		error = "too many faces";
+	}
+	if (!ok) {
+		std::cerr << "Error: " << inputFile << ": " << error << "!" << std::endl;
+		return false;
+	}
+	m_numFaces = (int)numFaces;
+
+	//consecutive cells along the Morton curve make a cluster, until it has clusterFaces faces
+	std::vector<int> cellCluster(cellFaces.size());
+	int numClusters = 0;
+	long long faces = 0;
+	for (size_t cell = 0; cell < cellFaces.size(); ++cell) {
+		cellCluster[cell] = numClusters;
+		faces += cellFaces[cell];
+		if (faces >= std::max(clusterFaces, 1)) {
+			++numClusters;
+			faces = 0;
+		}
+	}
+	if (faces > 0) ++numClusters;
+	std::vector<long long>().swap(cellFaces);
+
+	ClusterInfo empty = { 0, 0, 0, { 0, 0, 0 }, { 0, 0, 0 } };
+	for (int k = 0; k < 3; ++k) {
+		empty.boxMin[k] = std::numeric_limits<double>::max();
+		empty.boxMax[k] = -std::numeric_limits<double>::max();
+	}
+	m_clusters.assign(numClusters, empty);
+
+	//pass 3: append the faces to the temporary file of their cluster
+	std::vector<std::string> paths(numClusters);
+	for (int c = 0; c < numClusters; ++c)
+		paths[c] = tempFacesPath(c);
+	RecordWriter writer(paths);
+	int id = 0;
+	ok = input.faces([&](const int * v) {
+		int c = cellCluster[cellOf(v)];
+		int record[recordInts] = { id++, v[0], v[1], v[2] };
+		writer.append(c, record, recordInts);
+		ClusterInfo & info = m_clusters[c];
+		++info.numFaces;
+		for (int i = 0; i < 3; ++i)
+			for (int k = 0; k < 3; ++k) {
+				info.boxMin[k] = std::min(info.boxMin[k], positions[3 * v[i] + k]);
+				info.boxMax[k] = std::max(info.boxMax[k], positions[3 * v[i] + k]);
+			}
+	}, error);
+	if (!writer.close() && ok) {
+		ok = false;
+		error = "cannot write the temporary files";
+	}
+	if (!ok) {
+		std::cerr << "Error: " << inputFile << ": " << error << "!" << std::endl;
+		return false;
+	}
+	printf("Done! (%d vertices, %d faces in %d clusters, %.3f s)\n", m_numVertices, m_numFaces, numClusters, secondsSince(start));
+	return true;
+}
+
+//the own faces of cluster c from its temporary file, and the halo faces from the files of the clusters
+//whose box overlaps its box: a face sharing a vertex with cluster c has that vertex in both boxes
+bool StreamingMesh::loadCluster(int c, const char * vertexData, MeshCluster & cluster)
+{
+	MappedFile file;
+	if (!file.open(tempFacesPath(c).c_str())) {
+		std::cerr << "Can't open file " << tempFacesPath(c) << "!" << std::endl;
+		return false;
+	}
+	const int numOwn = numRecords(file);
+	std::vector<int> faces(records(file), records(file) + numOwn * recordInts);
+	file.close();
+
+	//local vertices: those of the own faces first, in order of appearance
+	std::unordered_map<int, int> local;
+	local.reserve(numOwn);
+	std::vector<int> & vertexIds = cluster.vertexIds;
+	std::vector<int> ownInds(3 * numOwn);
+	vertexIds.clear();
+	for (int f = 0; f < numOwn; ++f)
+		for (int i = 0; i < 3; ++i) {
+			const int v = faces[recordInts * f + 1 + i];
+			std::pair<std::unordered_map<int, int>::iterator, bool> it = local.insert(std::make_pair(v, (int)vertexIds.size()));
+			if (it.second)
+				vertexIds.push_back(v);
+			ownInds[3 * f + i] = it.first->second;
+		}
+	const int numOwnVertices = (int)vertexIds.size();
+	cluster.vertexOwned.assign(numOwnVertices, 1);
+
+	//a bit per hash of the own vertices: most faces of the other clusters have none of them,
+	//and are rejected without looking up the map
+	int filterBits = 10;
+	while (filterBits < 30 && ((size_t)1 << filterBits) < (size_t)16 * numOwnVertices) ++filterBits;
+	std::vector<uint64_t> filter(((size_t)1 << filterBits) / 64, 0);
+	auto hash = [&](int v) { return (uint32_t)((uint32_t)v * 2654435761u) >> (32 - filterBits); };
+	for (int v = 0; v < numOwnVertices; ++v)
+		filter[hash(vertexIds[v]) >> 6] |= (uint64_t)1 << (hash(vertexIds[v]) & 63);
+
+	//the faces of each file are sorted by id: merging them keeps all the faces sorted by id, so that
+	//every cluster goes over the faces around a vertex in the same order
+	std::vector<int> order(numOwn);
+	for (int f = 0; f < numOwn; ++f) order[f] = f;
+	auto byId = [&](int a, int b) { return faces[recordInts * a] < faces[recordInts * b]; };
+
+	const ClusterInfo & info = m_clusters[c];
+	for (int d = 0; d < numClusters(); ++d) {
+		if (d == c || !boxesOverlap(info.boxMin, info.boxMax, m_clusters[d].boxMin, m_clusters[d].boxMax))
+			continue;
+		if (!file.open(tempFacesPath(d).c_str())) {
+			std::cerr << "Can't open file " << tempFacesPath(d) << "!" << std::endl;
+			return false;
+		}
+		const size_t merged = order.size();
+		const int * r = records(file);
+		for (int f = 0, n = numRecords(file); f < n; ++f, r += recordInts) {
+			bool halo = false;
+			for (int i = 1; i <= 3; ++i) {
+				const uint32_t h = hash(r[i]);
+				if (!(filter[h >> 6] >> (h & 63) & 1)) continue;
+				std::unordered_map<int, int>::const_iterator it = local.find(r[i]);
+				if (it == local.end()) continue;
+				halo = true;
+				if (d < c) cluster.vertexOwned[it->second] = 0;	//a cluster with a lower id uses it
+			}
+			if (halo) {
+				order.push_back((int)(faces.size() / recordInts));
+				faces.insert(faces.end(), r, r + recordInts);
+			}
+		}
+		file.close();
+		std::inplace_merge(order.begin(), order.begin() + merged, order.end(), byId);
+	}
+
+	const int numFaces = (int)order.size();
+	cluster.id = c;
+	cluster.faceIds.resize(numFaces);
+	cluster.faceOwn.resize(numFaces);
+	cluster.faceInds.resize(3 * numFaces);
+	for (int f = 0; f < numFaces; ++f) {
+		const int g = order[f];
+		const int * r = &faces[recordInts * g];
+		cluster.faceIds[f] = r[0];
+		cluster.faceOwn[f] = g < numOwn;
+		for (int i = 0; i < 3; ++i) {
+			if (g < numOwn) {
+				cluster.faceInds[3 * f + i] = ownInds[3 * g + i];
+				continue;
+			}
+			std::pair<std::unordered_map<int, int>::iterator, bool> it = local.insert(std::make_pair(r[1 + i], (int)vertexIds.size()));
+			if (it.second)
+				vertexIds.push_back(r[1 + i]);
+			cluster.faceInds[3 * f + i] = it.first->second;
+		}
+	}
+	const int nv = (int)vertexIds.size();
+	cluster.vertexOwned.resize(nv, 0);
+	cluster.coords.resize(3 * nv);
+	for (int v = 0; v < nv; ++v)
+		memcpy(&cluster.coords[3 * v], vertexData + 3 * sizeof(double) * vertexIds[v], 3 * sizeof(double));
+
+	cluster.vertexAttributes.removeAll();
+	cluster.faceAttributes.removeAll();
+	cluster.vertexAttributes.resize(nv);
+	cluster.faceAttributes.resize(numFaces);
+
+	m_clusters[c].numHaloFaces = numFaces - numOwn;
+	m_clusters[c].numVertices = numOwnVertices;
+	return true;
+}
+
+//cluster_NNNNN.ply: the own faces and their vertices, with their ids in the input file, whether the
+//cluster owns the vertex, and the attributes computed by the kernels
+bool StreamingMesh::writeCluster(MeshCluster & cluster) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "/cluster_%05d.ply", cluster.id);
+	const std::string path = m_dir + name;
+
+	std::vector<Column> vertexColumns, faceColumns;
+	Column x = { "x", PLYFormat::Float64, (const char *)cluster.coords.data(), 3 * sizeof(double) };
+	for (int k = 0; k < 3; ++k, x.data += sizeof(double)) {
+		x.name[0] = (char)('x' + k);
+		vertexColumns.push_back(x);
+	}
+	Column id = { "id", PLYFormat::Int32, (const char *)cluster.vertexIds.data(), sizeof(int) };
+	Column owned = { "owned", PLYFormat::UInt8, (const char *)cluster.vertexOwned.data(), sizeof(char) };
+	vertexColumns.push_back(id);
+	vertexColumns.push_back(owned);
+	attributeColumns(cluster.vertexAttributes, vertexColumns);
+	id.data = (const char *)cluster.faceIds.data();
+	faceColumns.push_back(id);
+	attributeColumns(cluster.faceAttributes, faceColumns);
+
+	int numFaces = 0;
+	for (int f = 0; f < cluster.numFaces(); ++f)
+		numFaces += cluster.faceOwn[f];
+	const int numVertices = m_clusters[cluster.id].numVertices;	//the own faces use the first local vertices
+
+	TextFormat::Buffer out;
+	std::string header = "ply\nformat ";
+	header += PLYFormat::hostIsLittleEndian() ? "binary_little_endian" : "binary_big_endian";
+	header += " 1.0\ncomment cluster " + std::to_string(cluster.id) + " of " + std::to_string(numClusters())
+		+ " of " + m_inputFile + "\nelement vertex " + std::to_string(numVertices) + "\n";
+	for (size_t c = 0; c < vertexColumns.size(); ++c)
+		header += std::string("property ") + PLYFormat::typeName(vertexColumns[c].type) + " " + vertexColumns[c].name + "\n";
+	header += "element face " + std::to_string(numFaces) + "\nproperty list uchar int vertex_indices\n";
+	for (size_t c = 0; c < faceColumns.size(); ++c)
+		header += std::string("property ") + PLYFormat::typeName(faceColumns[c].type) + " " + faceColumns[c].name + "\n";
+	header += "end_header\n";
+	out.append(header.data(), header.size());
+
+	size_t vertexBytes = 0, faceBytes = 1 + 3 * sizeof(int);
+	for (size_t c = 0; c < vertexColumns.size(); ++c) vertexBytes += PLYFormat::typeSize(vertexColumns[c].type);
+	for (size_t c = 0; c < faceColumns.size(); ++c) faceBytes += PLYFormat::typeSize(faceColumns[c].type);
+	char * p = out.reserve(vertexBytes * numVertices + faceBytes * numFaces);
+	for (int v = 0; v < numVertices; ++v)
+		p = writeColumns(p, vertexColumns, v);
+	for (int f = 0; f < cluster.numFaces(); ++f) {
+		if (!cluster.faceOwn[f]) continue;
+		*p++ = 3;
+		memcpy(p, &cluster.faceInds[3 * f], 3 * sizeof(int));
+		p = writeColumns(p + 3 * sizeof(int), faceColumns, f);
+	}
+	out.commit(p);
+
+	FILE * fp = fopen(path.c_str(), "wb");
+	if (!fp) {
+		std::cerr << "Cannot open file " << path << " to write!" << std::endl;
+		return false;
+	}
+	bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+	ok = fclose(fp) == 0 && ok;
+	if (!ok)
+		std::cerr << "Cannot write file " << path << "!" << std::endl;
+	return ok;
+}
+
+bool StreamingMesh::process(const std::vector<Kernel> & kernels, int numThreads)
+{
+	if (!m_haveTempFiles) {
+		std::cerr << "Error: the mesh has not been partitioned!" << std::endl;
+		return false;
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::cout << "Processing " << numClusters() << " clusters of " << m_inputFile << " ...\n";
+	MappedFile vertexFile;
+	const std::string verticesPath = m_dir + "/vertices.tmp";
+	if (m_numVertices > 0 && !vertexFile.open(verticesPath.c_str())) {
+		std::cerr << "Can't open file " << verticesPath << "!" << std::endl;
+		return false;
+	}
+
+	std::vector<char> done(numClusters(), 0);
+	Parallel::forChunks(numClusters(), numThreads, [&](int c) {
+		MeshCluster cluster;
+		if (!loadCluster(c, vertexFile.data(), cluster))
+			return;
+		for (size_t k = 0; k < kernels.size(); ++k)
+			kernels[k](cluster);
+		done[c] = writeCluster(cluster);
+	});
+	if (std::count(done.begin(), done.end(), 1) != numClusters())
+		return false;
+
+	//the index of the clusters
+	const std::string indexPath = m_dir + "/partition.txt";
+	FILE * fp = fopen(indexPath.c_str(), "w");
+	if (!fp) {
+		std::cerr << "Cannot open file " << indexPath << " to write!" << std::endl;
+		return false;
+	}
+	fprintf(fp, "# partitioned mesh: one binary PLY file per cluster, with the id of each vertex and face in the source\n");
+	fprintf(fp, "source %s\nvertices %d\nfaces %d\nclusters %d\n", m_inputFile.c_str(), m_numVertices, m_numFaces, numClusters());
+	fprintf(fp, "# file faces halo_faces vertices min_x min_y min_z max_x max_y max_z\n");
+	for (int c = 0; c < numClusters(); ++c) {
+		const ClusterInfo & info = m_clusters[c];
+		fprintf(fp, "cluster_%05d.ply %lld %lld %d %.17g %.17g %.17g %.17g %.17g %.17g\n", c, info.numFaces, info.numHaloFaces,
+			info.numVertices, info.boxMin[0], info.boxMin[1], info.boxMin[2], info.boxMax[0], info.boxMax[1], info.boxMax[2]);
+	}
+	if (fclose(fp) != 0) {
+		std::cerr << "Cannot write file " << indexPath << "!" << std::endl;
+		return false;
+	}
+	vertexFile.close();
+	removeTempFiles();
+	printf("Done! (largest cluster %lld faces with its halo, %.3f s)\n", largestCluster(), secondsSince(start));
+	return true;
+}
+
+void StreamingMesh::faceNormals(MeshCluster & cluster)
+{
+	AttributeArray<Point> & normals = cluster.faceAttributes.add<Point>("normal");
+	AttributeArray<double> & areas = cluster.faceAttributes.add<double>("area");
+	for (int f = 0; f < cluster.numFaces(); ++f) {
+		double n[3];
+		crossProduct(cluster, f, n);
+		double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		areas[f] = length / 2;
+		if (length > 0)
+			normals[f] = Point(n[0] / length, n[1] / length, n[2] / length);
+	}
+}
+
+void StreamingMesh::vertexNormals(MeshCluster & cluster)
+{
+	AttributeArray<Point> & normals = cluster.vertexAttributes.add<Point>("normal");
+	AttributeArray<double> & areas = cluster.vertexAttributes.add<double>("area");
+	normals.fill(Point());
+	areas.fill(0);
+	for (int f = 0; f < cluster.numFaces(); ++f) {
+		double n[3], angles[3];
+		crossProduct(cluster, f, n);
+		cornerAngles(cluster, f, angles);
+		double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		for (int i = 0; i < 3; ++i) {
+			int v = cluster.faceInds[3 * f + i];
+			areas[v] += length / 6;
+			if (length == 0) continue;
+			for (int k = 0; k < 3; ++k)
+				normals[v][k] += n[k] / length * angles[i];
+		}
+	}
+	for (int v = 0; v < cluster.numVertices(); ++v) {
+		double length = normals[v].norm();
+		if (length > 0) normals[v] /= length;
+	}
+}
+
+void StreamingMesh::gaussianCurvature(MeshCluster & cluster)
+{
+	//around an inner vertex of an oriented surface, every neighbor follows the vertex in one face and
+	//precedes it in another: the sum of hash(next) - hash(previous) over the corners is 0. Around a
+	//boundary vertex the ends of the fan are left over.
+	const int nf = cluster.numFaces();
+	std::vector<uint64_t> balance(cluster.numVertices(), 0);
+	auto hash = [](uint64_t v) { v = (v + 1) * 0x9E3779B97F4A7C15ull; return v ^ (v >> 29); };
+	for (int f = 0; f < nf; ++f)
+		for (int i = 0; i < 3; ++i) {
+			const int * v = &cluster.faceInds[3 * f];
+			balance[v[i]] += hash(v[(i + 1) % 3]) - hash(v[(i + 2) % 3]);
+		}
+
+	const double pi = 3.14159265358979323846;
+	AttributeArray<double> & curvature = cluster.vertexAttributes.add<double>("gaussianCurvature");
+	for (int v = 0; v < cluster.numVertices(); ++v)
+		curvature[v] = balance[v] ? pi : 2 * pi;
+	for (int f = 0; f < nf; ++f) {
+		double angles[3];
+		cornerAngles(cluster, f, angles);
+		for (int i = 0; i < 3; ++i)
+			curvature[cluster.faceInds[3 * f + i]] -= angles[i];
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "Attributes.h"
+
+// Out-of-core processing of triangle meshes too large to be loaded as a Mesh.
+// partition() reads an OBJ or PLY file front to back a few times, never holding more than a small,
+// fixed amount of it, and sorts its faces into spatially compact clusters of about clusterFaces faces,
+// kept in temporary files next to the output. process() then loads one cluster at a time together with
+// its halo (the faces of other clusters around its vertices), runs the kernels on it, and writes the
+// cluster as a binary PLY file; a text index (partition.txt) lists the clusters.
+// Memory is bounded by the size of a cluster and its halo times the number of threads, plus the
+// vertex positions, which are kept in a temporary file and mapped.
+//
+//		StreamingMesh stream;
+//		std::vector<StreamingMesh::Kernel> kernels;
+//		kernels.push_back(StreamingMesh::faceNormals);
+//		kernels.push_back(StreamingMesh::vertexNormals);
+//		if (stream.partition("huge.obj", "huge_parts") && stream.process(kernels))
+//			...
+
+//One cluster as seen by the kernels: its own faces and the halo faces, sorted by face id, with the
+//vertices they use. Every vertex of an own face has all its faces here, so per-vertex results of
+//such vertices are exact, and identical in every cluster sharing the vertex. Results on the other
+//vertices (used by halo faces only) are partial and are not written.
+struct MeshCluster
+{
+	int					id;
+	std::vector<double>	coords;			//xyz of each local vertex
+	std::vector<int>	vertexIds;		//id of each local vertex in the input file
+	std::vector<char>	vertexOwned;	//1 for the vertices of this cluster not used by a cluster with a lower id
+	std::vector<int>	faceInds;		//3 local vertex indices per face
+	std::vector<int>	faceIds;		//id of each face in the input file
+	std::vector<char>	faceOwn;		//1 for the faces of the cluster, 0 for the halo faces
+
+	//results of the kernels, sized to the local vertices and faces; the attributes of type
+	//double, float, int and Point are written to the output
+	AttributeSet		vertexAttributes;
+	AttributeSet		faceAttributes;
+
+	int numVertices() const	{ return (int)vertexIds.size(); }
+	int numFaces() const	{ return (int)faceIds.size(); }
+};
+
+class StreamingMesh
+{
+public:
+	typedef std::function<void(MeshCluster &)> Kernel;
+
+	StreamingMesh();
+	~StreamingMesh();		//removes the temporary files
+
+	//read inputFile (.obj or .ply, triangles) and sort its faces into clusters stored in outputDir,
+	//which is created if needed
+	bool partition(const char inputFile[], const char outputDir[], int clusterFaces = 1 << 20);
+	//run the kernels on every cluster in turn (numThreads clusters at a time) and write the
+	//partitioned mesh; the temporary files are removed when it is done
+	bool process(const std::vector<Kernel> & kernels, int numThreads = 1);
+
+	int			numVertices() const	{ return m_numVertices; }
+	int			numFaces() const	{ return m_numFaces; }
+	int			numClusters() const	{ return (int)m_clusters.size(); }
+	long long	largestCluster() const;		//faces of the largest cluster, halo included, once processed
+
+	//kernels on the face "normal" (Point) and "area" (double) attributes
+	static void faceNormals(MeshCluster & cluster);
+	//vertex "normal": the unit average of the normals of the faces around, weighted by their angle at
+	//the vertex, and vertex "area": a third of the area of the faces around
+	static void vertexNormals(MeshCluster & cluster);
+	//vertex "gaussianCurvature": the angle deficit, 2 pi (pi on the boundary) minus the angles around
+	static void gaussianCurvature(MeshCluster & cluster);
+
+private:
+	StreamingMesh(const StreamingMesh &);				//not copyable
+	StreamingMesh & operator=(const StreamingMesh &);
+
+	struct ClusterInfo
+	{
+		long long	numFaces;			//own faces
+		long long	numHaloFaces;		//known once processed
+		int			numVertices;		//vertices of the own faces, known once processed
+		double		boxMin[3];			//bounding box of the vertices of the own faces
+		double		boxMax[3];
+	};
+
+	std::string	tempFacesPath(int c) const;
+	bool		loadCluster(int c, const char * vertexData, MeshCluster & cluster);
+	bool		writeCluster(MeshCluster & cluster) const;
+	void		removeTempFiles();
+
+	std::string					m_inputFile;
+	std::string					m_dir;
+	int							m_numVertices;
+	int							m_numFaces;
+	std::vector<ClusterInfo>	m_clusters;
+	bool						m_haveTempFiles;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Locale-independent number formatting for the text mesh writers.
+// Every write function stores its characters at p and returns the position right after them;
+// the caller makes sure there is room (see Buffer::reserve and maxFixedChars).
+namespace TextFormat
+{
+	const int maxFixedChars = 330;		//longest output of writeFixed(): "%.9f" of -DBL_MAX
+
+	//digits of v, most significant first
+	inline char * writeUnsigned(char * p, unsigned long long v)
+	{
+		char digits[20];
+		int n = 0;
+		do {
+			digits[n++] = (char)('0' + v % 10);
+			v /= 10;
+		} while (v);
+		while (n) *p++ = digits[--n];
+		return p;
+	}
+
+	inline char * writeInt(char * p, int v)
+	{
+		if (v < 0) {
+			*p++ = '-';
+			return writeUnsigned(p, 0ull - (unsigned long long)(long long)v);
+		}
+		return writeUnsigned(p, (unsigned long long)v);
+	}
+
+	//x with precision (0 to 9) digits after the point, the exact same text as printf("%.*f", precision, x)
+	inline char * writeFixed(char * p, double x, int precision)
+	{
+		static const double scales[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+		double a = fabs(x);
+		if (a < 1e15) {					//also false for NaN
+			//the integer part is exact, and the scaled fraction is off by less than 1e-6 of a unit:
+			//round it ourselves unless it falls too close to a tie to decide
+			double ip = floor(a);
+			double scaled = (a - ip) * scales[precision];
+			double fp = floor(scaled);
+			double rest = scaled - fp;
+			if (fabs(rest - 0.5) > 1e-6) {
+				unsigned long long ipart = (unsigned long long)ip;
+				unsigned long long fpart = (unsigned long long)fp + (rest > 0.5 ? 1 : 0);
+				unsigned long long scale = (unsigned long long)scales[precision];
+				if (fpart >= scale) {
+					fpart -= scale;
+					++ipart;
+				}
+				if (std::signbit(x)) *p++ = '-';
+				p = writeUnsigned(p, ipart);
+				if (precision > 0) {
+					*p++ = '.';
+					for (int i = precision - 1; i >= 0; --i) {
+						p[i] = (char)('0' + fpart % 10);
+						fpart /= 10;
+					}
+					p += precision;
+				}
+				return p;
+			}
+		}
+		char text[maxFixedChars + 16];
+		int n = snprintf(text, sizeof(text), "%.*f", precision, x);
+		memcpy(p, text, n);
+		return p + n;
+	}
+
+	inline char * writeChar(char * p, char c) { *p = c; return p + 1; }
+
+	inline char * writeString(char * p, const char * s)
+	{
+		size_t n = strlen(s);
+		memcpy(p, s, n);
+		return p + n;
+	}
+
+	// Growable block of text: reserve room, write into it, then commit what was written.
+	class Buffer
+	{
+	public:
+		Buffer() : m_size(0) {;}
+
+		char * reserve(size_t n)
+		{
+			if (m_size + n > m_data.size())
+				m_data.resize(m_size + n > 2 * m_data.size() ? m_size + n : 2 * m_data.size());
+			return &m_data[0] + m_size;
+		}
+		void commit(char * end) { m_size = end - &m_data[0]; }
+		void append(const char * s, size_t n) { char * p = reserve(n); memcpy(p, s, n); commit(p + n); }
+
+		const char *	data() const	{ return m_data.empty() ? "" : &m_data[0]; }
+		size_t			size() const	{ return m_size; }
+		void			clear()			{ m_size = 0; }
+
+	private:
+		std::vector<char>	m_data;
+		size_t				m_size;
+	};
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+
+// Non-allocating tokenizers for the text mesh readers.
+// Every function works on a [p, end) range that does not need to be null-terminated,
+// and returns the position right after what it consumed.
+namespace TextParse
+{
+	inline bool isBlank(char c) { return c == ' ' || c == '\t'; }
+	inline bool isLineEnd(char c) { return c == '\n' || c == '\r'; }
+	inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+	inline const char * skipBlanks(const char * p, const char * end)
+	{
+		while (p < end && isBlank(*p)) ++p;
+		return p;
+	}
+
+	//skip the rest of the current token (up to a blank or the end of the line)
+	inline const char * skipToken(const char * p, const char * end)
+	{
+		while (p < end && !isBlank(*p) && !isLineEnd(*p)) ++p;
+		return p;
+	}
+
+	//return the beginning of the next line
+	inline const char * nextLine(const char * p, const char * end)
+	{
+		const char * nl = (const char *)memchr(p, '\n', end - p);
+		return nl ? nl + 1 : end;
+	}
+
+	//parse a decimal integer the way atoi does; returns 0 when there are no digits
+	inline const char * parseInt(const char * p, const char * end, int & value)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+		int v = 0;
+		while (p < end && isDigit(*p))
+			v = v * 10 + (*p++ - '0');
+		value = negative ? -v : v;
+		return p;
+	}
+
+	//parse a floating point number the way atof does.
+	//Short decimal numbers (the common case in mesh files) are converted exactly with one
+	//multiplication or division by an exact power of ten; anything else falls back to strtod.
+	inline const char * parseDouble(const char * p, const char * end, double & value)
+	{
+		static const double pow10[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		const char * start = p;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+
+		unsigned long long mantissa = 0;
+		int digits = 0, exponent = 0;
+		bool anyDigit = false;
+		while (p < end && *p == '0') { ++p; anyDigit = true; }	//leading zeros are not significant
+		while (p < end && isDigit(*p)) {
+			if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); ++digits; }
+			else ++exponent;
+			++p; anyDigit = true;
+		}
+		if (p < end && *p == '.') {
+			++p;
+			if (!digits)
+				while (p < end && *p == '0') { ++p; --exponent; anyDigit = true; }
+			while (p < end && isDigit(*p)) {
+				if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); ++digits; --exponent; }
+				++p; anyDigit = true;
+			}
+		}
+		if (anyDigit && p < end && (*p == 'e' || *p == 'E')) {
+			const char * q = p + 1;
+			bool negativeExp = false;
+			if (q < end && (*q == '-' || *q == '+'))
+				negativeExp = (*q++ == '-');
+			if (q < end && isDigit(*q)) {
+				int e = 0;
+				while (q < end && isDigit(*q)) {
+					if (e < 100000) e = e * 10 + (*q - '0');
+					++q;
+				}
+				exponent += negativeExp ? -e : e;
+				p = q;
+			}
+		}
+
+		if (anyDigit && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+			double v = (double)mantissa;
+			v = (exponent < 0) ? v / pow10[-exponent] : v * pow10[exponent];
+			value = negative ? -v : v;
+			return p;
+		}
+
+		//slow path: long mantissas, large exponents, inf/nan or malformed input
+		char buf[128];
+		const char * tokenEnd = skipToken(start, end);
+		size_t len = tokenEnd - start;
+		if (len >= sizeof(buf)) len = sizeof(buf) - 1;
+		memcpy(buf, start, len);
+		buf[len] = 0;
+		char * stop = buf;
+		value = strtod(buf, &stop);
+		return start + (stop - buf);
+	}
+}
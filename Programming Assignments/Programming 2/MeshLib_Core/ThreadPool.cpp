@@ -0,0 +1,138 @@
+#include "ThreadPool.h"
+
+namespace
+{
+	//set while a thread runs blocks, so that a loop started by a block runs serially
+	thread_local bool t_inLoop = false;
+
+	const size_t maxRoundBlocks = 0xffffffffu;
+
+	inline unsigned long long pack(size_t first, size_t last) { return (unsigned long long)first << 32 | last; }
+	inline size_t first(unsigned long long blocks) { return (size_t)(blocks >> 32); }
+	inline size_t last(unsigned long long blocks) { return (size_t)(blocks & 0xffffffffu); }
+
+	int resolveThreadCount(int numThreads)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		return numThreads > 0 ? numThreads : cores ? (int)cores : 1;
+	}
+}
+
+ThreadPool::ThreadPool(int numThreads)
+	: m_shares(resolveThreadCount(numThreads)), m_block(0), m_firstBlock(0), m_round(0), m_busy(0), m_stop(false)
+{
+	for (size_t t = 0; t < m_shares.size(); ++t)
+		m_shares[t].blocks.store(0);
+	for (int t = 1; t < (int)m_shares.size(); ++t)
+		m_workers.push_back(std::thread(&ThreadPool::workerLoop, this, t));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t t = 0; t < m_workers.size(); ++t)
+		m_workers[t].join();
+}
+
+ThreadPool & ThreadPool::global()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::run(size_t numBlocks, const std::function<void(size_t)> & block)
+{
+	if (numBlocks == 0)
+		return;
+	if (numBlocks == 1 || m_workers.empty() || t_inLoop) {
+		for (size_t b = 0; b < numBlocks; ++b) block(b);
+		return;
+	}
+
+	std::lock_guard<std::mutex> runLock(m_runMutex);
+	m_block = &block;
+	for (size_t firstBlock = 0; firstBlock < numBlocks; firstBlock += maxRoundBlocks) {
+		size_t n = std::min(numBlocks - firstBlock, maxRoundBlocks);
+		size_t numShares = m_shares.size();
+		for (size_t t = 0; t < numShares; ++t)
+			m_shares[t].blocks.store(pack(n * t / numShares, n * (t + 1) / numShares));
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_firstBlock = firstBlock;
+			m_busy = (int)m_workers.size();
+			++m_round;
+		}
+		m_wake.notify_all();
+		work(0);
+
+		//the workers finish their last block before they report, so every block is done once they all have
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idle.wait(lock, [this]() { return m_busy == 0; });
+	}
+	m_block = 0;
+}
+
+void ThreadPool::work(int thread)
+{
+	t_inLoop = true;
+	size_t b;
+	do {
+		while (take(thread, b))
+			(*m_block)(m_firstBlock + b);
+	} while (steal(thread));
+	t_inLoop = false;
+}
+
+//the first block left in the thread's own share
+bool ThreadPool::take(int thread, size_t & block)
+{
+	std::atomic<unsigned long long> & share = m_shares[thread].blocks;
+	unsigned long long blocks = share.load();
+	while (first(blocks) < last(blocks))
+		if (share.compare_exchange_weak(blocks, pack(first(blocks) + 1, last(blocks)))) {
+			block = first(blocks);
+			return true;
+		}
+	return false;
+}
+
+//move the back half of the blocks left to another thread (all of it if one block) into the thread's own
+//share, which is empty; fails when no thread has blocks left, the ones still running included
+bool ThreadPool::steal(int thread)
+{
+	int numShares = (int)m_shares.size();
+	for (int i = 1; i < numShares; ++i) {
+		std::atomic<unsigned long long> & victim = m_shares[(thread + i) % numShares].blocks;
+		unsigned long long blocks = victim.load();
+		while (first(blocks) < last(blocks)) {
+			size_t middle = first(blocks) + (last(blocks) - first(blocks)) / 2;
+			if (victim.compare_exchange_weak(blocks, pack(first(blocks), middle))) {
+				m_shares[thread].blocks.store(pack(middle, last(blocks)));
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(int thread)
+{
+	unsigned long long round = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_stop || m_round != round; });
+			if (m_stop)
+				return;
+			round = m_round;
+		}
+		work(thread);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_busy == 0)
+			m_idle.notify_one();
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for data-parallel loops, with work stealing.
+// A loop over [0, n) is cut into blocks of grain consecutive indices (the last one shorter). Every thread
+// starts on its own contiguous share of the blocks and takes them front first; a thread that runs out
+// steals the back half of the blocks another thread has left, so that uneven blocks (high-valence
+// vertices, a core busy with something else) do not leave the other threads idle at the end of the loop.
+// The grain size trades the cost of scheduling a block (an atomic operation and an indirect call) against
+// the balance of the loop: a few thousand elements per block suit the usual per-element mesh kernels.
+// The calling thread works on the loop too. A loop started from inside a loop runs serially on its thread.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(int numThreads = 0);	//numThreads threads in all, the caller included (0: all cores)
+	~ThreadPool();
+
+	int numThreads() const { return (int)m_workers.size() + 1; }
+
+	//run f(begin, end) on the blocks of grain indices covering [0, n)
+	template <class F>
+	void parallelFor(size_t n, size_t grain, F f);
+
+	//map(begin, end) on every block, in parallel, then the block results combined in block order:
+	//combine(...combine(combine(identity, map(0, grain)), map(grain, 2 * grain))..., map(.., n)).
+	//The result depends on the grain size but not on the number of threads or on which thread ran which
+	//block, so that floating-point sums come out the same on every machine.
+	template <class T, class Map, class Combine>
+	T parallelReduce(size_t n, size_t grain, T identity, Map map, Combine combine);
+
+	//a pool shared by the whole program, with one thread per core
+	static ThreadPool & global();
+
+private:
+	ThreadPool(const ThreadPool &);
+	ThreadPool & operator=(const ThreadPool &);
+
+	//the blocks a thread has left, [first, last) packed as first << 32 | last, on a cache line of its own
+	struct Share
+	{
+		std::atomic<unsigned long long>	blocks;
+		char							padding[64 - sizeof(std::atomic<unsigned long long>)];
+	};
+
+	void run(size_t numBlocks, const std::function<void(size_t)> & block);
+	void work(int thread);
+	bool take(int thread, size_t & block);
+	bool steal(int thread);
+	void workerLoop(int thread);
+
+	std::vector<std::thread>				m_workers;
+	std::vector<Share>						m_shares;
+	const std::function<void(size_t)> *		m_block;
+	size_t									m_firstBlock;		//of the current round (a loop runs in rounds of < 2^32 blocks)
+
+	std::mutex								m_runMutex;			//one loop at a time
+	std::mutex								m_mutex;
+	std::condition_variable					m_wake;				//a round starts, or the pool stops
+	std::condition_variable					m_idle;				//the last worker is done with the round
+	unsigned long long						m_round;
+	int										m_busy;
+	bool									m_stop;
+};
+
+template <class F>
+void ThreadPool::parallelFor(size_t n, size_t grain, F f)
+{
+	if (grain == 0) grain = 1;
+	size_t numBlocks = (n + grain - 1) / grain;
+	run(numBlocks, [&](size_t b) { f(b * grain, std::min(n, (b + 1) * grain)); });
+}
+
+template <class T, class Map, class Combine>
+T ThreadPool::parallelReduce(size_t n, size_t grain, T identity, Map map, Combine combine)
+{
+	if (grain == 0) grain = 1;
+	size_t numBlocks = (n + grain - 1) / grain;
+	std::vector<T> partial(numBlocks, identity);
+	run(numBlocks, [&](size_t b) { partial[b] = map(b * grain, std::min(n, (b + 1) * grain)); });
+	T result = identity;
+	for (size_t b = 0; b < numBlocks; ++b)
+		result = combine(result, partial[b]);
+	return result;
+}
@@ -4,6 +4,8 @@ Halfedge *  Vertex::most_ccw_in_halfedge()
 { 
 	if( !m_boundary )
 		return m_halfedge; //for interior vertex, randomly pick one, any halfedge can be most ccw
+	if( m_boundaryHe )
+		return m_halfedge; //the boundary halfedge coming in
 
 	Halfedge * he = m_halfedge;
 	Halfedge * nhe = he->ccw_rotate_about_target();
@@ -20,6 +22,8 @@ Halfedge *  Vertex::most_clw_in_halfedge()
 { 
 	if( !m_boundary )
 		return m_halfedge; 
+	if( m_boundaryHe )
+		return m_boundaryHe->prev();
 	Halfedge * he = m_halfedge;	
 	Halfedge * nhe = he->clw_rotate_about_target();
 	Halfedge * startHe= he;  
@@ -35,6 +39,8 @@ Halfedge *  Vertex::most_ccw_out_halfedge()
 { 
 	if( !m_boundary )
 		return m_halfedge->twin(); 
+	if( m_boundaryHe )
+		return m_halfedge->next();
 	Halfedge * he = m_halfedge->twin();
 	if (!he)
 		he = m_halfedge->next();
@@ -52,6 +58,8 @@ Halfedge *  Vertex::most_clw_out_halfedge()
 { 
 	if( !m_boundary )
 		return m_halfedge->twin();
+	if( m_boundaryHe )
+		return m_boundaryHe;
 	Halfedge * he = m_halfedge->twin();	
 	if (!he)
 		he = m_halfedge->next();
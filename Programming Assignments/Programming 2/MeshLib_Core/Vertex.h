@@ -6,16 +6,23 @@
 class Vertex
 {
 public:		
-	Vertex() : m_halfedge(0), m_boundary(false), m_propertyIndex(-1) { ; }
+	Vertex() : m_halfedge(0), m_boundaryHe(0), m_boundary(false), m_propertyIndex(-1) { ; }
 	~Vertex(){;}
 
-	Point & point() { return  m_point; }
+	MeshPoint & point() { return  m_point; }
 
 	//Pointers for Halfedge Data Structure
+	//A halfedge coming in. For a boundary vertex, Mesh::LabelBoundaryVertices() and every mesh built from arrays
+	//(the readers, reorder()) make it the boundary halfedge coming in, the most ccw one (of an open fan when the
+	//vertex has several); createFace() sets it to the last halfedge it creates into the vertex until then.
 	Halfedge * & he(){ return m_halfedge; }
 
 	//Computed by Halfedge Data Structure
 	bool & boundary() { return m_boundary; }	//whether this is a boundary vertex
+	//For a boundary vertex labeled by Mesh::LabelBoundaryVertices(), the boundary halfedge going out;
+	//he() is then the boundary halfedge coming in, so the rotations below need no walk around the fan.
+	//NULL when unknown (createFace() resets it), and the rotations walk as usual.
+	Halfedge * & boundaryHe() { return m_boundaryHe; }
 	//Rotation operations
     Halfedge *  most_ccw_in_halfedge();
 	Halfedge *  most_ccw_out_halfedge();
@@ -24,17 +31,16 @@ public:
 
 	//optional
 	int & index() {return m_propertyIndex; }	
-	std::string & PropertyStr() { return m_propertyStr;}
 
 
 protected:
 	//for Halfedge Data Structure
-	Point			m_point;
+	MeshPoint		m_point;
 	Halfedge	*	m_halfedge;
+	Halfedge	*	m_boundaryHe;
 	
 	//optional
 	bool			m_boundary; // whether this is a boundary vertex
-	std::string		m_propertyStr;
 	int				m_propertyIndex; // index to Property array
 };
 
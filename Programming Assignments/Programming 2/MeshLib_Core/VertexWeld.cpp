@@ -0,0 +1,192 @@
+#include "VertexWeld.h"
+#include "Parallel.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	//the epsilon-sized cell of a point; for epsilon = 0, the exact coordinates
+	struct CellKey
+	{
+		long long	c[3];
+
+		bool operator==(const CellKey & b) const { return c[0] == b.c[0] && c[1] == b.c[1] && c[2] == b.c[2]; }
+		bool operator<(const CellKey & b) const
+		{
+			return c[0] < b.c[0] || (c[0] == b.c[0] && (c[1] < b.c[1] || (c[1] == b.c[1] && c[2] < b.c[2])));
+		}
+	};
+
+	inline CellKey cellOf(const double * p, double epsilon)
+	{
+		CellKey key;
+		for (int k = 0; k < 3; ++k) {
+			if (epsilon > 0) {
+				double q = floor(p[k] / epsilon);
+				key.c[k] = (q > -9e18 && q < 9e18) ? (long long)q : 0;	//infinities and NaN share cell 0
+			}
+			else {
+				double x = p[k] + 0.0;	//folds -0 into +0
+				memcpy(&key.c[k], &x, sizeof(x));
+			}
+		}
+		return key;
+	}
+
+	inline size_t hashOf(const CellKey & key)
+	{
+		unsigned long long h = (unsigned long long)key.c[0] * 0x9E3779B97F4A7C15ull;
+		h = (h ^ (h >> 29) ^ (unsigned long long)key.c[1]) * 0xBF58476D1CE4E5B9ull;
+		h = (h ^ (h >> 32) ^ (unsigned long long)key.c[2]) * 0x94D049BB133111EBull;
+		return (size_t)(h ^ (h >> 31));
+	}
+
+	//a point sorted by its cell, then by its own id
+	struct CellPoint
+	{
+		CellKey	key;
+		int		point;
+	};
+
+	struct CellPointLess
+	{
+		bool operator()(const CellPoint & a, const CellPoint & b) const
+		{
+			return a.key < b.key || (a.key == b.key && a.point < b.point);
+		}
+	};
+}
+
+void VertexWeld::clear()
+{
+	vertices.clear();
+	remap.clear();
+}
+
+void VertexWeld::weldHashed(const double * coords, size_t numPoints, double epsilon)
+{
+	clear();
+	remap.resize(numPoints);
+
+	//open-addressing table from a cell to the first vertex in it, the other vertices of the cell
+	//being chained through nextInCell in increasing order
+	struct Slot
+	{
+		CellKey	key;
+		int		vertex;		//-1 for an empty slot
+	};
+	std::vector<Slot> slots;
+	std::vector<int> nextInCell;
+	size_t mask = 0;
+	auto grow = [&](size_t capacity) {
+		std::vector<Slot> old(capacity);
+		old.swap(slots);
+		mask = capacity - 1;
+		for (size_t s = 0; s < capacity; ++s) slots[s].vertex = -1;
+		for (size_t s = 0; s < old.size(); ++s) {
+			if (old[s].vertex < 0) continue;
+			size_t t = hashOf(old[s].key) & mask;
+			while (slots[t].vertex >= 0) t = (t + 1) & mask;
+			slots[t] = old[s];
+		}
+	};
+	auto findSlot = [&](const CellKey & key) {
+		size_t s = hashOf(key) & mask;
+		while (slots[s].vertex >= 0 && !(slots[s].key == key)) s = (s + 1) & mask;
+		return s;
+	};
+	grow(1024);
+	size_t numCells = 0;
+
+	//with cells of 2 epsilon, the points within epsilon of p lie in its cell or in the next cell
+	//on the side of the nearer border, on each axis: 8 cells to look into
+	const double cellSize = 2 * epsilon;
+	for (size_t i = 0; i < numPoints; ++i) {
+		const double * p = coords + 3 * i;
+		CellKey key = cellOf(p, cellSize);
+		int side[3] = { 0, 0, 0 };
+		if (epsilon > 0)
+			for (int k = 0; k < 3; ++k)
+				side[k] = p[k] / cellSize - floor(p[k] / cellSize) < 0.5 ? -1 : 1;
+
+		//the first vertex within epsilon
+		int found = -1;
+		for (int corner = 0; corner < (epsilon > 0 ? 8 : 1); ++corner) {
+			CellKey near = key;
+			for (int k = 0; k < 3; ++k)
+				if (corner & (1 << k)) near.c[k] += side[k];
+			for (int v = slots[findSlot(near)].vertex; v >= 0; v = nextInCell[v]) {
+				if (found >= 0 && v > found) break;		//chains are in increasing order
+				const double * q = &vertices[3 * v];
+				if (epsilon == 0	//same exact coordinates
+					|| (fabs(p[0] - q[0]) <= epsilon && fabs(p[1] - q[1]) <= epsilon && fabs(p[2] - q[2]) <= epsilon)) {
+					found = v;
+					break;
+				}
+			}
+		}
+		if (found < 0) {
+			found = numVertices();
+			vertices.insert(vertices.end(), p, p + 3);
+			nextInCell.push_back(-1);
+			size_t s = findSlot(key);
+			if (slots[s].vertex < 0) {
+				slots[s].key = key;
+				slots[s].vertex = found;
+				if (2 * ++numCells > slots.size())
+					grow(2 * slots.size());
+			}
+			else {
+				int v = slots[s].vertex;
+				while (nextInCell[v] >= 0) v = nextInCell[v];
+				nextInCell[v] = found;
+			}
+		}
+		remap[i] = found;
+	}
+}
+
+void VertexWeld::weldSorted(const double * coords, size_t numPoints, double epsilon, int numThreads)
+{
+	clear();
+	numThreads = Parallel::resolveThreadCount(numThreads);
+	remap.resize(numPoints);
+
+	//(1) sort the points by cell
+	std::vector<CellPoint> sorted(numPoints);
+	Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			sorted[i].key = cellOf(coords + 3 * i, epsilon);
+			sorted[i].point = (int)i;
+		}
+	});
+	if (numPoints)
+		Parallel::sort(&sorted[0], numPoints, numThreads, CellPointLess());
+
+	//(2) the first point of each run of equal cells represents it: remap[p] is the representative for now
+	std::vector<int> isFirst(numPoints, 0);
+	Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+		size_t s = begin;
+		while (s > 0 && sorted[s - 1].key == sorted[s].key) --s;
+		int first = s < numPoints ? sorted[s].point : -1;
+		for (size_t i = begin; i < end; ++i) {
+			if (i == 0 || !(sorted[i - 1].key == sorted[i].key)) {
+				first = sorted[i].point;
+				isFirst[first] = 1;
+			}
+			remap[sorted[i].point] = first;
+		}
+	});
+
+	//(3) number the representatives by position, then point every point to its vertex
+	std::vector<int> vertexOf(numPoints);
+	int numWelded = numPoints ? Parallel::exclusiveScan(&isFirst[0], &vertexOf[0], numPoints, numThreads) : 0;
+	vertices.resize(3 * (size_t)numWelded);
+	Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			if (isFirst[i])
+				memcpy(&vertices[3 * (size_t)vertexOf[i]], coords + 3 * i, 3 * sizeof(double));
+			remap[i] = vertexOf[remap[i]];
+		}
+	});
+}
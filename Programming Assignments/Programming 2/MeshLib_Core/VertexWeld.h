@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Welding of the corners of a triangle soup (as stored in STL files) into shared vertices.
+// Point p is welded to an earlier vertex when they are within epsilon of each other on every axis;
+// otherwise it starts a new vertex, placed at p. Vertices are numbered by first appearance.
+// epsilon = 0 welds exactly coincident points only (-0 and +0 coincide).
+class VertexWeld
+{
+public:
+	//weld with a spatial hash of cells of 2 epsilon, looking for an earlier vertex in the
+	//8 cells around each point; when several qualify, the first one is used
+	void weldHashed(const double * coords, size_t numPoints, double epsilon);
+	//weld the points falling in the same epsilon-sized cell, grouping them with a multithreaded
+	//sort + unique (numThreads = 0: all cores). This does not weld close points on both sides of
+	//a cell border, but for epsilon = 0 the result is exactly that of weldHashed().
+	void weldSorted(const double * coords, size_t numPoints, double epsilon, int numThreads = 0);
+	void clear();
+
+	int numVertices() const { return (int)vertices.size() / 3; }
+
+	std::vector<double>	vertices;	//xyz of each welded vertex
+	std::vector<int>	remap;		//welded vertex of each point
+};
@@ -14,8 +14,9 @@
 ///  gpp hw1.cpp -o hw1 -framework OpenGL -framework GLUT
 ///
 ///  # USAGE:
-///  ./hw1 [obj_file_1] [obj_file_2] ...
+///  ./hw1 [-cache] [obj_file_1] [obj_file_2] ...
 ///  Obj files are consecutively loaded, the camera will be centered on the last one.
+///  -cache loads the files after it through a binary cache next to them (obj_file.mlb), written when out of date.
 ///
 /// # 
 ///
@@ -36,6 +37,7 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
 #include "Vertex.h"
@@ -44,6 +46,16 @@
 #include "Edge.h"
 #include "Mesh.h"
 #include "Iterators.h"
+#include "MeshAttributes.h"
+#include "MeshParallel.h"
+
+
+/// Mesh geometry is double, or float when MeshLib is built with MESHLIB_FLOAT_GEOMETRY:
+/// pass it to OpenGL in its own precision
+inline void glVertexPoint(const PointT<double> &p) { glVertex3dv(p.v); }
+inline void glVertexPoint(const PointT<float> &p) { glVertex3fv(p.v); }
+inline void glNormalPoint(const PointT<double> &p) { glNormal3dv(p.v); }
+inline void glNormalPoint(const PointT<float> &p) { glNormal3fv(p.v); }
 
 
 
@@ -139,24 +151,25 @@ public:
     
 private:
     Mesh *mesh;
-    BoundingBox *bounds = nullptr;
     
-    std::vector<double> halfEdgeAngles;
-    std::vector<Point> faceNormals;
-    std::vector<Point> vertexNormals;
+    // derived data, computed on first use and again after the mesh changes, and shared with whatever else
+    // uses the mesh: the angles and normals come from one MeshGeometry pass, the curvature only while the heat
+    // map is shown. Vertices moved with Mesh::setPoint() are recomputed around on the next render only
+    MeshAttributes &attributes;
     std::vector<std::vector<Halfedge *>> boundaryEdgeLoops;
-    std::vector<double> vertexGaussianCurvature;
-    std::vector<short> vertexGaussianCurvatureLocalMinMax;
+    // curvature extrema, computed while the heat map is shown, for the geometry revision localMinMaxStamp
+    AttributeArray<short> &vertexGaussianCurvatureLocalMinMax;
+    mutable unsigned long long localMinMaxStamp = ~0ull;
+    // the other vertex of every edge of each vertex, over all its fans (a one-fan walk misses the others at
+    // non-manifold vertices), for the topology revision neighborsStamp
+    mutable std::vector<int> neighborStart, neighbors;
+    mutable unsigned long long neighborsStamp = ~0ull;
     
 public:
-    Object(Mesh *mesh): mesh(mesh), faceNormals(0) {
-        computeBoundingBox();
-        computeHalfEdgeAngles();
-        computeFaceNormals();
-        computeVertexNormals();
+    Object(Mesh *mesh): mesh(mesh),
+        attributes(mesh->derived()),
+        vertexGaussianCurvatureLocalMinMax(mesh->vertexAttributes().add<short>("vertexGaussianCurvatureLocalMinMax")) {
         computeBoundaryEdgeLoops();
-        computeGaussianCurvature();
-        computeGaussianCurvatureLocalMinMax();
         
         std::cout << "Found " << boundaryEdgeLoops.size() << " boundary edge loops." << std::endl;
     }
@@ -165,15 +178,23 @@ public:
         if (mesh != nullptr) {  delete mesh; }
     }
     
-    inline const BoundingBox& getBounds() {
-        if (bounds == nullptr) { computeBoundingBox(); }
-        return *bounds;
+    inline BoundingBox getBounds() const {
+        Point min, max;
+        attributes.boundingBox(min, max);
+        return BoundingBox(min, max);
     }
     
     // MARK: MESH RENDER
     void render() const override  {
         Node::render();
         
+        AttributeArray<MeshPoint> &vertexNormals = attributes.vertexNormals();
+        AttributeArray<MeshScalar> *vertexGaussianCurvature = nullptr;
+        if (showGaussianCurvatureHeatMap) {
+            vertexGaussianCurvature = &attributes.gaussianCurvature();
+            updateGaussianCurvatureLocalMinMax();
+        }
+        
         glEnable(GL_LIGHTING);
         glEnable(GL_DEPTH_TEST);
         glBegin(GL_TRIANGLES);
@@ -190,8 +211,8 @@ public:
                         case  1: color[0] = 1;   color[1] = 0;   color[2] = 0; break;
                         case -1: color[0] = 0;   color[1] = 1;   color[2] = 0; break;
                         case  0:
-                            color[0] = 0.7 + vertexGaussianCurvature[index] * 5;
-                            color[1] = 0.7 - vertexGaussianCurvature[index] * 5;
+                            color[0] = 0.7 + (*vertexGaussianCurvature)[index] * 5;
+                            color[1] = 0.7 - (*vertexGaussianCurvature)[index] * 5;
                             color[2] = 0.7;
                             break;
                     }
@@ -209,8 +230,8 @@ public:
                 }
                 glMaterialfv(GL_FRONT, GL_AMBIENT, color);
                 
-                glNormal3dv(vertexNormals[index].v);
-                glVertex3dv((*vertexIt)->point().v);
+                glNormalPoint(vertexNormals[index]);
+                glVertexPoint((*vertexIt)->point());
             }
         }
         glEnd();
@@ -222,77 +243,6 @@ public:
     
     
 private:
-    void computeBoundingBox() {
-        MeshVertexIterator it(mesh);
-        
-        Point min = (*it)->point();
-        Point max = (*it)->point();
-        
-        for (MeshVertexIterator it(mesh); !it.end(); ++it) {
-            min.v[0] = std::min(min.v[0], (*it)->point().v[0]);
-            min.v[1] = std::min(min.v[1], (*it)->point().v[1]);
-            min.v[2] = std::min(min.v[2], (*it)->point().v[2]);
-            
-            max.v[0] = std::max(max.v[0], (*it)->point().v[0]);
-            max.v[1] = std::max(max.v[1], (*it)->point().v[1]);
-            max.v[2] = std::max(max.v[2], (*it)->point().v[2]);
-        }
-        
-        bounds = new BoundingBox(min, max);
-    }
-    
-    // MARK: Compute angles
-    void computeHalfEdgeAngles() {
-        halfEdgeAngles.empty();
-        halfEdgeAngles.resize(mesh->numFaces() * 3);
-        
-        for (MeshHalfedgeIterator heit(mesh); !heit.end(); ++heit) {
-            Halfedge *he = (*heit);
-            Point u = he->target()->point() - he->source()->point();
-            he = he->ccw_rotate_about_source();
-            if (!he) continue; //
-            Point v = he->target()->point() - he->source()->point();
-            
-            halfEdgeAngles[he->index()] = acos((u * v) / (u.norm() * v.norm()));
-        }
-    }
-    
-    // MARK: Compute face normals
-    void computeFaceNormals()  {
-        faceNormals.empty();
-        faceNormals.resize(mesh->numFaces());
-        
-        for (MeshFaceIterator faceIt(mesh); !faceIt.end(); ++faceIt) {
-            Halfedge *he = (*faceIt)->he();
-            Point u = he->target()->point() - he->source()->point();
-            he = he->clw_rotate_about_source();
-            if (!he) continue; //
-            Point v = he->target()->point() - he->source()->point();
-            
-            Point normal = u ^ v;                      // cross product uv
-            normal /= normal.norm();                   // normalize
-            faceNormals[(*faceIt)->index()] = normal;  // memorize
-        }
-    }
-    
-    // MARK: Compute vertex normals
-    void computeVertexNormals() {
-        vertexNormals.clear();
-        vertexNormals.resize(mesh->numVertices());
-        
-        for (MeshVertexIterator veit(mesh); !veit.end(); ++veit) {
-            Point normal(0,0,0);
-            
-            for (VertexOutHalfedgeIterator heoit(*veit); !heoit.end(); ++heoit) {
-                Point weightedNormal = faceNormals[(*heoit)->face()->index()] * halfEdgeAngles[(*heoit)->index()];
-                normal += weightedNormal;
-            }
-            
-            normal /= normal.norm();                  // normalise
-            vertexNormals[(*veit)->index()] = normal; // memorise
-        }
-    }
-    
     // MARK: Compute Edge loops
     void computeBoundaryEdgeLoops() {
         boundaryEdgeLoops.empty();
@@ -322,56 +272,86 @@ private:
     }
     
     
-    // MARK: Compute gaussian curvature
-    void computeGaussianCurvature() {
-        const float tau = 2 * 3.14159265359;
-        
-        vertexGaussianCurvature.empty();
-        vertexGaussianCurvature.assign(mesh->numVertices(), tau);
-        
-        for (MeshHalfedgeIterator it(mesh); !it.end(); ++it) {
-            Halfedge *he = *it;
-            vertexGaussianCurvature[he->source()->index()] -= halfEdgeAngles[he->index()];
+    // MARK: Compute gaussian curvature extrema
+    /// Bring the extrema up to the current curvature: around the vertices the last update of the
+    /// attributes changed when the extrema are of the revision before it, everywhere otherwise
+    void updateGaussianCurvatureLocalMinMax() const {
+        AttributeArray<MeshScalar> &vertexGaussianCurvature = attributes.gaussianCurvature();
+        if (localMinMaxStamp == attributes.curvatureStamp()) return;
+        
+        listNeighbors();
+        const std::vector<int> *updated = attributes.updatedVertices(localMinMaxStamp);
+        if (updated == nullptr) {
+            parallelForVertices(*mesh, [&](Vertex *vertex) {
+                classifyGaussianCurvature(vertex, vertexGaussianCurvature);
+            });
+        } else {
+            // an extremum depends on the curvature of its neighbors too
+            for (int index : *updated) {
+                classifyGaussianCurvature(mesh->indVertex(index), vertexGaussianCurvature);
+                for (int n = neighborStart[index]; n < neighborStart[index + 1]; ++n) {
+                    classifyGaussianCurvature(mesh->indVertex(neighbors[n]), vertexGaussianCurvature);
+                }
+            }
         }
+        localMinMaxStamp = attributes.curvatureStamp();
     }
     
-    void computeGaussianCurvatureLocalMinMax() {
-        // compute local min-max
-        vertexGaussianCurvatureLocalMinMax.empty();
-        vertexGaussianCurvatureLocalMinMax.resize(mesh->numVertices());
+    void classifyGaussianCurvature(Vertex *vertex, AttributeArray<MeshScalar> &vertexGaussianCurvature) const {
+        int index = vertex->index();
+        const double threshold = 0.05;
+        double localCurvature = vertexGaussianCurvature[index];
         
-        for (MeshVertexIterator it(mesh); !it.end(); ++it) {
-            int index = (*it)->index();
-            const double threshold = 0.05;
-            double localCurvature = vertexGaussianCurvature[index];
-            
-            bool discard = false;
-            
-            if (abs(localCurvature) < threshold) {
+        bool discard = false;
+        
+        if (abs(localCurvature) < threshold) {
+            discard = true;
+        }
+        
+        else for (int n = neighborStart[index]; n < neighborStart[index + 1]; ++n) {
+            if (localCurvature > 0 && localCurvature < vertexGaussianCurvature[neighbors[n]]) {
                 discard = true;
-            }
+            };
             
-            else for (VertexOutHalfedgeIterator veit(*it); !veit.end(); ++veit) {
-                if (localCurvature > 0 && localCurvature < vertexGaussianCurvature[(*veit)->target()->index()]) {
-                    discard = true;
-                };
-                
-                if (localCurvature < 0 && localCurvature > vertexGaussianCurvature[(*veit)->target()->index()]) {
-                    discard = true;
-                };
-            }
-            
-            if (!discard) {
-                vertexGaussianCurvatureLocalMinMax[index] = localCurvature > 0 ? 1 : -1;
-            } else {
-                vertexGaussianCurvatureLocalMinMax[index] = 0;
-            }
+            if (localCurvature < 0 && localCurvature > vertexGaussianCurvature[neighbors[n]]) {
+                discard = true;
+            };
+        }
+        
+        if (!discard) {
+            vertexGaussianCurvatureLocalMinMax[index] = localCurvature > 0 ? 1 : -1;
+        } else {
+            vertexGaussianCurvatureLocalMinMax[index] = 0;
+        }
+    }
+    
+    void listNeighbors() const {
+        if (neighborsStamp == mesh->topologyRevision()) return;
+        
+        neighborStart.assign(mesh->numVertices() + 1, 0);
+        for (MeshEdgeIterator eit(mesh); !eit.end(); ++eit) {
+            neighborStart[(*eit)->he(0)->source()->index() + 1]++;
+            neighborStart[(*eit)->he(0)->target()->index() + 1]++;
+        }
+        for (int v = 0; v < mesh->numVertices(); v++) {
+            neighborStart[v + 1] += neighborStart[v];
         }
+        
+        neighbors.resize(neighborStart.back());
+        std::vector<int> next(neighborStart.begin(), neighborStart.end() - 1);
+        for (MeshEdgeIterator eit(mesh); !eit.end(); ++eit) {
+            int source = (*eit)->he(0)->source()->index();
+            int target = (*eit)->he(0)->target()->index();
+            neighbors[next[source]++] = target;
+            neighbors[next[target]++] = source;
+        }
+        neighborsStamp = mesh->topologyRevision();
     }
     
     void renderBoundingBox() const {
-        Point min = bounds->min;
-        Point max = bounds->max;
+        BoundingBox bounds = getBounds();
+        Point min = bounds.min;
+        Point max = bounds.max;
         
         Point boxVertices[8] {
             min,                                    // 0
@@ -405,6 +385,7 @@ private:
         glDisable(GL_LIGHTING);
         glEnable(GL_DEPTH_TEST);
         
+        AttributeArray<MeshPoint> &vertexNormals = attributes.vertexNormals();
         glBegin(GL_LINES);
         for (MeshEdgeIterator eit(mesh); !eit.end(); ++eit) {
             Vertex *source = (*eit)->he(0)->source();
@@ -412,9 +393,9 @@ private:
             
             // Render edge at a slight offset in front of the face to avoid Z-fighting, using the normal.
             glColor3f(0, 1, 1);
-            glVertex3dv((vertexNormals[source->index()] * -0.003 + source->point()).v);
+            glVertexPoint(vertexNormals[source->index()] * -0.003 + source->point());
             glColor3f(0, 0, 1);
-            glVertex3dv((vertexNormals[target->index()] * -0.003 + target->point()).v);
+            glVertexPoint(vertexNormals[target->index()] * -0.003 + target->point());
         }
         glEnd();
     }
@@ -432,8 +413,8 @@ private:
             glLineWidth(3.0);
             
             for (Halfedge *he: loop) {
-                glVertex3dv(he->source()->point().v);
-                glVertex3dv(he->target()->point().v);
+                glVertexPoint(he->source()->point());
+                glVertexPoint(he->target()->point());
             }
             glEnd();
         }
@@ -654,11 +635,17 @@ int main(int argc, char** argv) {
     scene->childrens.push_back(&origin);
     
     Object *lastAddedObject = nullptr;
+    bool useCache = false;
     for (int arg = 1; arg < argc; arg ++) {
         
+        if (strcmp(argv[arg], "-cache") == 0) {
+            useCache = true;
+            continue;
+        }
+        
         Mesh *mesh = new Mesh();
-        // try to load obj, and push into the scene
-        if (mesh->readOBJFile(argv[arg])) {
+        // try to load obj (through its binary cache with -cache), and push into the scene
+        if (mesh->readOBJFile(argv[arg], useCache)) {
             Object *object = new Object(mesh);
             scene->childrens.push_back(object);
             lastAddedObject = object;